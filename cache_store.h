@@ -0,0 +1,75 @@
+/** @file
+@brief Interface for keeping computed distortion data between runs
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Hash (64 bit FNV-1a) of everything a piece of derived data is computed
+// from. Doubles are hashed by their bits so any change at all is a new key.
+class CacheKey {
+public:
+	CacheKey(const char *kind, uint32_t version) : hash(14695981039346656037ULL)
+	{
+		add(kind, strlen(kind));
+		add(version);
+	}
+
+	CacheKey &add(const void *data, size_t size)
+	{
+		const unsigned char *bytes = (const unsigned char *)data;
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+		return *this;
+	}
+	CacheKey &add(double value) { return add(&value, sizeof(value)); }
+	CacheKey &add(int32_t value) { return add(&value, sizeof(value)); }
+	CacheKey &add(uint32_t value) { return add(&value, sizeof(value)); }
+
+	uint64_t value() const { return hash; }
+
+private:
+	uint64_t hash;
+};
+
+// Somewhere derived data (remap tables, meshes) can be kept between runs so
+// reopening a known config doesn't mean computing it all again. See
+// DistortionCache for the on disk version.
+class CacheStore {
+public:
+	virtual ~CacheStore() {}
+
+	// Data stored under key or null. The returned handle keeps data valid
+	// for as long as it is held so callers can use it in place.
+	virtual std::shared_ptr<const void> find(uint64_t key, const void *&data, size_t &size) = 0;
+
+	virtual void store(uint64_t key, const void *data, size_t size) = 0;
+};
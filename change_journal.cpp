@@ -0,0 +1,199 @@
+/** @file
+@brief Append only journal of state changes for crash recovery
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "change_journal.h"
+#include "cache_store.h"
+
+#include <chrono>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define JOURNAL_MAGIC 0x4a444d48	// "HMDJ"
+#define JOURNAL_VERSION 1
+
+namespace {
+
+	struct JournalHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t recordSize;
+		uint32_t reserved;
+	};
+
+	// In front of every record
+	struct RecordHeader {
+		uint32_t sequence;
+		uint32_t checksum;
+	};
+
+	uint32_t checksum(uint32_t sequence, const void *record, size_t size)
+	{
+		return (uint32_t)CacheKey("journal", sequence).add(record, size).value();
+	}
+
+	// Past the OS cache onto the disk
+	void syncFile(FILE *file)
+	{
+		fflush(file);
+#ifdef _WIN32
+		_commit(_fileno(file));
+#else
+		fsync(fileno(file));
+#endif
+	}
+}
+
+ChangeJournal::ChangeJournal(int syncInterval)
+	: file(0), recordSize(0), sequence(0), syncInterval(syncInterval), writing(false), flushRequested(false), quit(false)
+{
+	worker = std::thread([this] { run(); });
+}
+
+ChangeJournal::~ChangeJournal()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_one();
+	worker.join();
+	if (file)
+		fclose(file);
+}
+
+bool ChangeJournal::start(const QString &filename, size_t recordSize, QString &error)
+{
+	close();
+
+	FILE *opened = fopen(filename.toLocal8Bit().constData(), "wb");
+	if (!opened) {
+		error = QString("unable to create \"%1\"").arg(filename);
+		return false;
+	}
+
+	JournalHeader header = { JOURNAL_MAGIC, JOURNAL_VERSION, (uint32_t)recordSize, 0 };
+	fwrite(&header, sizeof(header), 1, opened);
+	syncFile(opened);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	file = opened;
+	this->recordSize = recordSize;
+	sequence = 0;
+	return true;
+}
+
+void ChangeJournal::close()
+{
+	if (!file)
+		return;
+	flush();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	fclose(file);
+	file = 0;
+}
+
+void ChangeJournal::append(const void *record)
+{
+	if (!file)
+		return;
+
+	RecordHeader header = { sequence, checksum(sequence, record, recordSize) };
+	sequence++;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	buffer.insert(buffer.end(), (const char *)&header, (const char *)&header + sizeof(header));
+	buffer.insert(buffer.end(), (const char *)record, (const char *)record + recordSize);
+}
+
+void ChangeJournal::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	flushRequested = true;
+	wake.notify_one();
+	idle.wait(lock, [this] { return buffer.empty() && !writing; });
+}
+
+void ChangeJournal::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		wake.wait_for(lock, std::chrono::milliseconds(syncInterval), [this] { return quit || flushRequested; });
+
+		if (!buffer.empty() && file) {
+			std::vector<char> data;
+			data.swap(buffer);
+			FILE *target = file;
+			writing = true;
+			lock.unlock();
+
+			fwrite(&data[0], 1, data.size(), target);
+			syncFile(target);
+
+			lock.lock();
+			writing = false;
+		}
+		else if (!file) {
+			buffer.clear();
+		}
+
+		// Anything appended while writing goes out on the next pass
+		if (buffer.empty()) {
+			flushRequested = false;
+			idle.notify_all();
+		}
+
+		if (quit)
+			break;
+	}
+}
+
+int ChangeJournal::read(const QString &filename, size_t recordSize, std::vector<char> &last)
+{
+	FILE *file = fopen(filename.toLocal8Bit().constData(), "rb");
+	if (!file)
+		return 0;
+
+	JournalHeader header;
+	int count = 0;
+	if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == JOURNAL_MAGIC
+		&& header.version == JOURNAL_VERSION && header.recordSize == recordSize) {
+		std::vector<char> record(recordSize);
+		RecordHeader recordHeader;
+		while (fread(&recordHeader, sizeof(recordHeader), 1, file) == 1 && fread(&record[0], recordSize, 1, file) == 1
+			&& recordHeader.sequence == (uint32_t)count && recordHeader.checksum == checksum(recordHeader.sequence, &record[0], recordSize)) {
+			last = record;
+			count++;
+		}
+	}
+	fclose(file);
+	return count;
+}
@@ -0,0 +1,76 @@
+/** @file
+@brief Append only journal of state changes for crash recovery
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include <QString>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+// Binary journal of fixed size records, one per change, so a crash loses at
+// most the last second of work. append() only copies the record into a
+// buffer, a worker thread writes the buffer out and syncs it to disk every
+// syncInterval milliseconds. Each record carries a sequence number and a
+// checksum so a record torn by a crash is simply where reading stops.
+class ChangeJournal {
+public:
+	ChangeJournal(int syncInterval);
+	~ChangeJournal();	// Writes out and syncs whatever is buffered
+
+	// Start an empty journal in filename, replacing anything that was there
+	bool start(const QString &filename, size_t recordSize, QString &error);
+	void close();
+	bool active() const { return file != 0; }
+
+	void append(const void *record);
+
+	// Write out and sync everything appended so far
+	void flush();
+
+	// Number of intact records in a journal, with the newest in last. 0 if
+	// there's no journal or it's for records of a different size.
+	static int read(const QString &filename, size_t recordSize, std::vector<char> &last);
+
+private:
+	void run();
+
+	std::mutex mutex;
+	std::condition_variable wake;		// Flush requested or quitting
+	std::condition_variable idle;		// Buffer written out
+	std::vector<char> buffer;
+	FILE *file;
+	size_t recordSize;
+	uint32_t sequence;
+	int syncInterval;
+	bool writing;
+	bool flushRequested;
+	bool quit;
+	std::thread worker;
+};
@@ -0,0 +1,477 @@
+/** @file
+@brief Apply an edit script to many configs at once
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "config_edit.h"
+#include "csv_reader.h"
+#include "lens_config.h"
+#include "parallel_for.h"
+#include "rapidjson/error/en.h"
+#include "rapidjson/reader.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+#include <QSaveFile>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <math.h>
+#include <sstream>
+#include <string.h>
+
+namespace {
+
+	const char *sections[3] = { "distortion", "distortion_blue", "distortion_red" };	// Green, Blue, Red
+
+	// Comma separated names or "all"
+	template <typename Parse>
+	bool parseList(const std::string &field, bool *selected, int count, Parse parse)
+	{
+		for (int i = 0; i < count; i++)
+			selected[i] = field == "all";
+		if (field == "all")
+			return true;
+
+		std::stringstream stream(field);
+		std::string name;
+		while (std::getline(stream, name, ',')) {
+			int index;
+			if (!parse(name, index) || index < 0 || index >= count)
+				return false;
+			selected[index] = true;
+		}
+		return true;
+	}
+
+	bool parseEyes(const std::string &field, bool eyes[2])
+	{
+		int eye;
+		eyes[0] = eyes[1] = field == "both";
+		if (field == "both")
+			return true;
+		if (!parseLensEye(field.c_str(), eye))
+			return false;
+		eyes[eye] = true;
+		return true;
+	}
+
+	// Where each number is in the text of a config, by its path from the root
+	// such as /tracking_to_eye_transform/0/intrinsics/1/2
+	struct Span {
+		size_t begin, end;
+	};
+
+	class NumberFinder : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, NumberFinder> {
+	public:
+		NumberFinder(const char *text, rapidjson::StringStream &stream, std::map<std::string, Span> &numbers)
+			: text(text), stream(stream), numbers(numbers) {}
+
+		bool Null() { return next(); }
+		bool Bool(bool) { return next(); }
+		bool Int(int) { return number(); }
+		bool Uint(unsigned) { return number(); }
+		bool Int64(int64_t) { return number(); }
+		bool Uint64(uint64_t) { return number(); }
+		bool Double(double) { return number(); }
+		bool String(const char *, rapidjson::SizeType, bool) { return next(); }
+		bool StartObject() { return open(false); }
+		bool Key(const char *name, rapidjson::SizeType length, bool) { frames.back().key.assign(name, length); return true; }
+		bool EndObject(rapidjson::SizeType) { return close(); }
+		bool StartArray() { return open(true); }
+		bool EndArray(rapidjson::SizeType) { return close(); }
+
+	private:
+		struct Frame {
+			bool array;
+			int index;
+			std::string key;
+		};
+
+		bool number()
+		{
+			// The reader has just gone past the last character of the number
+			Span span;
+			span.end = stream.Tell();
+			span.begin = span.end;
+			while (span.begin > 0 && strchr("0123456789+-.eE", text[span.begin - 1]))
+				span.begin--;
+
+			std::string path;
+			for (const Frame &frame : frames)
+				path += "/" + (frame.array ? std::to_string(frame.index) : frame.key);
+			numbers[path] = span;
+			return next();
+		}
+
+		bool next()
+		{
+			if (!frames.empty() && frames.back().array)
+				frames.back().index++;
+			return true;
+		}
+
+		bool open(bool array)
+		{
+			Frame frame = { array, 0, std::string() };
+			frames.push_back(frame);
+			return true;
+		}
+
+		bool close()
+		{
+			frames.pop_back();
+			return next();
+		}
+
+		const char *text;
+		rapidjson::StringStream &stream;
+		std::map<std::string, Span> &numbers;
+		std::vector<Frame> frames;
+	};
+
+	// Shortest text that reads back as exactly value, the same the save uses
+	std::string formatNumber(double value)
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		writer.Double(value);
+		return std::string(buffer.GetString(), buffer.GetSize());
+	}
+
+	bool sameModel(const LensModel &a, const LensModel &b)
+	{
+		return memcmp(a.types, b.types, sizeof(a.types)) == 0 && memcmp(a.coeffs, b.coeffs, sizeof(a.coeffs)) == 0
+			&& memcmp(a.intrinsics, b.intrinsics, sizeof(a.intrinsics)) == 0 && memcmp(a.extrinsics, b.extrinsics, sizeof(a.extrinsics)) == 0;
+	}
+
+	bool readModel(const std::string &text, LensModel &model, std::string &error)
+	{
+		std::vector<char> buffer(text.begin(), text.end());
+		buffer.push_back(0);
+		rapidjson::Document json;
+		memset(&model, 0, sizeof(model));
+		return parseConfigBuffer(buffer, json, error) && readLensModel(json, model, error);
+	}
+
+	bool editConfig(const std::string &filename, const std::vector<ConfigEdit> &edits, int width, int height,
+		bool dryRun, ConfigEditResult &result)
+	{
+		std::ifstream file(filename.c_str(), std::ios::binary);
+		if (!file) {
+			result.error = "unable to open the file";
+			return false;
+		}
+		std::stringstream contents;
+		contents << file.rdbuf();
+		std::string text = contents.str();
+
+		LensModel before, after;
+		if (!readModel(text, before, result.error))
+			return false;
+		before.width = width;
+		before.height = height;
+		after = before;
+		if (!applyConfigEdits(edits, after, result.error))
+			return false;
+
+		std::string patched;
+		if (!patchConfigText(text, before, after, patched, result.changed, result.error))
+			return false;
+
+		// What gets written has to read back as exactly the edited model
+		LensModel check;
+		if (!readModel(patched, check, result.error) || !sameModel(check, after)) {
+			result.error = "the edited config doesn't read back the same, nothing was written";
+			return false;
+		}
+
+		if (result.changed == 0 || dryRun)
+			return true;
+
+		QSaveFile output(QString::fromLocal8Bit(filename.c_str()));
+		if (!output.open(QIODevice::WriteOnly) || output.write(patched.data(), patched.size()) != (qint64)patched.size()) {
+			output.cancelWriting();
+			result.error = "unable to write the file";
+			return false;
+		}
+		if (!output.commit()) {
+			result.error = output.errorString().toLocal8Bit().constData();
+			return false;
+		}
+		return true;
+	}
+}
+
+bool parseEdit(const std::string &text, ConfigEdit &edit, std::string &error)
+{
+	std::stringstream stream(text);
+	std::vector<std::string> fields;
+	std::string field;
+	while (stream >> field)
+		fields.push_back(field);
+
+	int line = edit.line;
+	memset(&edit, 0, sizeof(edit));
+	edit.line = line;
+	const std::string name = fields.empty() ? std::string() : fields[0];
+	bool ok = fields.size() >= 2 && parseEyes(fields[1], edit.eyes);
+
+	if (name == "scale" || name == "offset" || name == "set") {
+		edit.operation = name == "scale" ? ConfigEdit::SCALE : name == "offset" ? ConfigEdit::OFFSET : ConfigEdit::SET;
+		ok = ok && fields.size() == 5
+			&& parseList(fields[2], edit.colors, 3, [](const std::string &value, int &index) {
+				return parseLensColor(value.c_str(), index);
+			})
+			&& parseList(fields[3], edit.terms, LENS_MAX_TERMS, [](const std::string &value, int &index) {
+				double term;
+				bool valid = csvNumber(value, term) && term == (int)term;
+				index = (int)term - 1;
+				return valid;
+			})
+			&& csvNumber(fields[4], edit.values[0]);
+
+		// "all" means every coefficient the type of each color has
+		if (fields.size() == 5 && fields[3] == "all")
+			memset(edit.terms, 0, sizeof(edit.terms));
+	}
+	else if (name == "center") {
+		edit.operation = ConfigEdit::CENTER;
+		ok = ok && fields.size() == 4 && csvNumber(fields[2], edit.values[0]) && csvNumber(fields[3], edit.values[1]);
+	}
+	else if (name == "aspect" && fields.size() == 3 && fields[2] == "reset") {
+		edit.operation = ConfigEdit::ASPECT_RESET;
+	}
+	else if (name == "aspect") {
+		edit.operation = ConfigEdit::ASPECT;
+		ok = ok && fields.size() == 4 && csvNumber(fields[2], edit.values[0]) && csvNumber(fields[3], edit.values[1]);
+	}
+	else if (name == "intrinsic") {
+		edit.operation = ConfigEdit::INTRINSIC;
+		double row, column;
+		ok = ok && fields.size() == 5 && csvNumber(fields[2], row) && csvNumber(fields[3], column) && csvNumber(fields[4], edit.values[0])
+			&& row == (int)row && column == (int)column && row >= 1 && row <= 3 && column >= 1 && column <= 3;
+		edit.row = (int)row - 1;
+		edit.column = (int)column - 1;
+	}
+	else {
+		ok = false;
+	}
+
+	if (!ok)
+		error = "expected scale/offset/set <eyes> <colors> <coefficients> <value>,"
+			" center <eyes> <dx> <dy>, aspect <eyes> <x> <y>|reset or intrinsic <eyes> <row> <column> <value>";
+	return ok;
+}
+
+bool loadEditScript(const std::string &filename, std::vector<ConfigEdit> &edits, std::string &error)
+{
+	std::ifstream file(filename.c_str());
+	if (!file) {
+		error = "Unable to open " + filename;
+		return false;
+	}
+
+	edits.clear();
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		std::string trimmed = csvTrim(line);
+		if (trimmed.empty() || trimmed[0] == '#')
+			continue;
+
+		ConfigEdit edit;
+		edit.line = lineNumber;
+		std::string expected;
+		if (!parseEdit(trimmed, edit, expected)) {
+			std::stringstream msg;
+			msg << filename << ":" << lineNumber << ": " << expected;
+			error = msg.str();
+			return false;
+		}
+		edits.push_back(edit);
+	}
+
+	if (edits.empty()) {
+		error = filename + " does not contain any edits";
+		return false;
+	}
+	return true;
+}
+
+bool applyConfigEdits(const std::vector<ConfigEdit> &edits, LensModel &model, std::string &error)
+{
+	for (const ConfigEdit &edit : edits) {
+		for (int eye = 0; eye < 2; eye++) {
+			if (!edit.eyes[eye])
+				continue;
+			double (&intrinsics)[3][3] = model.intrinsics[eye];
+
+			switch (edit.operation) {
+			case ConfigEdit::CENTER:
+				// Relative to the center of each eye on the full panel, the way
+				// lensCenterOfProjection() reads them back
+				intrinsics[0][2] += edit.values[0] / (eye == 0 ? model.width / 4 : model.width / 2 + model.width / 4);
+				intrinsics[1][2] += edit.values[1] / (model.height / 2);
+				continue;
+			case ConfigEdit::ASPECT:
+				intrinsics[0][0] = edit.values[0];
+				intrinsics[1][1] = edit.values[1];
+				continue;
+			case ConfigEdit::INTRINSIC:
+				intrinsics[edit.row][edit.column] = edit.values[0];
+				continue;
+			case ConfigEdit::ASPECT_RESET:
+				// Same defaults as adjustAspectRatio(-2, -2)
+				intrinsics[0][0] = model.height / 1000.0;
+				intrinsics[1][1] = model.width / 1000.0 / 2;
+				continue;
+			default:
+				break;
+			}
+
+			for (int color = 0; color < 3; color++) {
+				if (!edit.colors[color])
+					continue;
+				const DistortionType &type = distortionType(model.types[eye][color]);
+				bool all = std::find(edit.terms, edit.terms + LENS_MAX_TERMS, true) == edit.terms + LENS_MAX_TERMS;
+
+				for (int term = 0; term < LENS_MAX_TERMS; term++) {
+					if (!all && !edit.terms[term])
+						continue;
+					std::stringstream where;
+					where << "line " << edit.line << ": " << lensEyeName(eye) << " " << lensColorName(color) << " coefficient " << term + 1;
+					if (term >= type.terms) {
+						if (all)
+							break;
+						error = where.str() + " doesn't exist for " + type.name;
+						return false;
+					}
+
+					double &value = model.coeffs[eye][color][term];
+					if (edit.operation == ConfigEdit::SCALE)
+						value *= edit.values[0];
+					else if (edit.operation == ConfigEdit::OFFSET)
+						value += edit.values[0];
+					else
+						value = edit.values[0];
+
+					if (fabs(value) > 1) {
+						error = where.str() + " would be outside -1 <= X <= 1";
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool patchConfigText(const std::string &text, const LensModel &before, const LensModel &after,
+	std::string &patched, int &changed, std::string &error)
+{
+	// Find every number without building a document, a BOM is skipped like the load does
+	size_t skip = text.compare(0, 3, "\xEF\xBB\xBF") == 0 ? 3 : 0;
+	const char *start = text.c_str() + skip;
+	std::map<std::string, Span> numbers;
+	rapidjson::StringStream stream(start);
+	NumberFinder finder(start, stream, numbers);
+	rapidjson::Reader reader;
+	if (!reader.Parse<rapidjson::kParseDefaultFlags>(stream, finder)) {
+		std::stringstream msg;
+		msg << rapidjson::GetParseError_En(reader.GetParseErrorCode()) << " (at byte " << reader.GetErrorOffset() + skip << ")";
+		error = msg.str();
+		return false;
+	}
+
+	std::vector<std::pair<Span, std::string> > replacements;
+	auto replace = [&](const std::string &path, double from, double to, bool optional) {
+		if (from == to)
+			return true;
+		std::map<std::string, Span>::const_iterator found = numbers.find(path);
+		if (found == numbers.end()) {
+			if (optional)
+				return true;
+			error = "no number at " + path;
+			return false;
+		}
+		Span span = found->second;
+		span.begin += skip;
+		span.end += skip;
+		replacements.push_back(std::make_pair(span, formatNumber(to)));
+		return true;
+	};
+
+	for (int eye = 0; eye < 2; eye++) {
+		std::string transform = "/tracking_to_eye_transform/" + std::to_string(eye);
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				if (!replace(transform + "/intrinsics/" + std::to_string(row) + "/" + std::to_string(col),
+					before.intrinsics[eye][row][col], after.intrinsics[eye][row][col], false))
+					return false;
+
+		for (int color = 0; color < 3; color++) {
+			std::string section = transform + "/" + sections[color];
+			for (int term = 0; term < distortionType(after.types[eye][color]).terms; term++)
+				if (!replace(section + "/coeffs/" + std::to_string(term), before.coeffs[eye][color][term], after.coeffs[eye][color][term], false))
+					return false;
+
+			// A save keeps these matching the center in the intrinsics
+			replace(section + "/center_x", before.intrinsics[eye][0][2], after.intrinsics[eye][0][2], true);
+			replace(section + "/center_y", before.intrinsics[eye][1][2], after.intrinsics[eye][1][2], true);
+		}
+	}
+
+	std::sort(replacements.begin(), replacements.end(),
+		[](const std::pair<Span, std::string> &a, const std::pair<Span, std::string> &b) { return a.first.begin < b.first.begin; });
+
+	patched.clear();
+	patched.reserve(text.size() + replacements.size() * 8);
+	size_t position = 0;
+	for (const std::pair<Span, std::string> &replacement : replacements) {
+		patched.append(text, position, replacement.first.begin - position);
+		patched += replacement.second;
+		position = replacement.first.end;
+	}
+	patched.append(text, position, std::string::npos);
+	changed = (int)replacements.size();
+	return true;
+}
+
+std::vector<ConfigEditResult> editConfigs(const std::vector<std::string> &filenames, const std::vector<ConfigEdit> &edits,
+	int width, int height, bool dryRun)
+{
+	std::vector<ConfigEditResult> results(filenames.size());
+	parallelFor((int)filenames.size(), [&](int begin, int end, int) {
+		for (int i = begin; i < end; i++) {
+			ConfigEditResult &result = results[i];
+			result.filename = filenames[i];
+			result.changed = 0;
+			result.ok = editConfig(filenames[i], edits, width, height, dryRun, result);
+		}
+	});
+	return results;
+}
@@ -0,0 +1,84 @@
+/** @file
+@brief Apply an edit script to many configs at once
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include "lens_model.h"
+#include <string>
+#include <vector>
+
+// One line of an edit script. See loadEditScript() for the syntax.
+struct ConfigEdit {
+	enum Operation { SCALE, OFFSET, SET, CENTER, ASPECT, ASPECT_RESET, INTRINSIC };
+
+	Operation operation;
+	bool eyes[2];
+	bool colors[3];						// LensColor
+	bool terms[LENS_MAX_TERMS];			// Coefficients, all false means every one the type has
+	int row, column;					// INTRINSIC
+	double values[2];
+	int line;
+};
+
+struct ConfigEditResult {
+	std::string filename;
+	bool ok;
+	int changed;		// Values that are different now
+	std::string error;
+};
+
+// Read an edit script, one edit per line applied in order:
+//    scale  <eyes> <colors> <coefficients> <factor>
+//    offset <eyes> <colors> <coefficients> <amount>
+//    set    <eyes> <colors> <coefficients> <value>
+//    center <eyes> <dx> <dy>		Move the center in the intrinsics by pixels (x right, y up)
+//    aspect <eyes> <x> <y>			Set the aspect ratio in the intrinsics
+//    aspect <eyes> reset			The default aspect ratio for the panel, like J in the tool
+//    intrinsic <eyes> <row> <column> <value>	Set one value of the 3x3 intrinsics (1 to 3)
+// eyes is left, right or both. colors is green, blue, red or all and
+// coefficients is 1 to 6 or all, both also take comma separated lists
+// (green,red or 1,2). Blank lines and lines starting with # are skipped.
+bool loadEditScript(const std::string &filename, std::vector<ConfigEdit> &edits, std::string &error);
+
+// Parse a single edit, edit.line is kept. The error says what was expected.
+bool parseEdit(const std::string &text, ConfigEdit &edit, std::string &error);
+
+// Apply edits to a model, failing if a coefficient would end up outside the
+// -1 <= X <= 1 range SteamVR accepts or doesn't exist for the distortion type.
+bool applyConfigEdits(const std::vector<ConfigEdit> &edits, LensModel &model, std::string &error);
+
+// Rewrite the numbers in the text of a config that differ between before and
+// after and leave every other byte as it is, so a diff of the file only shows
+// what was edited. changed is the number of values rewritten.
+bool patchConfigText(const std::string &text, const LensModel &before, const LensModel &after,
+	std::string &patched, int &changed, std::string &error);
+
+// Load, edit, patch and write back each config, spread over the worker
+// threads. The panel size is what "aspect reset" uses. Files are replaced
+// atomically and only if something changed, a file that fails is left alone.
+// With dryRun nothing is written.
+std::vector<ConfigEditResult> editConfigs(const std::vector<std::string> &filenames, const std::vector<ConfigEdit> &edits,
+	int width, int height, bool dryRun);
@@ -0,0 +1,135 @@
+/** @file
+@brief Write config files on a background thread
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "config_saver.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+
+#include <QSaveFile>
+
+ConfigSaver::ConfigSaver()
+	: writing(false), quit(false)
+{
+	worker = std::thread([this] { run(); });
+}
+
+ConfigSaver::~ConfigSaver()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_one();
+	worker.join();
+}
+
+void ConfigSaver::save(const QString &filename, const rapidjson::Document &json)
+{
+	// The copy is all the GUI thread pays for, a config is only a few KB
+	std::shared_ptr<rapidjson::Document> copy(new rapidjson::Document);
+	copy->CopyFrom(json, copy->GetAllocator());
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		bool replaced = false;
+		for (Pending &entry : pending) {
+			if (entry.filename == filename) {
+				entry.json = copy;
+				replaced = true;
+			}
+		}
+		if (!replaced) {
+			Pending entry = { filename, copy };
+			pending.push_back(entry);
+		}
+	}
+	wake.notify_one();
+}
+
+void ConfigSaver::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this] { return pending.empty() && !writing; });
+}
+
+std::vector<ConfigSaveResult> ConfigSaver::finished()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<ConfigSaveResult> done;
+	done.swap(results);
+	return done;
+}
+
+void ConfigSaver::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		wake.wait(lock, [this] { return quit || !pending.empty(); });
+		// Whatever is queued still gets written when quitting
+		if (pending.empty())
+			break;
+
+		Pending entry = pending.front();
+		pending.erase(pending.begin());
+		writing = true;
+		lock.unlock();
+
+		ConfigSaveResult result;
+		result.filename = entry.filename;
+		result.ok = write(entry.filename, *entry.json, result.error);
+
+		lock.lock();
+		writing = false;
+		results.push_back(result);
+		if (pending.empty())
+			idle.notify_all();
+	}
+}
+
+bool ConfigSaver::write(const QString &filename, const rapidjson::Document &json, QString &error)
+{
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+	json.Accept(writer);
+
+	// Goes to a temporary file next to the config that only replaces it on commit()
+	QSaveFile file(filename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		error = file.errorString();
+		return false;
+	}
+	if (file.write(buffer.GetString(), buffer.GetSize()) != (qint64)buffer.GetSize()) {
+		error = file.errorString();
+		file.cancelWriting();
+		return false;
+	}
+	if (!file.commit()) {
+		error = file.errorString();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,79 @@
+/** @file
+@brief Write config files on a background thread
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include "rapidjson/document.h"
+#include <QString>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ConfigSaveResult {
+	QString filename;
+	bool ok;
+	QString error;
+};
+
+// Pretty prints and writes config files on a worker thread so saving never
+// holds up a frame. save() only takes a copy of the document. Each file is
+// written to a temporary name and renamed over the old one once it's
+// complete, so a crash mid-write leaves the previous config intact. If the
+// same file is saved again before the worker gets to it only the newest copy
+// is written.
+class ConfigSaver {
+public:
+	ConfigSaver();
+	~ConfigSaver();		// Finishes everything that's queued
+
+	void save(const QString &filename, const rapidjson::Document &json);
+
+	// Wait until everything queued so far is on disk
+	void flush();
+
+	// Saves finished since the last call, meant to be polled from the GUI thread
+	std::vector<ConfigSaveResult> finished();
+
+private:
+	struct Pending {
+		QString filename;
+		std::shared_ptr<rapidjson::Document> json;
+	};
+
+	void run();
+	static bool write(const QString &filename, const rapidjson::Document &json, QString &error);
+
+	std::mutex mutex;
+	std::condition_variable wake;		// Something was queued or it's time to quit
+	std::condition_variable idle;		// The queue drained
+	std::vector<Pending> pending;
+	std::vector<ConfigSaveResult> results;
+	bool writing;
+	bool quit;
+	std::thread worker;
+};
@@ -0,0 +1,175 @@
+/** @file
+@brief Index of the configs for many headsets kept in one folder
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "config_store.h"
+#include "csv_reader.h"
+#include "lens_config.h"
+#include "parallel_for.h"
+
+#include <QSaveFile>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <stdio.h>
+
+#define INDEX_FILE "index.csv"
+
+namespace {
+
+	// Commas would split the field when the index is read back
+	QString indexField(const QString &value)
+	{
+		QString field = value;
+		return field.replace(',', ' ').trimmed();
+	}
+}
+
+ConfigStore::ConfigStore(const QString &directory)
+	: directory(directory)
+{
+}
+
+void ConfigStore::readIndex()
+{
+	configs.clear();
+	std::ifstream file(QDir(directory).filePath(INDEX_FILE).toLocal8Bit().constData());
+	std::string line;
+	std::vector<std::string> fields;
+	while (std::getline(file, line)) {
+		double size, modified;
+		if (!csvSplit(line, fields) || fields.size() != 5 || !csvNumber(fields[2], size) || !csvNumber(fields[3], modified))
+			continue;
+
+		StoredConfig config;
+		config.serial = QString::fromUtf8(fields[0].c_str());
+		config.model = QString::fromUtf8(fields[1].c_str());
+		config.size = (qint64)size;
+		config.modified = (qint64)modified;
+		config.filename = QDir(directory).filePath(QString::fromUtf8(fields[4].c_str()));
+		configs.push_back(config);
+	}
+}
+
+void ConfigStore::writeIndex() const
+{
+	QSaveFile file(QDir(directory).filePath(INDEX_FILE));
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return;
+
+	QString contents = "# serial, model, size, modified, file\n";
+	for (const StoredConfig &config : configs) {
+		contents += QString("%1, %2, %3, %4, %5\n").arg(indexField(config.serial), indexField(config.model))
+			.arg(config.size).arg(config.modified).arg(indexField(QFileInfo(config.filename).fileName()));
+	}
+	file.write(contents.toUtf8());
+	if (!file.commit())
+		printf("ERROR: Unable to write \"%s\"\n", QDir(directory).filePath(INDEX_FILE).toLocal8Bit().constData());
+}
+
+int ConfigStore::refresh()
+{
+	if (!indexRead) {
+		readIndex();
+		indexRead = true;
+	}
+
+	std::map<QString, StoredConfig> indexed;
+	for (const StoredConfig &config : configs)
+		indexed[QFileInfo(config.filename).fileName()] = config;
+
+	// Whatever is still current comes straight from the index, the rest is parsed
+	std::vector<StoredConfig> current, stale;
+	QFileInfoList files = QDir(directory).entryInfoList(QStringList() << "*.json", QDir::Files, QDir::Name);
+	for (const QFileInfo &info : files) {
+		if (info.fileName().endsWith(CONFIG_AUTOSAVE_SUFFIX))
+			continue;
+
+		StoredConfig config;
+		config.filename = info.filePath();
+		config.size = info.size();
+		config.modified = info.lastModified().toMSecsSinceEpoch();
+
+		std::map<QString, StoredConfig>::iterator found = indexed.find(info.fileName());
+		if (found != indexed.end() && found->second.size == config.size && found->second.modified == config.modified) {
+			current.push_back(found->second);
+			current.back().filename = config.filename;
+			indexed.erase(found);
+		}
+		else if (rejected.count(config.filename) == 0 || rejected[config.filename] != config.modified) {
+			stale.push_back(config);
+		}
+	}
+	bool changed = !indexed.empty() || !stale.empty();
+
+	// Only the serial and model are kept, the parse just makes sure it's a config worth listing
+	std::vector<std::string> names(stale.size()), serials(stale.size()), models(stale.size()), errors(stale.size());
+	for (size_t i = 0; i < stale.size(); i++)
+		names[i] = stale[i].filename.toLocal8Bit().constData();
+	parallelFor((int)stale.size(), [&](int begin, int end, int) {
+		for (int i = begin; i < end; i++) {
+			std::vector<char> buffer;
+			rapidjson::Document json;
+			if (!parseConfigFile(names[i], buffer, json, errors[i]))
+				continue;
+			if (json.HasMember("device_serial_number") && json["device_serial_number"].IsString())
+				serials[i] = json["device_serial_number"].GetString();
+			if (json.HasMember("model_number") && json["model_number"].IsString())
+				models[i] = json["model_number"].GetString();
+		}
+	});
+
+	for (size_t i = 0; i < stale.size(); i++) {
+		if (!errors[i].empty()) {
+			// Not reported again until the file changes
+			rejected[stale[i].filename] = stale[i].modified;
+			printf("ERROR: \"%s\" is not a valid config file: %s\n", names[i].c_str(), errors[i].c_str());
+			continue;
+		}
+		StoredConfig &config = stale[i];
+		config.serial = serials[i].empty() ? QFileInfo(config.filename).completeBaseName() : QString::fromUtf8(serials[i].c_str());
+		config.model = QString::fromUtf8(models[i].c_str());
+		current.push_back(config);
+	}
+
+	std::sort(current.begin(), current.end(), [](const StoredConfig &a, const StoredConfig &b) {
+		return a.serial < b.serial || (a.serial == b.serial && a.filename < b.filename);
+	});
+	configs.swap(current);
+
+	if (changed)
+		writeIndex();
+	return (int)configs.size();
+}
+
+int ConfigStore::find(const QString &serialOrFilename) const
+{
+	QString path = QFileInfo(serialOrFilename).absoluteFilePath();
+	for (size_t i = 0; i < configs.size(); i++)
+		if (configs[i].serial == serialOrFilename || QFileInfo(configs[i].filename).absoluteFilePath() == path)
+			return (int)i;
+	return -1;
+}
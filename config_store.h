@@ -0,0 +1,101 @@
+/** @file
+@brief Index of the configs for many headsets kept in one folder
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include <QDir>
+#include <QFileInfo>
+#include <QString>
+#include <map>
+#include <vector>
+
+// Unsaved values for a config are autosaved next to it with this in place of ".json"
+#define CONFIG_AUTOSAVE_SUFFIX ".autosave.json"
+
+inline QString configAutosaveFile(const QString &config)
+{
+	QFileInfo info(config);
+	return QDir(info.path()).filePath(info.completeBaseName() + CONFIG_AUTOSAVE_SUFFIX);
+}
+
+// Changes since the last save are journaled next to the config with this in place of ".json"
+#define CONFIG_JOURNAL_SUFFIX ".journal"
+
+inline QString configJournalFile(const QString &config)
+{
+	QFileInfo info(config);
+	return QDir(info.path()).filePath(info.completeBaseName() + CONFIG_JOURNAL_SUFFIX);
+}
+
+// The distortion mesh exported for a config goes next to it with this in place of ".json"
+#define CONFIG_MESH_SUFFIX ".mesh"
+
+inline QString configMeshFile(const QString &config)
+{
+	QFileInfo info(config);
+	return QDir(info.path()).filePath(info.completeBaseName() + CONFIG_MESH_SUFFIX);
+}
+
+// One headset in the store
+struct StoredConfig {
+	QString serial;			// "device_serial_number" from the config, the file name if it has none
+	QString model;			// "model_number" from the config, may be empty
+	QString filename;		// Path of the config
+	qint64 size;			// Size and modification time of the file when it was indexed,
+	qint64 modified;		// a change to either means it's read again
+};
+
+// A folder with a config per headset (lighthouse_console dumps or saves from
+// this tool), indexed by the serial and model inside each one. The index is
+// kept in <directory>/index.csv so listing and looking up headsets doesn't
+// mean parsing every config, refresh() only reads files that are new or have
+// changed since. The configs themselves are left alone until one is picked.
+class ConfigStore {
+public:
+	ConfigStore(const QString &directory);
+
+	// Bring the index up to date with the folder and rewrite index.csv if
+	// anything changed. Files that aren't valid configs are reported and left
+	// out. Returns the number of headsets.
+	int refresh();
+
+	// Sorted by serial
+	const std::vector<StoredConfig> &entries() const { return configs; }
+
+	// Index of the entry for a serial or config file, -1 if there isn't one
+	int find(const QString &serialOrFilename) const;
+
+	const QString &folder() const { return directory; }
+
+private:
+	void readIndex();
+	void writeIndex() const;
+
+	QString directory;
+	std::vector<StoredConfig> configs;
+	std::map<QString, qint64> rejected;		// Files that aren't configs and when they were last modified
+	bool indexRead = false;
+};
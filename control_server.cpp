@@ -0,0 +1,141 @@
+/** @file
+@brief Local socket other programs drive the tool through
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "control_server.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+#define CONTROL_MAX_LINE (1024 * 1024)		// Bytes, a client sending more without a newline is dropped
+
+namespace {
+
+	// A request line or header of HTTP, which no client of ours sends
+	bool looksLikeHttp(const QByteArray &line)
+	{
+		static const char *methods[] = { "GET ", "POST ", "PUT ", "HEAD ", "OPTIONS ", "DELETE ", "PATCH ", "CONNECT ", "TRACE " };
+		for (const char *method : methods)
+			if (line.startsWith(method))
+				return true;
+		return line.contains(" HTTP/") || line.toLower().startsWith("host:");
+	}
+}
+
+ControlServer::ControlServer()
+	: nextClient(1)
+{
+	QObject::connect(&server, &QLocalServer::newConnection, &server, [this] { accept(); });
+}
+
+ControlServer::~ControlServer()
+{
+	for (auto &client : clients)
+		delete client.second;
+}
+
+bool ControlServer::listen(const QString &name, QString &error)
+{
+	// Left behind by a crash on anything but Windows
+	QLocalServer::removeServer(name);
+	server.setSocketOptions(QLocalServer::UserAccessOption);
+	if (!server.listen(name)) {
+		error = server.errorString();
+		return false;
+	}
+	return true;
+}
+
+void ControlServer::setNotify(std::function<void()> notify)
+{
+	this->notify = notify;
+}
+
+std::vector<ControlRequest> ControlServer::take()
+{
+	std::vector<ControlRequest> requests;
+	requests.swap(pending);
+	return requests;
+}
+
+void ControlServer::reply(int client, const std::string &text)
+{
+	std::map<int, QLocalSocket *>::iterator found = clients.find(client);
+	if (found == clients.end())
+		return;
+	found->second->write(text.c_str(), text.size());
+	found->second->write("\n", 1);
+}
+
+void ControlServer::accept()
+{
+	while (QLocalSocket *socket = server.nextPendingConnection()) {
+		int client = nextClient++;
+		clients[client] = socket;
+		QObject::connect(socket, &QLocalSocket::readyRead, socket, [this, client] { receive(client); });
+		QObject::connect(socket, &QLocalSocket::disconnected, socket, [this, client] {
+			std::map<int, QLocalSocket *>::iterator found = clients.find(client);
+			if (found != clients.end()) {
+				found->second->deleteLater();
+				clients.erase(found);
+			}
+		});
+	}
+}
+
+void ControlServer::receive(int client)
+{
+	// A read can still be delivered after the client disconnected
+	std::map<int, QLocalSocket *>::iterator found = clients.find(client);
+	if (found == clients.end())
+		return;
+	QLocalSocket *socket = found->second;
+	bool queued = !pending.empty();
+
+	while (socket->canReadLine()) {
+		QByteArray line = socket->readLine().trimmed();
+		if (line.isEmpty())
+			continue;
+		// Nothing it sent is used, not even what came before in the same read
+		if (looksLikeHttp(line)) {
+			printf("ERROR: Control client %d sent an HTTP request, disconnecting it\n", client);
+			pending.erase(std::remove_if(pending.begin(), pending.end(),
+				[client](const ControlRequest &request) { return request.client == client; }), pending.end());
+			socket->abort();
+			break;
+		}
+		ControlRequest request = { client, std::string(line.constData(), line.size()) };
+		pending.push_back(request);
+	}
+
+	if (socket->bytesAvailable() > CONTROL_MAX_LINE) {
+		printf("ERROR: Control client %d sent a request over %d bytes, disconnecting it\n", client, CONTROL_MAX_LINE);
+		socket->abort();
+	}
+
+	if (!queued && !pending.empty() && notify)
+		notify();
+}
@@ -0,0 +1,73 @@
+/** @file
+@brief Local socket other programs drive the tool through
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// One request line from a client
+struct ControlRequest {
+	int client;
+	std::string text;
+};
+
+// Accepts connections from programs run by the same user on this machine
+// only (a named pipe on Windows, a Unix domain socket elsewhere) and splits
+// what they send into lines, one JSON request each. A client that sends
+// anything looking like HTTP is dropped. Requests are queued until the GUI thread
+// takes them, so everything that arrived in one go can be applied before the
+// next frame. Lives on the GUI thread like the sockets it owns.
+class ControlServer {
+public:
+	ControlServer();
+	~ControlServer();
+
+	bool listen(const QString &name, QString &error);
+
+	// Called when requests were queued, the first time since the last take()
+	void setNotify(std::function<void()> notify);
+
+	// Requests received since the last call in the order they arrived
+	std::vector<ControlRequest> take();
+
+	// Send a reply line to a client, dropped if it has gone
+	void reply(int client, const std::string &text);
+
+private:
+	void accept();
+	void receive(int client);
+
+	QLocalServer server;
+	std::map<int, QLocalSocket *> clients;
+	int nextClient;
+	std::vector<ControlRequest> pending;
+	std::function<void()> notify;
+};
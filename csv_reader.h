@@ -0,0 +1,63 @@
+/** @file
+@brief Minimal CSV helpers for the measurement files the tool imports
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+inline std::string csvTrim(const std::string &value)
+{
+	size_t begin = value.find_first_not_of(" \t\r\n");
+	if (begin == std::string::npos)
+		return "";
+	size_t end = value.find_last_not_of(" \t\r\n");
+	return value.substr(begin, end - begin + 1);
+}
+
+// Split a line into trimmed fields. Returns false for blank lines and
+// # comments so the caller can just skip them.
+inline bool csvSplit(const std::string &line, std::vector<std::string> &fields)
+{
+	fields.clear();
+	std::string trimmed = csvTrim(line);
+	if (trimmed.empty() || trimmed[0] == '#')
+		return false;
+
+	std::stringstream stream(trimmed);
+	std::string field;
+	while (std::getline(stream, field, ','))
+		fields.push_back(csvTrim(field));
+	return true;
+}
+
+inline bool csvNumber(const std::string &field, double &value)
+{
+	char *end;
+	value = strtod(field.c_str(), &end);
+	return end != field.c_str() && *end == '\0';
+}
@@ -0,0 +1,130 @@
+/** @file
+@brief On disk cache of computed distortion data keyed by config hash
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "distortion_cache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <stdio.h>
+
+#define CACHE_MAGIC 0x43444d48	// "HMDC"
+#define CACHE_VERSION 1
+
+namespace {
+
+	// Padded so the data after it stays 16 byte aligned in the mapping
+	struct EntryHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint64_t size;
+		uint64_t reserved;
+	};
+
+	struct MappedFile {
+		QFile file;
+		uchar *memory;
+
+		MappedFile(const QString &name) : file(name), memory(0) {}
+		~MappedFile()
+		{
+			if (memory)
+				file.unmap(memory);
+		}
+	};
+}
+
+DistortionCache::DistortionCache(const QString &directory, int maxEntries)
+	: directory(directory), maxEntries(maxEntries)
+{
+}
+
+QString DistortionCache::path(uint64_t key) const
+{
+	return directory + "/" + QString("%1.bin").arg((qulonglong)key, 16, 16, QChar('0'));
+}
+
+std::shared_ptr<const void> DistortionCache::find(uint64_t key, const void *&data, size_t &size)
+{
+	std::shared_ptr<MappedFile> mapped(new MappedFile(path(key)));
+	if (!mapped->file.open(QIODevice::ReadOnly) || mapped->file.size() < (qint64)sizeof(EntryHeader))
+		return std::shared_ptr<const void>();
+
+	mapped->memory = mapped->file.map(0, mapped->file.size());
+	if (!mapped->memory)
+		return std::shared_ptr<const void>();
+
+	// Anything that doesn't match exactly is treated as a miss and rebuilt
+	const EntryHeader *header = (const EntryHeader *)mapped->memory;
+	if (header->magic != CACHE_MAGIC || header->version != CACHE_VERSION || header->key != key
+		|| header->size != (uint64_t)(mapped->file.size() - sizeof(EntryHeader)))
+		return std::shared_ptr<const void>();
+
+	// Mark it used so trim() keeps it. The time can't be set through the read
+	// only handle on Windows so it takes one that can write
+	QFile touch(mapped->file.fileName());
+	if (!touch.open(QIODevice::Append) || !touch.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime))
+		printf("ERROR: Unable to mark cache file \"%s\" as used\n", path(key).toLocal8Bit().constData());
+
+	data = mapped->memory + sizeof(EntryHeader);
+	size = (size_t)header->size;
+	return mapped;
+}
+
+void DistortionCache::store(uint64_t key, const void *data, size_t size)
+{
+	if (!QDir().mkpath(directory))
+		return;
+
+	EntryHeader header;
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.key = key;
+	header.size = size;
+	header.reserved = 0;
+
+	QSaveFile file(path(key));
+	if (!file.open(QIODevice::WriteOnly))
+		return;
+	file.write((const char *)&header, sizeof(header));
+	file.write((const char *)data, size);
+	if (!file.commit())
+		printf("ERROR: Unable to write cache file \"%s\"\n", path(key).toLocal8Bit().constData());
+
+	trim();
+}
+
+void DistortionCache::trim()
+{
+	QFileInfoList entries = QDir(directory).entryInfoList(QStringList() << "*.bin", QDir::Files, QDir::Time);
+	// Sorted newest first
+	for (int i = maxEntries; i < (int)entries.size(); i++)
+		QFile::remove(entries[i].absoluteFilePath());
+}
@@ -0,0 +1,50 @@
+/** @file
+@brief On disk cache of computed distortion data keyed by config hash
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include "cache_store.h"
+#include <QString>
+
+// Keeps each entry in its own file (named after the key) in a folder and
+// memory maps it on the way back in, so the data is used straight from the
+// page cache without being read or copied. Files are written to a temporary
+// name and renamed so a crash never leaves a half written entry behind, and
+// only the most recently used entries are kept.
+class DistortionCache : public CacheStore {
+public:
+	DistortionCache(const QString &directory, int maxEntries = 256);
+
+	std::shared_ptr<const void> find(uint64_t key, const void *&data, size_t &size);
+	void store(uint64_t key, const void *data, size_t size);
+
+private:
+	QString path(uint64_t key) const;
+	void trim();
+
+	QString directory;
+	int maxEntries;
+};
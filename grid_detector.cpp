@@ -0,0 +1,381 @@
+/** @file
+@brief Find the red/green/blue grid lines in a photo of the lens output
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "grid_detector.h"
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+	// A local maximum across a line. For vertical lines along is the row and
+	// across the sub-pixel column, for horizontal lines it's the other way round.
+	struct Peak {
+		float along;
+		float across;
+
+		bool operator<(const Peak &other) const
+		{
+			return along < other.along || (along == other.along && across < other.across);
+		}
+	};
+
+	const int channelShift[3] = { 16, 8, 0 };
+
+	// Vertex of the parabola through three samples around a peak
+	inline float subPixel(float a, float b, float c)
+	{
+		float d = a - 2 * b + c;
+		if (d >= 0)
+			return 0;
+		float offset = 0.5f * (a - c) / d;
+		return std::max(-0.5f, std::min(0.5f, offset));
+	}
+
+	// Pull one channel of a row out of the packed pixels
+	inline void extractChannel(const uint32_t *row, int width, int shift, float *out)
+	{
+		for (int x = 0; x < width; x++)
+			out[x] = (float)((row[x] >> shift) & 0xff);
+	}
+
+	// [1 2 1] filter along the row
+	inline void smoothRow(const float *in, int width, float *out)
+	{
+		out[0] = 4 * in[0];
+		for (int x = 1; x < width - 1; x++)
+			out[x] = in[x - 1] + 2 * in[x] + in[x + 1];
+		out[width - 1] = 4 * in[width - 1];
+	}
+
+	struct Track {
+		float firstAlong, lastAlong, lastAcross;
+		std::vector<float> along, across;
+	};
+
+	// Link the sorted peaks of one channel/orientation into lines
+	void linkPeaks(const std::vector<Peak> &peaks, int channel, bool vertical,
+		const GridDetectorOptions &options, std::vector<DetectedLine> &lines)
+	{
+		std::vector<Track> tracks;
+		std::vector<int> active;
+
+		auto finish = [&](int index) {
+			Track &track = tracks[index];
+			if (track.lastAlong - track.firstAlong + 1 >= options.minLength) {
+				DetectedLine line = DetectedLine();
+				line.channel = channel;
+				line.vertical = vertical;
+				line.along.swap(track.along);
+				line.across.swap(track.across);
+				lines.push_back(line);
+			}
+			std::vector<float>().swap(track.along);
+			std::vector<float>().swap(track.across);
+		};
+
+		size_t i = 0;
+		while (i < peaks.size()) {
+			float along = peaks[i].along;
+			size_t end = i;
+			while (end < peaks.size() && peaks[end].along == along)
+				end++;
+
+			// Retire lines that haven't been seen for a while
+			size_t kept = 0;
+			for (size_t a = 0; a < active.size(); a++) {
+				if (along - tracks[active[a]].lastAlong > options.maxGap)
+					finish(active[a]);
+				else
+					active[kept++] = active[a];
+			}
+			active.resize(kept);
+			std::sort(active.begin(), active.end(), [&](int a, int b) {
+				return tracks[a].lastAcross < tracks[b].lastAcross;
+			});
+
+			// Both lists are sorted across the line so walk them together
+			size_t a = 0;
+			std::vector<int> started;
+			for (; i < end; i++) {
+				float across = peaks[i].across;
+				while (a < active.size() && tracks[active[a]].lastAcross < across - options.maxJump)
+					a++;
+
+				int best = -1;
+				float bestDistance = (float)options.maxJump;
+				for (size_t c = a; c < active.size() && tracks[active[c]].lastAcross <= across + options.maxJump; c++) {
+					Track &track = tracks[active[c]];
+					float distance = fabsf(track.lastAcross - across);
+					if (track.lastAlong < along && distance <= bestDistance) {
+						best = active[c];
+						bestDistance = distance;
+					}
+				}
+
+				if (best < 0) {
+					Track track;
+					track.firstAlong = track.lastAlong = along;
+					track.lastAcross = across;
+					tracks.push_back(track);
+					best = (int)tracks.size() - 1;
+					started.push_back(best);
+				}
+
+				Track &track = tracks[best];
+				track.lastAlong = along;
+				track.lastAcross = across;
+				track.along.push_back(along);
+				track.across.push_back(across);
+			}
+			active.insert(active.end(), started.begin(), started.end());
+		}
+
+		for (int index : active)
+			finish(index);
+	}
+
+	// Least squares straight line through the samples and how far they stray from it
+	void fitLine(DetectedLine &line)
+	{
+		size_t n = line.along.size();
+		double sa = 0, sc = 0, saa = 0, sac = 0;
+		for (size_t i = 0; i < n; i++) {
+			sa += line.along[i];
+			sc += line.across[i];
+			saa += (double)line.along[i] * line.along[i];
+			sac += (double)line.along[i] * line.across[i];
+		}
+
+		double det = n * saa - sa * sa;
+		double slope = det != 0 ? (n * sac - sa * sc) / det : 0;
+		double intercept = (sc - slope * sa) / n;
+		double perpendicular = 1 / sqrt(1 + slope * slope);
+
+		double sum = 0, max = 0;
+		for (size_t i = 0; i < n; i++) {
+			double distance = fabs(line.across[i] - (intercept + slope * line.along[i])) * perpendicular;
+			sum += distance * distance;
+			max = std::max(max, distance);
+		}
+
+		line.position = sc / n;
+		line.slope = slope;
+		line.rmsStraightness = sqrt(sum / n);
+		line.maxStraightness = max;
+	}
+
+	// Offsets between every line of one channel and the nearest green line
+	ChannelSeparation separation(const std::vector<DetectedLine> &lines, int channel, const GridDetectorOptions &options)
+	{
+		ChannelSeparation result = { 0, 0, 0 };
+		double sum = 0;
+		long count = 0;
+
+		for (const DetectedLine &line : lines) {
+			if (line.channel != channel)
+				continue;
+
+			const DetectedLine *match = 0;
+			for (const DetectedLine &green : lines) {
+				if (green.channel != GRID_GREEN || green.vertical != line.vertical)
+					continue;
+				if (green.along.back() < line.along.front() || green.along.front() > line.along.back())
+					continue;
+				if (fabs(green.position - line.position) < options.maxSeparation &&
+					(!match || fabs(green.position - line.position) < fabs(match->position - line.position)))
+					match = &green;
+			}
+			if (!match)
+				continue;
+			result.matched++;
+
+			// Both are sorted along the line so interpolate green at each sample
+			size_t g = 0;
+			for (size_t i = 0; i < line.along.size(); i++) {
+				float along = line.along[i];
+				while (g + 1 < match->along.size() && match->along[g + 1] <= along)
+					g++;
+				if (g + 1 >= match->along.size() || match->along[g] > along)
+					continue;
+				float span = match->along[g + 1] - match->along[g];
+				if (span > options.maxGap)
+					continue;
+				float t = (along - match->along[g]) / span;
+				double offset = line.across[i] - (match->across[g] + t * (match->across[g + 1] - match->across[g]));
+				sum += offset * offset;
+				count++;
+				result.max = std::max(result.max, fabs(offset));
+			}
+		}
+
+		result.rms = count ? sqrt(sum / count) : 0;
+		return result;
+	}
+}
+
+void analyseGridImage(const uint32_t *pixels, int width, int height, int stride,
+	GridAnalysis &analysis, const GridDetectorOptions &options)
+{
+	auto start = std::chrono::steady_clock::now();
+	int workers = workerThreadCount();
+
+	analysis.lines.clear();
+	memset(analysis.lineCount, 0, sizeof(analysis.lineCount));
+	memset(analysis.rmsStraightness, 0, sizeof(analysis.rmsStraightness));
+	analysis.redToGreen = analysis.blueToGreen = ChannelSeparation{ 0, 0, 0 };
+	analysis.seconds = 0;
+	if (width < 8 || height < 8)
+		return;
+
+	// Brightest value per channel (every other row is plenty) sets the threshold
+	std::vector<uint32_t> brightest(workers * 3, 0);
+	parallelFor(height / 2, [&](int begin, int end, int worker) {
+		for (int y = begin * 2; y < end * 2; y++) {
+			const uint32_t *row = pixels + (size_t)y * stride;
+			for (int c = 0; c < 3; c++) {
+				uint32_t max = 0;
+				for (int x = 0; x < width; x++)
+					max = std::max(max, (row[x] >> channelShift[c]) & 0xff);
+				brightest[worker * 3 + c] = std::max(brightest[worker * 3 + c], max);
+			}
+		}
+	}, 32);
+
+	float threshold[3];
+	for (int c = 0; c < 3; c++) {
+		uint32_t max = 0;
+		for (int worker = 0; worker < workers; worker++)
+			max = std::max(max, brightest[worker * 3 + c]);
+		// The filters below sum four samples
+		threshold[c] = (float)(4 * std::max(max, 1u) * options.contrast);
+	}
+
+	// Each band of rows is filtered and searched for peaks on its own thread.
+	// Vertical lines peak along a row of the vertically smoothed image and
+	// horizontal lines peak down a column of the horizontally smoothed image.
+	std::vector<std::vector<Peak> > bandPeaks(workers * 6);
+	parallelFor(height - 4, [&](int begin, int end, int worker) {
+		std::vector<float> raw(width * 3), vertical(width), ring(width * 5 * 3);
+		std::vector<unsigned char> mask(width);
+
+		auto rowFor = [&](int y) { return pixels + (size_t)y * stride; };
+		auto ringRow = [&](int c, int y) { return &ring[(c * 5 + (y % 5)) * width]; };
+		auto fillRing = [&](int y) {
+			for (int c = 0; c < 3; c++) {
+				extractChannel(rowFor(y), width, channelShift[c], &raw[0]);
+				smoothRow(&raw[0], width, ringRow(c, y));
+			}
+		};
+
+		// Rows 2 .. height - 3 have the two neighbours the tests need
+		int first = begin + 2, last = end + 2;
+		for (int y = first - 2; y < first + 2; y++)
+			fillRing(y);
+
+		for (int y = first; y < last; y++) {
+			fillRing(y + 2);
+			const uint32_t *above = rowFor(y - 1), *row = rowFor(y), *below = rowFor(y + 1);
+
+			for (int c = 0; c < 3; c++) {
+				int shift = channelShift[c];
+				float t = threshold[c];
+
+				// Vertical lines: [1 2 1] down the columns then search along the row
+				for (int x = 0; x < width; x++)
+					vertical[x] = (float)((above[x] >> shift) & 0xff) + 2 * (float)((row[x] >> shift) & 0xff) + (float)((below[x] >> shift) & 0xff);
+
+				const float *s = &vertical[0];
+				for (int x = 2; x < width - 2; x++)
+					mask[x] = (s[x] > s[x - 1]) & (s[x] >= s[x + 1]) & (s[x] - s[x - 2] > t) & (s[x] - s[x + 2] > t);
+
+				std::vector<Peak> &verticalPeaks = bandPeaks[worker * 6 + c * 2];
+				for (int x = 2; x < width - 2; x++) {
+					if (mask[x]) {
+						Peak peak = { (float)y, x + subPixel(s[x - 1], s[x], s[x + 1]) };
+						verticalPeaks.push_back(peak);
+					}
+				}
+
+				// Horizontal lines: compare the smoothed rows above and below
+				const float *m2 = ringRow(c, y - 2), *m1 = ringRow(c, y - 1), *c0 = ringRow(c, y);
+				const float *p1 = ringRow(c, y + 1), *p2 = ringRow(c, y + 2);
+				for (int x = 0; x < width; x++)
+					mask[x] = (c0[x] > m1[x]) & (c0[x] >= p1[x]) & (c0[x] - m2[x] > t) & (c0[x] - p2[x] > t);
+
+				std::vector<Peak> &horizontalPeaks = bandPeaks[worker * 6 + c * 2 + 1];
+				for (int x = 0; x < width; x++) {
+					if (mask[x]) {
+						Peak peak = { (float)x, y + subPixel(m1[x], c0[x], p1[x]) };
+						horizontalPeaks.push_back(peak);
+					}
+				}
+			}
+		}
+	}, 64);
+
+	// Link the peaks of each channel/orientation into lines
+	std::vector<DetectedLine> found[6];
+	parallelFor(6, [&](int begin, int end, int) {
+		for (int job = begin; job < end; job++) {
+			std::vector<Peak> peaks;
+			for (int worker = 0; worker < workers; worker++) {
+				std::vector<Peak> &band = bandPeaks[worker * 6 + job];
+				peaks.insert(peaks.end(), band.begin(), band.end());
+				std::vector<Peak>().swap(band);
+			}
+			// Vertical peaks come out in row order already, horizontal ones need sorting by column
+			if (job % 2 == 1)
+				std::sort(peaks.begin(), peaks.end());
+			linkPeaks(peaks, job / 2, job % 2 == 0, options, found[job]);
+		}
+	});
+
+	for (int job = 0; job < 6; job++)
+		analysis.lines.insert(analysis.lines.end(), found[job].begin(), found[job].end());
+
+	parallelFor((int)analysis.lines.size(), [&](int begin, int end, int) {
+		for (int i = begin; i < end; i++)
+			fitLine(analysis.lines[i]);
+	});
+
+	double sum[3] = { 0, 0, 0 };
+	for (const DetectedLine &line : analysis.lines) {
+		analysis.lineCount[line.channel]++;
+		sum[line.channel] += line.rmsStraightness * line.rmsStraightness;
+	}
+	for (int c = 0; c < 3; c++)
+		analysis.rmsStraightness[c] = analysis.lineCount[c] ? sqrt(sum[c] / analysis.lineCount[c]) : 0;
+
+	analysis.redToGreen = separation(analysis.lines, GRID_RED, options);
+	analysis.blueToGreen = separation(analysis.lines, GRID_BLUE, options);
+
+	analysis.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,80 @@
+/** @file
+@brief Find the red/green/blue grid lines in a photo of the lens output
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// Channels in image order (not the config file order)
+enum GridChannel {
+	GRID_RED = 0,
+	GRID_GREEN = 1,
+	GRID_BLUE = 2
+};
+
+struct GridDetectorOptions {
+	double contrast = 0.15;		// Minimum peak height as a fraction of the brightest pixel in the channel
+	double maxJump = 1.5;		// Max sideways move (pixels) between rows of the same line
+	int maxGap = 12;			// Rows a line may disappear for (e.g. where it crosses another line)
+	int minLength = 40;			// Ignore lines shorter than this (pixels)
+	double maxSeparation = 25;	// Max distance (pixels) between the same line in two channels
+};
+
+// A line found in one channel. The samples are sub-pixel peak positions across
+// the line (x for a vertical line, y for a horizontal one) one per row/column.
+struct DetectedLine {
+	int channel;				// GridChannel
+	bool vertical;
+	double position;			// Mean position across the line
+	double slope;				// Of the best fit straight line
+	double rmsStraightness;		// RMS distance (pixels) from the best fit straight line
+	double maxStraightness;		// Max distance (pixels) from the best fit straight line
+	std::vector<float> along;	// Row (vertical line) or column (horizontal line) of each sample
+	std::vector<float> across;	// Sub-pixel position of each sample
+};
+
+// How far one channel's lines sit from the matching green lines
+struct ChannelSeparation {
+	int matched;				// Number of line pairs
+	double rms;					// Pixels
+	double max;					// Pixels
+};
+
+struct GridAnalysis {
+	std::vector<DetectedLine> lines;
+	int lineCount[3];				// Per GridChannel
+	double rmsStraightness[3];		// Per GridChannel over all of its lines
+	ChannelSeparation redToGreen;
+	ChannelSeparation blueToGreen;
+	double seconds;					// Time the analysis took
+};
+
+// Analyse a 32 bit 0xAARRGGBB image (QImage::Format_RGB32). stride is in pixels.
+// Rows are split into bands that are filtered and searched on separate threads,
+// then the peaks are linked into lines and fitted in parallel per line.
+void analyseGridImage(const uint32_t *pixels, int width, int height, int stride,
+	GridAnalysis &analysis, const GridDetectorOptions &options = GridDetectorOptions());
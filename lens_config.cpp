@@ -0,0 +1,328 @@
+/** @file
+@brief Read the lens model from a SteamVR config file
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "lens_config.h"
+#include "rapidjson/error/en.h"
+
+#include <fstream>
+#include <sstream>
+#include <string.h>
+
+namespace {
+	const char *sections[3] = { "distortion", "distortion_blue", "distortion_red" };	// Green, Blue, Red
+
+	bool isMatrix(const rapidjson::Value &value, unsigned rows, unsigned columns)
+	{
+		if (!value.IsArray() || value.Size() != rows)
+			return false;
+		for (unsigned row = 0; row < rows; row++) {
+			if (!value[row].IsArray() || value[row].Size() != columns)
+				return false;
+			for (unsigned col = 0; col < columns; col++)
+				if (!value[row][col].IsNumber())
+					return false;
+		}
+		return true;
+	}
+
+	bool isOptionalNumber(const rapidjson::Value &object, const char *name)
+	{
+		return !object.HasMember(name) || object[name].IsNumber();
+	}
+
+	rapidjson::Value *findMember(rapidjson::Value &object, const char *name)
+	{
+		rapidjson::Value::MemberIterator member = object.FindMember(name);
+		return member != object.MemberEnd() ? &member->value : 0;
+	}
+
+	bool identityExtrinsics(const double extrinsics[3][4])
+	{
+		double identity[3][4];
+		lensIdentityExtrinsics(identity);
+		return memcmp(extrinsics, identity, sizeof(identity)) == 0;
+	}
+}
+
+bool validateConfig(const rapidjson::Value &json, std::string &error)
+{
+	if (!json.IsObject() || !json.HasMember("tracking_to_eye_transform")
+		|| !json["tracking_to_eye_transform"].IsArray() || json["tracking_to_eye_transform"].Size() < 2) {
+		error = "the config has no \"tracking_to_eye_transform\" for both eyes";
+		return false;
+	}
+
+	for (int eye = 0; eye < 2; eye++) {
+		const rapidjson::Value &transform = json["tracking_to_eye_transform"][eye];
+		std::string where = std::string(lensEyeName(eye)) + " eye";
+		if (!transform.IsObject() || !transform.HasMember("intrinsics") || !isMatrix(transform["intrinsics"], 3, 3)) {
+			error = where + " has no 3x3 \"intrinsics\"";
+			return false;
+		}
+		if (transform.HasMember("extrinsics") && !isMatrix(transform["extrinsics"], 3, 4)) {
+			error = where + " \"extrinsics\" should be a 3x4 matrix";
+			return false;
+		}
+
+		for (int col = 0; col < 3; col++) {
+			if (!transform.HasMember(sections[col]) || !transform[sections[col]].IsObject()) {
+				error = where + " has no \"" + sections[col] + "\"";
+				return false;
+			}
+			const rapidjson::Value &section = transform[sections[col]];
+			std::string at = where + " \"" + sections[col] + "\"";
+
+			int type = DISTORT_DPOLY3;
+			if (section.HasMember("type")) {
+				type = section["type"].IsString() ? findDistortionType(section["type"].GetString()) : -1;
+				if (type < 0) {
+					error = at + " has a distortion type this tool doesn't know";
+					return false;
+				}
+			}
+
+			int terms = distortionType(type).terms;
+			const rapidjson::Value *coeffs = section.HasMember("coeffs") ? &section["coeffs"] : 0;
+			bool valid = coeffs && coeffs->IsArray() && (int)coeffs->Size() >= terms;
+			for (rapidjson::SizeType cof = 0; valid && cof < coeffs->Size(); cof++)
+				valid = (*coeffs)[cof].IsNumber();
+			if (!valid) {
+				std::stringstream msg;
+				msg << at << " needs " << terms << " numbers in \"coeffs\" for " << distortionType(type).name;
+				error = msg.str();
+				return false;
+			}
+
+			if (!isOptionalNumber(section, "center_x") || !isOptionalNumber(section, "center_y")) {
+				error = at + " \"center_x\" and \"center_y\" should be numbers";
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool parseConfigFile(const std::string &filename, std::vector<char> &buffer, rapidjson::Document &json, std::string &error)
+{
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if (!file) {
+		error = "unable to open the file";
+		return false;
+	}
+	file.seekg(0, std::ios::end);
+	std::streamoff size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	if (size < 0) {
+		error = "unable to read the file";
+		return false;
+	}
+
+	// One read straight into the buffer the document will live in, plus the
+	// terminator the in place parse needs. Not mapped: the strings point into
+	// the buffer for as long as the config is loaded and on Windows a file
+	// that is mapped can't be replaced, which is how a save writes it back.
+	// ParseInsitu also writes into the buffer and needs a 0 past the end of
+	// the file, so a private mapping would copy most pages anyway.
+	buffer.resize((size_t)size + 1);
+	if (!file.read(&buffer[0], size)) {
+		error = "unable to read the file";
+		return false;
+	}
+	buffer[(size_t)size] = 0;
+	return parseConfigBuffer(buffer, json, error);
+}
+
+bool parseConfigBuffer(std::vector<char> &buffer, rapidjson::Document &json, std::string &error)
+{
+	// Editors on Windows like to add a UTF-8 byte order mark
+	char *text = &buffer[0];
+	if (buffer.size() > 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0)
+		text += 3;
+
+	json.ParseInsitu(text);
+	if (json.HasParseError()) {
+		std::stringstream msg;
+		msg << rapidjson::GetParseError_En(json.GetParseError()) << " (at byte " << json.GetErrorOffset() + (text - &buffer[0]) << ")";
+		error = msg.str();
+		return false;
+	}
+	return validateConfig(json, error);
+}
+
+bool readLensModel(const rapidjson::Value &json, LensModel &model, std::string &error)
+{
+	if (!validateConfig(json, error))
+		return false;
+
+	for (int eye = 0; eye < 2; eye++) {
+		const rapidjson::Value &transform = json["tracking_to_eye_transform"][eye];
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				model.intrinsics[eye][row][col] = transform["intrinsics"][row][col].GetDouble();
+
+		// 3x4 eye to head pose, configs without one have the eye looking straight ahead
+		lensIdentityExtrinsics(model.extrinsics[eye]);
+		if (transform.HasMember("extrinsics")) {
+			const rapidjson::Value &extrinsics = transform["extrinsics"];
+			for (int row = 0; row < 3; row++)
+				for (int col = 0; col < 4; col++)
+					model.extrinsics[eye][row][col] = extrinsics[row][col].GetDouble();
+		}
+
+		for (int col = 0; col < 3; col++) {
+			const rapidjson::Value &section = transform[sections[col]];
+			int type = section.HasMember("type") ? findDistortionType(section["type"].GetString()) : DISTORT_DPOLY3;
+			int terms = distortionType(type).terms;
+			const rapidjson::Value &coeffs = section["coeffs"];
+
+			model.types[eye][col] = type;
+			for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+				model.coeffs[eye][col][cof] = cof < terms ? coeffs[cof].GetDouble() : 0.0;
+		}
+	}
+	return true;
+}
+
+double readConfigCenter(const rapidjson::Value &json, int eye, int axis)
+{
+	const rapidjson::Value &section = json["tracking_to_eye_transform"][eye]["distortion"];
+	rapidjson::Value::ConstMemberIterator center = section.FindMember(axis == 0 ? "center_x" : "center_y");
+	return center != section.MemberEnd() ? center->value.GetDouble() : 0.0;
+}
+
+bool ConfigHandles::resolve(rapidjson::Document &json, std::string &error)
+{
+	document = 0;
+	if (!validateConfig(json, error))
+		return false;
+
+	document = &json;
+	take();
+	return true;
+}
+
+void ConfigHandles::take()
+{
+	for (int eye = 0; eye < 2; eye++) {
+		rapidjson::Value &transform = (*document)["tracking_to_eye_transform"][eye];
+		rapidjson::Value *pose = findMember(transform, "extrinsics");
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 3; col++)
+				intrinsics[eye][row][col] = &transform["intrinsics"][row][col];
+			for (int col = 0; col < 4; col++)
+				extrinsics[eye][row][col] = pose ? &(*pose)[row][col] : 0;
+		}
+		for (int col = 0; col < 3; col++) {
+			rapidjson::Value &section = transform[sections[col]];
+			type[eye][col] = findMember(section, "type");
+			coeffs[eye][col] = &section["coeffs"];
+			centerX[eye][col] = findMember(section, "center_x");
+			centerY[eye][col] = findMember(section, "center_y");
+		}
+	}
+}
+
+void ConfigHandles::write(const LensModel &model)
+{
+	if (!document)
+		return;
+	rapidjson::Document::AllocatorType &allocator = document->GetAllocator();
+
+	// Only what the model can't be written without is added. Adding members
+	// can move the others around so the pointers are taken again after.
+	bool added = false;
+	for (int eye = 0; eye < 2; eye++) {
+		rapidjson::Value &transform = (*document)["tracking_to_eye_transform"][eye];
+		if (!extrinsics[eye][0][0] && !identityExtrinsics(model.extrinsics[eye])) {
+			rapidjson::Value pose(rapidjson::kArrayType);
+			for (int row = 0; row < 3; row++) {
+				rapidjson::Value values(rapidjson::kArrayType);
+				for (int col = 0; col < 4; col++)
+					values.PushBack(0.0, allocator);
+				pose.PushBack(values, allocator);
+			}
+			transform.AddMember("extrinsics", pose, allocator);
+			added = true;
+		}
+		for (int col = 0; col < 3; col++) {
+			if (!type[eye][col] && model.types[eye][col] != DISTORT_DPOLY3) {
+				rapidjson::Value name(rapidjson::StringRef(distortionType(model.types[eye][col]).name));
+				transform[sections[col]].AddMember("type", name, allocator);
+				added = true;
+			}
+		}
+	}
+	if (added)
+		take();
+
+	for (int eye = 0; eye < 2; eye++) {
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 3; col++)
+				intrinsics[eye][row][col]->SetDouble(model.intrinsics[eye][row][col]);
+			for (int col = 0; col < 4; col++)
+				if (extrinsics[eye][row][col])
+					extrinsics[eye][row][col]->SetDouble(model.extrinsics[eye][row][col]);
+		}
+
+		for (int col = 0; col < 3; col++) {
+			const DistortionType &distortion = distortionType(model.types[eye][col]);
+
+			// The names are string literals so they don't need copying
+			if (type[eye][col])
+				type[eye][col]->SetString(rapidjson::StringRef(distortion.name));
+
+			rapidjson::Value &values = *coeffs[eye][col];
+			while ((int)values.Size() > distortion.terms)
+				values.PopBack();
+			while ((int)values.Size() < distortion.terms)
+				values.PushBack(0.0, allocator);
+			for (int cof = 0; cof < distortion.terms; cof++)
+				values[cof].SetDouble(model.coeffs[eye][col][cof]);
+
+			if (centerX[eye][col])
+				centerX[eye][col]->SetDouble(model.intrinsics[eye][0][2]);
+			if (centerY[eye][col])
+				centerY[eye][col]->SetDouble(model.intrinsics[eye][1][2]);
+		}
+	}
+}
+
+bool loadLensModel(const std::string &filename, int width, int height, LensModel &model, std::string &error)
+{
+	std::vector<char> buffer;
+	rapidjson::Document json;
+	memset(&model, 0, sizeof(model));
+	if (!parseConfigFile(filename, buffer, json, error) || !readLensModel(json, model, error)) {
+		error = filename + ": " + error;
+		return false;
+	}
+	model.width = width;
+	model.height = height;
+	model.applyAspect = true;
+	model.applyExtrinsics = true;
+	return true;
+}
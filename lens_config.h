@@ -0,0 +1,101 @@
+/** @file
+@brief Read the lens model from a SteamVR config file
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include "lens_model.h"
+#include "rapidjson/document.h"
+#include <string>
+#include <vector>
+
+// Check a parsed config has everything this tool reads, in the shape it
+// expects. For both entries of "tracking_to_eye_transform":
+//    intrinsics						3x3 numbers
+//    extrinsics						3x4 numbers, optional
+//    distortion, distortion_blue,
+//    distortion_red					objects with
+//        type							a known distortion type name, optional
+//        coeffs						numbers, at least as many as the type uses
+//        center_x, center_y			numbers, optional
+// Anything else in the file is left alone. The error names the eye and
+// section at fault.
+bool validateConfig(const rapidjson::Value &json, std::string &error);
+
+// Read a whole config file into buffer and parse it in place, so the only
+// copy of the file is buffer and the strings in json point into it. buffer
+// has to outlive json. The result has been through validateConfig().
+bool parseConfigFile(const std::string &filename, std::vector<char> &buffer, rapidjson::Document &json, std::string &error);
+
+// The same for a config already in memory. buffer holds the text followed by
+// a 0 and is parsed in place.
+bool parseConfigBuffer(std::vector<char> &buffer, rapidjson::Document &json, std::string &error);
+
+// Read the distortion types, coefficients, intrinsics and extrinsics of both
+// eyes from a parsed config. Sections without a "type" are DISTORT_DPOLY3.
+// Fails if the config doesn't pass validateConfig().
+bool readLensModel(const rapidjson::Value &json, LensModel &model, std::string &error);
+
+// center_x (axis 0) or center_y (axis 1) of the "distortion" section of an
+// eye in a validated config, 0 if it doesn't have one
+double readConfigCenter(const rapidjson::Value &json, int eye, int axis);
+
+// Every value a save changes, looked up once after a config is parsed so a
+// save is just a few dozen stores instead of chains of member lookups.
+// resolve() fails if the config doesn't pass validateConfig(). The optional
+// members (type, centers, extrinsics) are only written where the config has
+// them, so a save doesn't change the layout of a config the tool didn't
+// change. The pointers stay valid until the document is parsed again.
+class ConfigHandles {
+public:
+	ConfigHandles() : document(0) {}
+
+	bool resolve(rapidjson::Document &json, std::string &error);
+	bool valid() const { return document != 0; }
+	void clear() { document = 0; }
+
+	// Store the types, coefficients, intrinsics and extrinsics of both eyes.
+	// Each "coeffs" array is sized to what its type uses and every center_x/
+	// center_y gets the center from the intrinsics. A "type" or "extrinsics"
+	// the config doesn't have is added only when the model differs from what
+	// leaving it out means (DISTORT_DPOLY3, no rotation or offset).
+	void write(const LensModel &model);
+
+private:
+	void take();	// Pointers to everything there is, null for missing optional members
+
+	rapidjson::Document *document;
+	rapidjson::Value *intrinsics[2][3][3];
+	rapidjson::Value *extrinsics[2][3][4];
+	rapidjson::Value *type[2][3];
+	rapidjson::Value *coeffs[2][3];
+	rapidjson::Value *centerX[2][3];
+	rapidjson::Value *centerY[2][3];
+};
+
+// Load a config file for the offline tools. The panel size isn't in the
+// config so it has to be given. The aspect ratio and extrinsics are always
+// applied since that's what SteamVR does.
+bool loadLensModel(const std::string &filename, int width, int height, LensModel &model, std::string &error);
@@ -0,0 +1,177 @@
+/** @file
+@brief How far one calibration moves the image compared with another
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lens_diff.h"
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+namespace {
+
+	struct Accumulator {
+		double sumSq[2][3];
+		int count[2][3];
+		int invalid[2][3];
+		double maxSq[2][3];
+		double maxX[2][3], maxY[2][3];
+	};
+}
+
+void diffLensModels(const LensModel &before, const LensModel &after, DistortionDiff &diff, int step)
+{
+	auto start = std::chrono::steady_clock::now();
+	step = std::max(step, 1);
+	int eyeWidth = before.width / 2;
+	int eyeColumns = (eyeWidth + step - 1) / step;
+	diff.step = step;
+	diff.columns = eyeColumns * 2;
+	diff.rows = (before.height + step - 1) / step;
+	for (int color = 0; color < 3; color++)
+		diff.displacement[color].assign((size_t)diff.columns * diff.rows, NAN);
+
+	LensEyeTransform transforms[2][2];	// Model, eye
+	double foldSq[2][2][3];				// Model, eye, color: squared offset past which the model folds
+	const LensModel *models[2] = { &before, &after };
+	for (int which = 0; which < 2; which++) {
+		for (int eye = 0; eye < 2; eye++) {
+			double copX, copY;
+			lensCenterOfProjection(*models[which], eye, copX, copY);
+			transforms[which][eye] = LensEyeTransform(*models[which], eye, copX, copY);
+			for (int color = 0; color < 3; color++) {
+				double fold = lensFoldRadius(*models[which], eye, color);
+				foldSq[which][eye][color] = fold < 0 ? INFINITY : fold * fold;
+			}
+		}
+	}
+
+	std::vector<Accumulator> accumulators(workerThreadCount());
+	memset(&accumulators[0], 0, sizeof(Accumulator) * accumulators.size());
+
+	// One task per row of both eyes, each drawn a whole row at a time
+	parallelFor(diff.rows * 2, [&](int begin, int end, int worker) {
+		Accumulator &acc = accumulators[worker];
+		std::vector<double> beforeX(eyeColumns), beforeY(eyeColumns), afterX(eyeColumns), afterY(eyeColumns);
+		std::vector<double> beforeR2(eyeColumns), afterR2(eyeColumns);
+
+		for (int task = begin; task < end; task++) {
+			int eye = task / diff.rows, j = task % diff.rows;
+			double x0 = eye * eyeWidth, y = j * step;
+
+			// How far out each sample is for the radial step of either model, the same for every color
+			for (int i = 0; i < eyeColumns; i++) {
+				double ox, oy;
+				transforms[0][eye].forward(x0 + i * step, y, ox, oy);
+				beforeR2[i] = ox * ox + oy * oy;
+				transforms[1][eye].forward(x0 + i * step, y, ox, oy);
+				afterR2[i] = ox * ox + oy * oy;
+			}
+
+			for (int color = 0; color < 3; color++) {
+				lensDistortRow(before, transforms[0][eye], eye, color, x0, step, y, eyeColumns, &beforeX[0], &beforeY[0]);
+				lensDistortRow(after, transforms[1][eye], eye, color, x0, step, y, eyeColumns, &afterX[0], &afterY[0]);
+
+				float *out = &diff.displacement[color][(size_t)j * diff.columns + eye * eyeColumns];
+				for (int i = 0; i < eyeColumns; i++) {
+					double dx = afterX[i] - beforeX[i], dy = afterY[i] - beforeY[i];
+					double sq = dx * dx + dy * dy;
+					if (!std::isfinite(sq) || beforeR2[i] >= foldSq[0][eye][color] || afterR2[i] >= foldSq[1][eye][color]) {
+						acc.invalid[eye][color]++;
+						continue;
+					}
+					out[i] = (float)sqrt(sq);
+					acc.sumSq[eye][color] += sq;
+					acc.count[eye][color]++;
+					if (sq > acc.maxSq[eye][color]) {
+						acc.maxSq[eye][color] = sq;
+						acc.maxX[eye][color] = x0 + i * step;
+						acc.maxY[eye][color] = y;
+					}
+				}
+			}
+		}
+	}, 8);
+
+	for (int eye = 0; eye < 2; eye++) {
+		for (int color = 0; color < 3; color++) {
+			DisplacementStats &stats = diff.stats[eye][color];
+			memset(&stats, 0, sizeof(stats));
+			double sumSq = 0, maxSq = -1;
+			for (const Accumulator &acc : accumulators) {
+				sumSq += acc.sumSq[eye][color];
+				stats.samples += acc.count[eye][color];
+				stats.invalid += acc.invalid[eye][color];
+				if (acc.count[eye][color] > 0 && acc.maxSq[eye][color] > maxSq) {
+					maxSq = acc.maxSq[eye][color];
+					stats.maxX = acc.maxX[eye][color];
+					stats.maxY = acc.maxY[eye][color];
+				}
+			}
+			if (stats.samples == 0)
+				continue;
+			stats.maxError = sqrt(maxSq);
+			stats.rmsError = sqrt(sumSq / stats.samples);
+
+			// The percentile needs the values themselves
+			std::vector<float> values;
+			values.reserve(stats.samples);
+			for (int j = 0; j < diff.rows; j++) {
+				const float *row = &diff.displacement[color][(size_t)j * diff.columns + eye * eyeColumns];
+				for (int i = 0; i < eyeColumns; i++)
+					if (!std::isnan(row[i]))
+						values.push_back(row[i]);
+			}
+			size_t rank = std::min(values.size() - 1, (size_t)ceil(values.size() * 0.99) - 1);
+			std::nth_element(values.begin(), values.begin() + rank, values.end());
+			stats.p99 = values[rank];
+		}
+	}
+	diff.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void distortionDiffImage(const DistortionDiff &diff, double scale, std::vector<uint32_t> &pixels)
+{
+	pixels.resize((size_t)diff.columns * diff.rows);
+	float toByte = (float)(255 / std::max(scale, 1e-9));
+
+	parallelFor(diff.rows, [&](int begin, int end, int) {
+		for (int j = begin; j < end; j++) {
+			// Panel Y goes up, the image down
+			uint32_t *out = &pixels[(size_t)(diff.rows - 1 - j) * diff.columns];
+			const float *red = &diff.displacement[LENS_RED][(size_t)j * diff.columns];
+			const float *green = &diff.displacement[LENS_GREEN][(size_t)j * diff.columns];
+			const float *blue = &diff.displacement[LENS_BLUE][(size_t)j * diff.columns];
+			for (int i = 0; i < diff.columns; i++) {
+				// NAN fails the comparison so invalid samples end up at 255
+				uint32_t r = red[i] * toByte < 255 ? (uint32_t)(red[i] * toByte) : 255;
+				uint32_t g = green[i] * toByte < 255 ? (uint32_t)(green[i] * toByte) : 255;
+				uint32_t b = blue[i] * toByte < 255 ? (uint32_t)(blue[i] * toByte) : 255;
+				out[i] = 0xff000000 | (r << 16) | (g << 8) | b;
+			}
+		}
+	}, 16);
+}
@@ -0,0 +1,59 @@
+/** @file
+@brief How far one calibration moves the image compared with another
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "lens_model.h"
+#include <stdint.h>
+#include <vector>
+
+// How far one eye/color is drawn from where the other config draws it
+struct DisplacementStats {
+	int samples;			// Ideal panel pixels evaluated
+	int invalid;			// Either model folds or blows up there so they aren't in the numbers
+	double maxError;		// Pixels
+	double p99;				// 99% of the samples moved less than this
+	double rmsError;
+	double maxX, maxY;		// Ideal panel pixel that moved the most
+};
+
+// Both models evaluated at every step'th ideal pixel of the panel and the
+// distance between the two drawn points, with the full linear transform
+// around each model's own center from its intrinsics the way SteamVR does.
+struct DistortionDiff {
+	int step;
+	int columns, rows;						// Samples across the whole panel (both eyes) and up it
+	std::vector<float> displacement[3];		// Per LensColor, rows from panel Y 0 up, NAN where invalid
+	DisplacementStats stats[2][3];			// Eyes, LensColor
+	double seconds;
+};
+
+// before and after must be for the same panel size
+void diffLensModels(const LensModel &before, const LensModel &after, DistortionDiff &diff, int step = 1);
+
+// The diff as an RGB32 image (top row first) one pixel per sample, each
+// channel brighter the further that color moved: scale pixels or more of
+// displacement (or an invalid sample) is full brightness.
+void distortionDiffImage(const DistortionDiff &diff, double scale, std::vector<uint32_t> &pixels);
@@ -0,0 +1,204 @@
+/** @file
+@brief Heatmaps of the distortion and the color separation over the panel
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lens_heatmap.h"
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace {
+
+	// Dark blue, light blue, green, yellow, red. Kept below full brightness
+	// so the grid drawn over it still shows.
+	const float rampStops[5][3] = {
+		{ 0, 0, 96 }, { 0, 96, 192 }, { 0, 192, 96 }, { 192, 192, 0 }, { 192, 0, 0 }
+	};
+
+	uint32_t rampColor(float t)
+	{
+		t = std::max(0.0f, std::min(1.0f, t)) * 4;
+		int i = std::min((int)t, 3);
+		float f = t - i;
+		uint32_t rgb[3];
+		for (int c = 0; c < 3; c++)
+			rgb[c] = (uint32_t)(rampStops[i][c] + f * (rampStops[i + 1][c] - rampStops[i][c]) + 0.5f);
+		return 0xff000000 | (rgb[0] << 16) | (rgb[1] << 8) | rgb[2];
+	}
+}
+
+const char *heatmapModeName(int mode)
+{
+	static const char *names[HEATMAP_MODES] = { "Off", "Distortion", "Red - Blue separation", "Green - Blue separation" };
+	return mode >= 0 && mode < HEATMAP_MODES ? names[mode] : "Unknown";
+}
+
+LensHeatmap::LensHeatmap()
+	: panelWidth(0), panelHeight(0), shown(HEATMAP_OFF)
+{
+	peak[0] = peak[1] = 0;
+	invalidateAll();
+}
+
+void LensHeatmap::invalidate(int eye, int color)
+{
+	dirty[eye][color] = true;
+}
+
+void LensHeatmap::invalidateAll()
+{
+	for (int eye = 0; eye < 2; eye++)
+		for (int color = 0; color < 3; color++)
+			dirty[eye][color] = true;
+}
+
+double LensHeatmap::fullScale() const
+{
+	return std::max(std::max(peak[0], peak[1]), 0.01);
+}
+
+bool LensHeatmap::update(const LensModel &model, const double cop[2][2], HeatmapMode mode)
+{
+	if (mode == HEATMAP_OFF)
+		return false;
+
+	if (model.width != panelWidth || model.height != panelHeight) {
+		panelWidth = model.width;
+		panelHeight = model.height;
+		invalidateAll();
+		image.assign((size_t)panelWidth * panelHeight, 0xff000000);
+	}
+
+	// Only the colors the mode looks at, the others wait until a mode needs them
+	bool needed[3] = { false, false, false };
+	if (mode == HEATMAP_DISPLACEMENT)
+		needed[LENS_GREEN] = true;
+	else {
+		needed[mode == HEATMAP_RED_BLUE ? LENS_RED : LENS_GREEN] = true;
+		needed[LENS_BLUE] = true;
+	}
+
+	bool changed = false;
+	for (int eye = 0; eye < 2; eye++) {
+		bool recompute = mode != shown;
+		for (int color = 0; color < 3; color++) {
+			if (needed[color] && dirty[eye][color]) {
+				computeField(model, cop, eye, color);
+				dirty[eye][color] = false;
+				recompute = true;
+			}
+		}
+		if (recompute) {
+			computeValues(eye, mode);
+			changed = true;
+		}
+	}
+	shown = mode;
+
+	// A new largest value on one eye changes the colors of the other too
+	if (changed)
+		colorize();
+	return changed;
+}
+
+void LensHeatmap::computeField(const LensModel &model, const double cop[2][2], int eye, int color)
+{
+	int eyeWidth = panelWidth / 2, x0 = eye * eyeWidth;
+	std::vector<float> &field = fields[eye][color];
+	field.resize((size_t)eyeWidth * panelHeight * 2);
+	LensEyeTransform transform(model, eye, cop[eye][0], cop[eye][1]);
+	double fold = lensFoldRadius(model, eye, color);
+	double foldSq = fold < 0 ? INFINITY : fold * fold;
+
+	parallelFor(panelHeight, [&](int begin, int end, int) {
+		std::vector<double> drawnX(eyeWidth), drawnY(eyeWidth);
+		for (int y = begin; y < end; y++) {
+			lensDistortRow(model, transform, eye, color, x0, 1, y, eyeWidth, &drawnX[0], &drawnY[0]);
+			float *out = &field[(size_t)y * eyeWidth * 2];
+			for (int i = 0; i < eyeWidth; i++) {
+				// Past the fold the model folds the image over, that shows black
+				double ox, oy;
+				transform.forward(x0 + i, y, ox, oy);
+				bool folded = ox * ox + oy * oy >= foldSq;
+				out[i * 2] = folded ? NAN : (float)(drawnX[i] - (x0 + i));
+				out[i * 2 + 1] = folded ? NAN : (float)(drawnY[i] - y);
+			}
+		}
+	}, 16);
+}
+
+void LensHeatmap::computeValues(int eye, HeatmapMode mode)
+{
+	size_t count = (size_t)(panelWidth / 2) * panelHeight;
+	values[eye].resize(count);
+	const float *a = mode == HEATMAP_DISPLACEMENT ? &fields[eye][LENS_GREEN][0]
+		: &fields[eye][mode == HEATMAP_RED_BLUE ? LENS_RED : LENS_GREEN][0];
+	const float *b = mode == HEATMAP_DISPLACEMENT ? 0 : &fields[eye][LENS_BLUE][0];
+
+	std::vector<float> largest(workerThreadCount(), 0.0f);
+	parallelFor(panelHeight, [&](int begin, int end, int worker) {
+		size_t first = (size_t)begin * (panelWidth / 2), last = (size_t)end * (panelWidth / 2);
+		float *out = &values[eye][0];
+		float top = largest[worker];
+		for (size_t i = first; i < last; i++) {
+			float dx = b ? a[i * 2] - b[i * 2] : a[i * 2];
+			float dy = b ? a[i * 2 + 1] - b[i * 2 + 1] : a[i * 2 + 1];
+			float value = sqrtf(dx * dx + dy * dy);
+			if (!std::isfinite(value))
+				value = NAN;
+			else if (value > top)
+				top = value;
+			out[i] = value;
+		}
+		largest[worker] = top;
+	}, 16);
+
+	peak[eye] = *std::max_element(largest.begin(), largest.end());
+}
+
+void LensHeatmap::colorize()
+{
+	// A table is cheaper than the ramp for every pixel
+	uint32_t table[256];
+	for (int i = 0; i < 256; i++)
+		table[i] = rampColor(i / 255.0f);
+	float toIndex = (float)(255 / fullScale());
+
+	int eyeWidth = panelWidth / 2;
+	parallelFor(panelHeight, [&](int begin, int end, int) {
+		for (int y = begin; y < end; y++) {
+			for (int eye = 0; eye < 2; eye++) {
+				const float *in = &values[eye][(size_t)y * eyeWidth];
+				uint32_t *out = &image[(size_t)y * panelWidth + eye * eyeWidth];
+				for (int i = 0; i < eyeWidth; i++) {
+					// NAN fails the comparison and shows black
+					float t = in[i] * toIndex;
+					out[i] = t >= 0 ? table[t < 255 ? (int)t : 255] : 0xff000000;
+				}
+			}
+		}
+	}, 16);
+}
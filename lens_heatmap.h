@@ -0,0 +1,86 @@
+/** @file
+@brief Heatmaps of the distortion and the color separation over the panel
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "lens_model.h"
+#include <stdint.h>
+#include <vector>
+
+// What the heatmap colors each panel pixel by
+enum HeatmapMode {
+	HEATMAP_OFF,
+	HEATMAP_DISPLACEMENT,	// How far green is drawn from the ideal point
+	HEATMAP_RED_BLUE,		// How far apart red and blue of the same ideal point are drawn
+	HEATMAP_GREEN_BLUE,		// Same for green and blue
+	HEATMAP_MODES
+};
+
+const char *heatmapModeName(int mode);
+
+// Colors every ideal panel pixel by how far the model moves it (or how far
+// apart it draws two colors of it) so you can see where the correction is
+// still off without following grid lines. Pixels run from dark blue (nothing)
+// to red (the largest value on either eye), pixels past the fold are black.
+//
+// Where the model draws each pixel (minus the pixel) is kept per eye/color,
+// like the remap tables, and only recomputed for the eyes/colors that were
+// invalidated and the mode actually needs, a row at a time across every core.
+// That's 10 MB per eye/color at 2160x1200.
+class LensHeatmap {
+public:
+	LensHeatmap();
+
+	// Mark an eye/LensColor as changed
+	void invalidate(int eye, int color);
+	void invalidateAll();
+
+	// Recompute whatever mode needs that was invalidated (everything if the
+	// panel size changed) around the centers of projection being drawn
+	// (cop[eye][x/y]). Returns true if the pixels changed.
+	bool update(const LensModel &model, const double cop[2][2], HeatmapMode mode);
+
+	// width() x height() pixels 0xffRRGGBB (QImage::Format_RGB32) with the
+	// rows bottom up like the OpenGL frame buffer
+	const uint32_t *pixels() const { return image.empty() ? 0 : &image[0]; }
+	int width() const { return panelWidth; }
+	int height() const { return panelHeight; }
+
+	double largest(int eye) const { return peak[eye]; }	// Pixels, for the mode last updated
+	double fullScale() const;							// Pixels shown as red
+
+private:
+	void computeField(const LensModel &model, const double cop[2][2], int eye, int color);
+	void computeValues(int eye, HeatmapMode mode);
+	void colorize();
+
+	int panelWidth, panelHeight;
+	std::vector<float> fields[2][3];	// Drawn minus ideal, X/Y interleaved, eye pixels bottom up, NAN past the fold
+	bool dirty[2][3];
+	std::vector<float> values[2];		// What the mode shows for each eye pixel, NAN where the model folds or blows up
+	double peak[2];
+	HeatmapMode shown;
+	std::vector<uint32_t> image;
+};
@@ -0,0 +1,371 @@
+/** @file
+@brief Fast inverse of the lens model (drawn to ideal panel coordinates)
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lens_inverse.h"
+#include "csv_reader.h"
+#include "parallel_for.h"
+
+#include <fstream>
+#include <string.h>
+
+const char *lensInverseStatusName(int status)
+{
+	static const char *names[] = { "ok", "outside", "not_converged" };
+	return status >= 0 && status < 3 ? names[status] : "unknown";
+}
+
+LensInverseReport::LensInverseReport()
+	: points(0), converged(0), outside(0), notConverged(0), maxError(0), sumSquaredError(0), maxSteps(0)
+{
+}
+
+void LensInverseReport::add(const LensInverseReport &other)
+{
+	points += other.points;
+	converged += other.converged;
+	outside += other.outside;
+	notConverged += other.notConverged;
+	maxError = std::max(maxError, other.maxError);
+	sumSquaredError += other.sumSquaredError;
+	maxSteps = std::max(maxSteps, other.maxSteps);
+}
+
+LensInverse::LensInverse()
+	: type(&distortionType(DISTORT_DPOLY3)), maxRadius(0)
+{
+	memset(coeffs, 0, sizeof(coeffs));
+}
+
+LensInverse::LensInverse(const LensModel &model, const LensEyeTransform &transform, int eye, int color, int samples)
+	: transform(transform), type(&distortionType(model.types[eye][color])),
+	maxRadius(lensMaxRadius(model.width, model.height))
+{
+	memcpy(coeffs, model.coeffs[eye][color], sizeof(coeffs));
+	if (!transform.invertible())
+		return;
+
+	// Ideal points outside the eye can't come from the image so the table
+	// doesn't need to go further out than the farthest corner
+	int x0 = eye * model.width / 2;
+	double maxIdeal = 0;
+	for (int corner = 0; corner < 4; corner++) {
+		double dx, dy;
+		transform.forward((corner & 1) ? x0 + model.width / 2 : x0, (corner & 2) ? model.height : 0, dx, dy);
+		maxIdeal = std::max(maxIdeal, sqrt(dx * dx + dy * dy));
+	}
+	radial.build(model, eye, color, maxIdeal * 1.01, samples);
+}
+
+bool LensInverse::solveRadius(double drawn, double &ideal, double &error, int &steps) const
+{
+	double low, high;
+	if (!radial.bracket(drawn, ideal, low, high))
+		return false;
+
+	// With q = (r / maxRadius)^2 and P(q) = 1 + k1*q + k2*q^2 + ... the drawn
+	// radius is r / P(q) and its slope (P(q) - 2q P'(q)) / P(q)^2, which stays
+	// positive up to where the table stops
+	int terms = type->radialTerms;
+	double scale = 1 / (maxRadius * maxRadius);
+	double d, slope;
+	auto evaluate = [&](double r) {
+		double q = r * r * scale;
+		double p = coeffs[terms - 1], dp = terms * coeffs[terms - 1];
+		for (int i = terms - 2; i >= 0; i--) {
+			p = coeffs[i] + q * p;
+			dp = (i + 1) * coeffs[i] + q * dp;
+		}
+		p = 1 + q * p;
+		d = r / p;
+		slope = (p - 2 * q * dp) / (p * p);
+	};
+
+	evaluate(ideal);
+	while (fabs(d - drawn) > LENS_INVERSE_PRECISION && steps < LENS_INVERSE_MAX_STEPS) {
+		// The exact radius stays between low and high, so a step that would
+		// leave them (or can't be taken) bisects instead
+		if (d < drawn)
+			low = ideal;
+		else
+			high = ideal;
+		double next = ideal - (d - drawn) / slope;
+		if (!(slope > 0) || !(next > low && next < high))
+			next = (low + high) / 2;
+		if (next == ideal)
+			break;
+		ideal = next;
+		steps++;
+		evaluate(ideal);
+	}
+	error = fabs(d - drawn);
+	return true;
+}
+
+void LensInverse::solveOffset(double targetX, double targetY, double &offsetX, double &offsetY, double &error, int &steps) const
+{
+	const double h = 1e-3;	// Pixels
+	double x = offsetX, y = offsetY;
+	type->distort(coeffs, maxRadius, x, y);
+	double ex = x - targetX, ey = y - targetY;
+	double squared = ex * ex + ey * ey;
+
+	while (squared > LENS_INVERSE_PRECISION * LENS_INVERSE_PRECISION && steps < LENS_INVERSE_MAX_STEPS) {
+		// Jacobian by forward differences
+		double xdx = offsetX + h, ydx = offsetY, xdy = offsetX, ydy = offsetY + h;
+		type->distort(coeffs, maxRadius, xdx, ydx);
+		type->distort(coeffs, maxRadius, xdy, ydy);
+		double a = (xdx - x) / h, b = (xdy - x) / h;
+		double c = (ydx - y) / h, d = (ydy - y) / h;
+		double det = a * d - b * c;
+		if (fabs(det) < 1e-12)
+			break;
+		double stepX = (d * ex - b * ey) / det;
+		double stepY = (a * ey - c * ex) / det;
+
+		// Near the fold the full step can overshoot onto the wrong branch
+		// so back off until it actually gets closer
+		bool improved = false;
+		for (double t = 1; t > 1.0 / 256 && !improved; t *= 0.5) {
+			double tryX = offsetX - t * stepX, tryY = offsetY - t * stepY;
+			double dx = tryX, dy = tryY;
+			type->distort(coeffs, maxRadius, dx, dy);
+			double trySquared = (dx - targetX) * (dx - targetX) + (dy - targetY) * (dy - targetY);
+			if (trySquared < squared) {
+				offsetX = tryX;
+				offsetY = tryY;
+				x = dx;
+				y = dy;
+				ex = x - targetX;
+				ey = y - targetY;
+				squared = trySquared;
+				improved = true;
+			}
+		}
+		steps++;
+		if (!improved)
+			break;
+	}
+	error = sqrt(squared);
+}
+
+LensInverseStatus LensInverse::invert(double x, double y, double &idealX, double &idealY, double *error, int *steps) const
+{
+	int taken = 0;
+	double residual = 0;
+	if (steps)
+		*steps = 0;
+	if (error)
+		*error = 0;
+	if (!valid())
+		return LENS_INVERSE_OUTSIDE;
+
+	// The radial step scales the offset from the center of projection so the
+	// drawn offset points the same way as the ideal one
+	double ex = x - transform.centerX(), ey = y - transform.centerY();
+	double drawn = sqrt(ex * ex + ey * ey);
+	double ideal;
+	bool inside = true;
+	if (type->radial) {
+		if (!solveRadius(drawn, ideal, residual, taken))
+			return LENS_INVERSE_OUTSIDE;
+	}
+	else if (!radial.ideal(drawn, ideal)) {
+		// The table is only where the other types start from, and their other
+		// terms can draw further out than the radial part alone does
+		inside = false;
+		radial.ideal(radial.maxDrawn(), ideal);
+	}
+
+	double scale = drawn > 1e-9 ? ideal / drawn : 1;
+	double offsetX = ex * scale, offsetY = ey * scale;
+	if (!type->radial)
+		solveOffset(ex, ey, offsetX, offsetY, residual, taken);
+	transform.backward(offsetX, offsetY, idealX, idealY);
+
+	if (steps)
+		*steps = taken;
+	if (error)
+		*error = residual;
+	if (residual <= LENS_INVERSE_TOLERANCE)
+		return LENS_INVERSE_OK;
+	return inside ? LENS_INVERSE_NOT_CONVERGED : LENS_INVERSE_OUTSIDE;
+}
+
+LensInverseReport LensInverse::invert(const double *drawn, double *ideal, size_t count, uint8_t *status) const
+{
+	LensInverseReport report;
+	report.points = count;
+	for (size_t i = 0; i < count; i++) {
+		double error;
+		int steps;
+		LensInverseStatus result = invert(drawn[i * 2], drawn[i * 2 + 1], ideal[i * 2], ideal[i * 2 + 1], &error, &steps);
+		if (status)
+			status[i] = (uint8_t)result;
+
+		report.maxSteps = std::max(report.maxSteps, steps);
+		if (result == LENS_INVERSE_OK) {
+			report.converged++;
+			report.maxError = std::max(report.maxError, error);
+			report.sumSquaredError += error * error;
+			continue;
+		}
+		if (result == LENS_INVERSE_OUTSIDE)
+			report.outside++;
+		else
+			report.notConverged++;
+		ideal[i * 2] = ideal[i * 2 + 1] = NAN;
+	}
+	return report;
+}
+
+LensInverseReport LensInverse::invertParallel(const double *drawn, double *ideal, size_t count, uint8_t *status) const
+{
+	// Chunks of points so counts past what an int holds still work
+	const size_t chunk = 4096;
+	int chunks = (int)((count + chunk - 1) / chunk);
+	std::vector<LensInverseReport> partial(workerThreadCount());
+
+	parallelFor(chunks, [&](int begin, int end, int worker) {
+		for (int i = begin; i < end; i++) {
+			size_t first = i * chunk, n = std::min(chunk, count - first);
+			partial[worker].add(invert(drawn + first * 2, ideal + first * 2, n, status ? status + first : 0));
+		}
+	});
+
+	LensInverseReport report;
+	for (const LensInverseReport &part : partial)
+		report.add(part);
+	return report;
+}
+
+bool loadDrawnPoints(const std::string &filename, std::vector<DrawnPoint> &points, std::string &error)
+{
+	std::ifstream file(filename.c_str());
+	if (!file) {
+		error = "Unable to open " + filename;
+		return false;
+	}
+
+	points.clear();
+	std::string line;
+	int lineNumber = 0;
+	std::vector<std::string> fields;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		if (!csvSplit(line, fields))
+			continue;
+
+		DrawnPoint p;
+		bool ok = fields.size() == 4 && parseLensEye(fields[0].c_str(), p.eye) && parseLensColor(fields[1].c_str(), p.color)
+			&& csvNumber(fields[2], p.x) && csvNumber(fields[3], p.y);
+
+		if (!ok) {
+			// Allow a header line before any data
+			if (points.empty() && lineNumber == 1)
+				continue;
+			std::stringstream msg;
+			msg << filename << ":" << lineNumber << ": expected eye,color,x,y";
+			error = msg.str();
+			return false;
+		}
+		points.push_back(p);
+	}
+
+	if (points.empty()) {
+		error = filename + " does not contain any points";
+		return false;
+	}
+	return true;
+}
+
+void undistortPoints(const LensModel &model, const std::vector<DrawnPoint> &points,
+	std::vector<double> &ideal, std::vector<uint8_t> &status, LensInverseReport reports[2][3])
+{
+	ideal.assign(points.size() * 2, NAN);
+	status.assign(points.size(), LENS_INVERSE_OUTSIDE);
+
+	for (int eye = 0; eye < 2; eye++) {
+		double copX, copY;
+		lensCenterOfProjection(model, eye, copX, copY);
+		LensEyeTransform transform(model, eye, copX, copY);
+
+		for (int color = 0; color < 3; color++) {
+			reports[eye][color] = LensInverseReport();
+
+			// Gathered into one contiguous batch and scattered back after
+			std::vector<size_t> index;
+			std::vector<double> drawn;
+			for (size_t i = 0; i < points.size(); i++) {
+				if (points[i].eye == eye && points[i].color == color) {
+					index.push_back(i);
+					drawn.push_back(points[i].x);
+					drawn.push_back(points[i].y);
+				}
+			}
+			if (index.empty())
+				continue;
+
+			std::vector<double> result(drawn.size());
+			std::vector<uint8_t> batch(index.size());
+			LensInverse inverse(model, transform, eye, color);
+			reports[eye][color] = inverse.invertParallel(&drawn[0], &result[0], index.size(), &batch[0]);
+
+			for (size_t i = 0; i < index.size(); i++) {
+				ideal[index[i] * 2] = result[i * 2];
+				ideal[index[i] * 2 + 1] = result[i * 2 + 1];
+				status[index[i]] = batch[i];
+			}
+		}
+	}
+}
+
+bool writeUndistortedPoints(const std::string &filename, const std::vector<DrawnPoint> &points,
+	const std::vector<double> &ideal, const std::vector<uint8_t> &status, std::string &error)
+{
+	std::ofstream file(filename.c_str());
+	if (!file) {
+		error = "Unable to write " + filename;
+		return false;
+	}
+
+	file.precision(17);
+	file << "eye,color,x,y,ideal_x,ideal_y,status\n";
+	for (size_t i = 0; i < points.size(); i++) {
+		const DrawnPoint &p = points[i];
+		file << lensEyeName(p.eye) << "," << lensColorName(p.color) << "," << p.x << "," << p.y << ",";
+		if (status[i] == LENS_INVERSE_OK)
+			file << ideal[i * 2] << "," << ideal[i * 2 + 1];
+		else
+			file << ",";
+		file << "," << lensInverseStatusName(status[i]) << "\n";
+	}
+
+	if (!file) {
+		error = "Unable to write " + filename;
+		return false;
+	}
+	return true;
+}
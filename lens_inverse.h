@@ -0,0 +1,134 @@
+/** @file
+@brief Fast inverse of the lens model (drawn to ideal panel coordinates)
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "lens_model.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Largest error (pixels) a point is accepted as converged with
+#define LENS_INVERSE_TOLERANCE 0.01
+
+// Newton steps stop once the result is drawn this close (pixels) to the point
+#define LENS_INVERSE_PRECISION 1e-8
+
+// Most Newton (or bisection) steps a single point gets
+#define LENS_INVERSE_MAX_STEPS 48
+
+// How the inverse of one point came out
+enum LensInverseStatus {
+	LENS_INVERSE_OK = 0,			// Drawn within LENS_INVERSE_TOLERANCE of the point
+	LENS_INVERSE_OUTSIDE = 1,		// Nothing inside the eye is drawn there (or past the fold)
+	LENS_INVERSE_NOT_CONVERGED = 2	// The steps couldn't get within LENS_INVERSE_TOLERANCE
+};
+
+const char *lensInverseStatusName(int status);	// ok/outside/not_converged
+
+// What happened to a batch of points
+struct LensInverseReport {
+	size_t points;
+	size_t converged;
+	size_t outside;
+	size_t notConverged;
+	double maxError;		// Worst distance (pixels) a converged result is drawn from its point
+	double sumSquaredError;	// Of the converged points, for the RMS
+	int maxSteps;			// Most Newton steps any point took
+
+	LensInverseReport();
+	void add(const LensInverseReport &other);
+	double rmsError() const { return converged ? sqrt(sumSquaredError / converged) : 0; }
+};
+
+// Where the ideal (undistorted) point drawn at a panel pixel comes from, the
+// inverse of lensDistortWith() for one eye and LensColor.
+//
+// Each point starts from the RadialInverse table. For the purely radial types
+// the radius is then solved by Newton steps kept inside the table cell it
+// came from, falling back to bisection whenever a step would leave it, so it
+// always converges (down to LENS_INVERSE_PRECISION) as long as the point is
+// drawn somewhere inside the eye. The other types take damped Newton steps on
+// both coordinates from there, which can fail near the edge of what they
+// draw; those points are reported rather than returned with a bad answer.
+//
+// Nothing changes after it's built so one can be shared between threads.
+class LensInverse {
+public:
+	LensInverse();
+
+	// Covers ideal points out to the farthest corner of the eye
+	LensInverse(const LensModel &model, const LensEyeTransform &transform, int eye, int color, int samples = 4096);
+
+	bool valid() const { return transform.invertible() && radial.maxDrawn() > 0; }
+
+	// Ideal point drawn at panel pixel (x, y). error is how far (pixels) the
+	// result is drawn from (x, y) and steps how many Newton steps it took.
+	LensInverseStatus invert(double x, double y, double &idealX, double &idealY,
+		double *error = 0, int *steps = 0) const;
+
+	// count points given as x, y pairs. Points that fail get NAN in ideal, and
+	// status (when given) gets a LensInverseStatus for every point.
+	LensInverseReport invert(const double *drawn, double *ideal, size_t count, uint8_t *status = 0) const;
+
+	// Same spread over every core
+	LensInverseReport invertParallel(const double *drawn, double *ideal, size_t count, uint8_t *status = 0) const;
+
+private:
+	// Solve for the ideal radius drawn at radius drawn, exactly for the radial part
+	bool solveRadius(double drawn, double &ideal, double &error, int &steps) const;
+
+	// Polish an offset with Newton steps on the full (not purely radial) type
+	void solveOffset(double targetX, double targetY, double &offsetX, double &offsetY, double &error, int &steps) const;
+
+	LensEyeTransform transform;
+	RadialInverse radial;
+	const DistortionType *type;
+	double coeffs[LENS_MAX_TERMS];
+	double maxRadius;
+};
+
+// A point drawn on the panel, for undistorting whole files of them
+struct DrawnPoint {
+	int eye;				// 0 = left, 1 = right
+	int color;				// LensColor
+	double x, y;			// Full panel pixel coordinates like PointCorrespondence
+};
+
+// Read points from a CSV file with one point per line: eye, color, x, y
+// (names like loadCorrespondences()). Blank lines, # comments and a header
+// line are skipped.
+bool loadDrawnPoints(const std::string &filename, std::vector<DrawnPoint> &points, std::string &error);
+
+// Undistort every point around the center of projection from the intrinsics,
+// each eye/color in one batch across every core. ideal gets an x, y pair per
+// point (NAN when it failed), status a LensInverseStatus per point.
+void undistortPoints(const LensModel &model, const std::vector<DrawnPoint> &points,
+	std::vector<double> &ideal, std::vector<uint8_t> &status, LensInverseReport reports[2][3]);
+
+// eye,color,x,y,ideal_x,ideal_y,status with the ideal point left empty when it failed
+bool writeUndistortedPoints(const std::string &filename, const std::vector<DrawnPoint> &points,
+	const std::vector<double> &ideal, const std::vector<uint8_t> &status, std::string &error);
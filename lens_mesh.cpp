@@ -0,0 +1,201 @@
+/** @file
+@brief SteamVR style per eye distortion mesh with separate red/green/blue coordinates
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "lens_mesh.h"
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+#define MESH_MAGIC 0x4d444d48	// "HMDM"
+#define MESH_VERSION 1				// Of the file format
+
+// Bump whenever the way the vertices are computed changes
+#define MESH_CACHE_VERSION 2
+
+namespace {
+
+	struct MeshFileHeader {
+		uint32_t magic;
+		uint32_t version;
+		int32_t columns, rows;
+		int32_t width, height;
+		uint64_t keys[2];
+	};
+}
+
+EyeSampler::EyeSampler(const LensModel &model, const double cop[2][2], int eye)
+{
+	width = model.width / 2;
+	height = model.height;
+	x0 = eye * width;
+	LensEyeTransform transform(model, eye, cop[eye][0], cop[eye][1]);
+	for (int color = 0; color < 3; color++)
+		inverse[color] = LensInverse(model, transform, eye, color);
+}
+
+void EyeSampler::sample(int color, double x, double y, float uv[2]) const
+{
+	double idealX, idealY;
+	if (inverse[color].invert(x, y, idealX, idealY) != LENS_INVERSE_OK) {
+		uv[0] = uv[1] = MESH_NO_SAMPLE;
+		return;
+	}
+	uv[0] = (float)((idealX - x0) / width);
+	uv[1] = (float)(1 - idealY / height);		// Panel Y goes up, the image down
+}
+
+uint64_t distortionMeshKey(const LensModel &model, const double cop[2][2], int eye, int columns, int rows)
+{
+	CacheKey key("mesh", MESH_CACHE_VERSION);
+	key.add((int32_t)columns).add((int32_t)rows);
+	key.add((int32_t)model.width).add((int32_t)model.height).add((int32_t)eye);
+	for (int color = 0; color < 3; color++) {
+		key.add((int32_t)model.types[eye][color]);
+		for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+			key.add(model.coeffs[eye][color][cof]);
+	}
+	LensEyeTransform transform(model, eye, cop[eye][0], cop[eye][1]);
+	for (int i = 0; i < 9; i++)
+		key.add(transform.matrix()[i]);
+	key.add(cop[eye][0]).add(cop[eye][1]);
+	return key.value();
+}
+
+void buildDistortionMesh(const LensModel &model, const double cop[2][2], int eye, int columns, int rows,
+	DistortionMesh &mesh, CacheStore *cache)
+{
+	columns = std::max(columns, 2);
+	rows = std::max(rows, 2);
+	mesh.columns = columns;
+	mesh.rows = rows;
+
+	uint64_t key = distortionMeshKey(model, cop, eye, columns, rows);
+	if (cache) {
+		const void *data;
+		size_t size;
+		std::shared_ptr<const void> owner = cache->find(key, data, size);
+		if (owner && size == (size_t)columns * rows * sizeof(MeshVertex)) {
+			const MeshVertex *vertices = (const MeshVertex *)data;
+			mesh.vertices.assign(vertices, vertices + columns * rows);
+			return;
+		}
+	}
+
+	mesh.vertices.resize((size_t)columns * rows);
+	EyeSampler sampler(model, cop, eye);
+
+	parallelFor(rows, [&](int begin, int end, int) {
+		for (int row = begin; row < end; row++) {
+			float v = (float)row / (rows - 1);
+			double y = (1 - v) * model.height;
+			for (int column = 0; column < columns; column++) {
+				MeshVertex &vertex = mesh.vertices[(size_t)row * columns + column];
+				float u = (float)column / (columns - 1);
+				double x = sampler.eyeLeft() + u * sampler.eyeWidth();
+
+				vertex.position[0] = u;
+				vertex.position[1] = v;
+				sampler.sample(LENS_RED, x, y, vertex.red);
+				sampler.sample(LENS_GREEN, x, y, vertex.green);
+				sampler.sample(LENS_BLUE, x, y, vertex.blue);
+			}
+		}
+	});
+
+	if (cache)
+		cache->store(key, &mesh.vertices[0], mesh.vertices.size() * sizeof(MeshVertex));
+}
+
+bool saveDistortionMeshes(const std::string &filename, const DistortionMesh meshes[2], int width, int height,
+	const uint64_t keys[2], std::string &error)
+{
+	if (meshes[0].columns != meshes[1].columns || meshes[0].rows != meshes[1].rows) {
+		error = "Both eyes need the same mesh size";
+		return false;
+	}
+
+	MeshFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = MESH_MAGIC;
+	header.version = MESH_VERSION;
+	header.columns = meshes[0].columns;
+	header.rows = meshes[0].rows;
+	header.width = width;
+	header.height = height;
+	header.keys[0] = keys[0];
+	header.keys[1] = keys[1];
+
+	std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file) {
+		error = "Unable to write " + filename;
+		return false;
+	}
+	file.write((const char *)&header, sizeof(header));
+	for (int eye = 0; eye < 2; eye++)
+		file.write((const char *)&meshes[eye].vertices[0], meshes[eye].vertices.size() * sizeof(MeshVertex));
+	if (!file) {
+		error = "Unable to write " + filename;
+		return false;
+	}
+	return true;
+}
+
+bool loadDistortionMeshes(const std::string &filename, DistortionMesh meshes[2], int &width, int &height,
+	uint64_t keys[2], std::string &error)
+{
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if (!file) {
+		error = "Unable to open " + filename;
+		return false;
+	}
+
+	MeshFileHeader header;
+	if (!file.read((char *)&header, sizeof(header)) || header.magic != MESH_MAGIC) {
+		error = filename + " is not a distortion mesh file";
+		return false;
+	}
+	if (header.version != MESH_VERSION || header.columns < 2 || header.rows < 2) {
+		error = filename + " was written by a different version";
+		return false;
+	}
+
+	for (int eye = 0; eye < 2; eye++) {
+		meshes[eye].columns = header.columns;
+		meshes[eye].rows = header.rows;
+		meshes[eye].vertices.resize((size_t)header.columns * header.rows);
+		if (!file.read((char *)&meshes[eye].vertices[0], meshes[eye].vertices.size() * sizeof(MeshVertex))) {
+			error = filename + " is truncated";
+			return false;
+		}
+		keys[eye] = header.keys[eye];
+	}
+	width = header.width;
+	height = header.height;
+	return true;
+}
@@ -0,0 +1,92 @@
+/** @file
+@brief SteamVR style per eye distortion mesh with separate red/green/blue coordinates
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include "lens_model.h"
+#include "lens_inverse.h"
+#include "cache_store.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// SteamVR doesn't evaluate the distortion per pixel, it draws each eye as a
+// grid of vertices and samples the rendered eye image at separate red, green
+// and blue coordinates interpolated across each cell. This builds that mesh
+// from the model so you can check (and ship) what the runtime will sample.
+//
+// Everything is normalized to the eye with (0, 0) at the top left like
+// SteamVR's ComputeDistortion(): position is where the vertex sits on the
+// panel and red/green/blue are where that color is sampled in the eye image.
+// Vertices the model can't be inverted at get MESH_NO_SAMPLE coordinates.
+#define MESH_NO_SAMPLE -1.0f
+
+struct MeshVertex {
+	float position[2];
+	float red[2];
+	float green[2];
+	float blue[2];
+};
+
+struct DistortionMesh {
+	int columns, rows;					// Vertices across/down, row major from the top left
+	std::vector<MeshVertex> vertices;
+};
+
+// Exact sample coordinates for an eye, the values the mesh vertices hold and
+// the mesh interpolates between. cop[eye][x/y] is the center of projection
+// being drawn.
+class EyeSampler {
+public:
+	EyeSampler(const LensModel &model, const double cop[2][2], int eye);
+
+	// Where a LensColor drawn at panel pixel (x, y) is sampled in the eye image
+	void sample(int color, double x, double y, float uv[2]) const;
+
+	int eyeLeft() const { return x0; }
+	int eyeWidth() const { return width; }
+
+private:
+	LensInverse inverse[3];
+	int x0, width, height;
+};
+
+// Key of everything the mesh of an eye is computed from (for the cache and
+// to tell whether an exported mesh still matches the config)
+uint64_t distortionMeshKey(const LensModel &model, const double cop[2][2], int eye, int columns, int rows);
+
+// Build the mesh of an eye, rows in parallel. cop[eye][x/y] is the center of
+// projection being drawn. Looked up in (and added to) cache when given.
+void buildDistortionMesh(const LensModel &model, const double cop[2][2], int eye, int columns, int rows,
+	DistortionMesh &mesh, CacheStore *cache = 0);
+
+// Compact binary file with both eyes: a small header (magic "HMDM", version,
+// size, panel size and the key of each eye) followed by the vertices of the
+// left then the right eye as little endian 32 bit floats.
+bool saveDistortionMeshes(const std::string &filename, const DistortionMesh meshes[2], int width, int height,
+	const uint64_t keys[2], std::string &error);
+bool loadDistortionMeshes(const std::string &filename, DistortionMesh meshes[2], int &width, int &height,
+	uint64_t keys[2], std::string &error);
@@ -0,0 +1,447 @@
+/** @file
+@brief Lens distortion model shared by the widget and the offline tools
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lens_model.h"
+#include <string.h>
+
+namespace {
+
+	template <int N>
+	void distortPolynomial(const double *k, double maxRadius, double &x, double &y)
+	{
+		// N is known at compile time so this unrolls into the same code as DPOLY3
+		double q = (x * x + y * y) / (maxRadius * maxRadius);
+		double sum = k[N - 1];
+		for (int i = N - 2; i >= 0; i--)
+			sum = k[i] + q * sum;
+		double scale = 1 / (1 + q * sum);
+		x *= scale;
+		y *= scale;
+	}
+
+	// The DPOLY3 radial part (k1, k2, k3) plus Brown-Conrady tangential terms
+	// (p1, p2) for lenses that sit tilted or off center, in coordinates
+	// normalized to maxRadius like the radial part
+	void distortBrownConrady(const double *k, double maxRadius, double &x, double &y)
+	{
+		double nx = x / maxRadius, ny = y / maxRadius;
+		double q = nx * nx + ny * ny;
+		double scale = 1 / (1 + q * (k[0] + q * (k[1] + q * k[2])));
+		double p1 = k[3], p2 = k[4];
+
+		double dx = nx * scale + 2 * p1 * nx * ny + p2 * (q + 2 * nx * nx);
+		double dy = ny * scale + p1 * (q + 2 * ny * ny) + 2 * p2 * nx * ny;
+		x = dx * maxRadius;
+		y = dy * maxRadius;
+	}
+
+	// c[0] + c[1]*q + ... + c[degree]*q^degree
+	double polynomial(const double *c, int degree, double q)
+	{
+		double sum = c[degree];
+		for (int i = degree - 1; i >= 0; i--)
+			sum = c[i] + q * sum;
+		return sum;
+	}
+
+	// Every q in [a, b] where the polynomial changes sign (or is exactly 0), in
+	// order. Between two neighbouring roots of the derivative it only goes one
+	// way so each of those pieces holds at most one root, found by bisection.
+	void polynomialRoots(const double *c, int degree, double a, double b, std::vector<double> &roots)
+	{
+		while (degree > 0 && c[degree] == 0)
+			degree--;
+		if (degree == 0)
+			return;
+
+		std::vector<double> ends(1, a);
+		if (degree > 1) {
+			double derivative[LENS_MAX_TERMS];
+			for (int i = 1; i <= degree; i++)
+				derivative[i - 1] = i * c[i];
+			polynomialRoots(derivative, degree - 1, a, b, ends);
+		}
+		ends.push_back(b);
+
+		for (size_t i = 0; i + 1 < ends.size(); i++) {
+			double lo = ends[i], hi = ends[i + 1];
+			double low = polynomial(c, degree, lo), high = polynomial(c, degree, hi);
+			if (low == 0) {
+				if (roots.empty() || roots.back() != lo)
+					roots.push_back(lo);
+				continue;
+			}
+			if (high == 0 || (low < 0) == (high < 0))
+				continue;
+
+			// Down to the last bit
+			for (int iteration = 0; iteration < 64 && hi - lo > 0; iteration++) {
+				double mid = (lo + hi) / 2;
+				if (mid <= lo || mid >= hi)
+					break;
+				if ((polynomial(c, degree, mid) < 0) == (low < 0))
+					lo = mid;
+				else
+					hi = mid;
+			}
+			roots.push_back(hi);
+		}
+		if (polynomial(c, degree, b) == 0 && (roots.empty() || roots.back() != b))
+			roots.push_back(b);
+	}
+
+	// First q in [0, 1] where the polynomial is <= 0, -1 if there's none
+	double firstNonPositive(const double *c, int degree)
+	{
+		if (polynomial(c, degree, 0) <= 0)
+			return 0;
+		std::vector<double> roots;
+		polynomialRoots(c, degree, 0, 1, roots);
+		return roots.empty() ? -1 : roots.front();
+	}
+
+	// A row of panel points (x0 + i * step, y) through an affine eye transform
+	// m and the N term polynomial. Same operations in the same order as
+	// LensEyeTransform::forward() and lensDistortWith() so the results match
+	// to the bit.
+	template <int N>
+	void distortRowPolynomial(const double *k, double maxRadius, const double *m, double copX, double copY,
+		double x0, double step, double y, int count, double *outX, double *outY)
+	{
+		// Locals so the compiler knows the outputs can't change them
+		double c[N], a[6];
+		for (int i = 0; i < N; i++)
+			c[i] = k[i];
+		for (int i = 0; i < 6; i++)
+			a[i] = m[i];
+		double r2Max = maxRadius * maxRadius;
+
+		for (int i = 0; i < count; i++) {
+			double px = x0 + i * step;
+			double offsetX = a[0] * px + a[1] * y + a[2];
+			double offsetY = a[3] * px + a[4] * y + a[5];
+			double q = (offsetX * offsetX + offsetY * offsetY) / r2Max;
+			double sum = c[N - 1];
+			for (int term = N - 2; term >= 0; term--)
+				sum = c[term] + q * sum;
+			double scale = 1 / (1 + q * sum);
+			outX[i] = copX + offsetX * scale;
+			outY[i] = copY + offsetY * scale;
+		}
+	}
+
+	typedef void (*DistortRow)(const double *k, double maxRadius, const double *m, double copX, double copY,
+		double x0, double step, double y, int count, double *outX, double *outY);
+
+	const DistortionType distortionTypes[] = {
+		{ "DISTORT_DPOLY3", 3, 3, true, distortPolynomial<3> },
+		{ "DISTORT_DPOLY4", 4, 4, true, distortPolynomial<4> },
+		{ "DISTORT_DPOLY5", 5, 5, true, distortPolynomial<5> },
+		{ "DISTORT_DPOLY6", 6, 6, true, distortPolynomial<6> },
+		{ "DISTORT_BROWN_CONRADY", 5, 3, false, distortBrownConrady },
+	};
+}
+
+int distortionTypeCount()
+{
+	return sizeof(distortionTypes) / sizeof(distortionTypes[0]);
+}
+
+const DistortionType &distortionType(int type)
+{
+	return distortionTypes[type];
+}
+
+int findDistortionType(const char *name)
+{
+	for (int type = 0; type < distortionTypeCount(); type++)
+		if (strcmp(name, distortionTypes[type].name) == 0)
+			return type;
+	return -1;
+}
+
+const char *lensEyeName(int eye)
+{
+	return eye == 0 ? "left" : "right";
+}
+
+const char *lensColorName(int color)
+{
+	static const char *names[3] = { "green", "blue", "red" };
+	return names[color];
+}
+
+bool parseLensEye(const char *name, int &eye)
+{
+	if (strcmp(name, "left") == 0 || strcmp(name, "LEFT") == 0 || strcmp(name, "0") == 0)
+		eye = 0;
+	else if (strcmp(name, "right") == 0 || strcmp(name, "RIGHT") == 0 || strcmp(name, "1") == 0)
+		eye = 1;
+	else
+		return false;
+	return true;
+}
+
+bool parseLensColor(const char *name, int &color)
+{
+	static const char *upper[3] = { "GREEN", "BLUE", "RED" };
+	for (int col = 0; col < 3; col++) {
+		if (strcmp(name, lensColorName(col)) == 0 || strcmp(name, upper[col]) == 0) {
+			color = col;
+			return true;
+		}
+	}
+	return false;
+}
+
+void lensCenterOfProjection(const LensModel &model, int eye, double &x, double &y)
+{
+	double CxL, CxR, Cy;
+	CxL = model.width / 4;
+	CxR = model.width / 2 + CxL;
+	Cy = model.height / 2;
+
+	if (eye == 0) {
+		x = CxL + (CxL * model.intrinsics[0][0][2]);
+		y = Cy + (Cy * model.intrinsics[0][1][2]);
+	}
+	else {
+		x = CxR + (CxR * model.intrinsics[1][0][2]);
+		y = Cy + (Cy * model.intrinsics[1][1][2]);
+	}
+}
+
+LensEyeTransform::LensEyeTransform()
+	: copX(0), copY(0), projective(false), canInvert(true)
+{
+	for (int i = 0; i < 9; i++)
+		m[i] = inv[i] = (i % 4 == 0) ? 1 : 0;
+}
+
+LensEyeTransform::LensEyeTransform(const LensModel &model, int eye, double copX, double copY)
+	: copX(copX), copY(copY), projective(false), canInvert(false)
+{
+	double aspectX = 1, aspectY = 1;
+	if (model.applyAspect) {
+		aspectX = model.intrinsics[eye][0][0];
+		aspectY = model.intrinsics[eye][1][1];
+	}
+
+	// Offset from the center and the aspect ratio: A * T
+	double a[9] = { aspectX, 0, -aspectX * copX,
+					0, aspectY, -aspectY * copY,
+					0, 0, 1 };
+
+	// The extrinsics give the pose of the eye in the head so a direction the
+	// head sees reaches the eye through the transpose of their rotation.
+	// The usual config only has the IPD offset in there so skip the math then.
+	const double (*e)[4] = model.extrinsics[eye];
+	bool rotated = false;
+	if (model.applyExtrinsics)
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				if (fabs(e[row][col] - (row == col ? 1 : 0)) > 1e-12)
+					rotated = true;
+
+	if (!rotated) {
+		memcpy(m, a, sizeof(m));
+	}
+	else {
+		// Pixels from the center to normalized directions looking down -Z (G),
+		// rotate (R^T) and back to pixels (G^-1) before the aspect ratio
+		double halfX = model.width / 4.0, halfY = model.height / 2.0;
+		double g[3] = { 1 / halfX, 1 / halfY, -1 };
+		double gInv[3] = { halfX, halfY, -1 };
+		double r[9];
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				r[row * 3 + col] = gInv[row] * e[col][row] * g[col];
+
+		// M = diag(aspect) * r * T
+		double t[9] = { 1, 0, -copX, 0, 1, -copY, 0, 0, 1 };
+		double scale[3] = { aspectX, aspectY, 1 };
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++) {
+				double sum = 0;
+				for (int k = 0; k < 3; k++)
+					sum += r[row * 3 + k] * t[k * 3 + col];
+				m[row * 3 + col] = scale[row] * sum;
+			}
+
+		// Keep the bottom right at 1 so it's obvious when it's really just affine
+		if (m[8] != 0) {
+			double w = m[8];
+			for (int i = 0; i < 9; i++)
+				m[i] /= w;
+		}
+		projective = m[6] != 0 || m[7] != 0 || m[8] != 1;
+	}
+
+	// Inverse from the adjugate
+	double det = m[0] * (m[4] * m[8] - m[5] * m[7]) - m[1] * (m[3] * m[8] - m[5] * m[6]) + m[2] * (m[3] * m[7] - m[4] * m[6]);
+	if (fabs(det) < 1e-300) {
+		memset(inv, 0, sizeof(inv));
+		return;
+	}
+	inv[0] = (m[4] * m[8] - m[5] * m[7]) / det;
+	inv[1] = (m[2] * m[7] - m[1] * m[8]) / det;
+	inv[2] = (m[1] * m[5] - m[2] * m[4]) / det;
+	inv[3] = (m[5] * m[6] - m[3] * m[8]) / det;
+	inv[4] = (m[0] * m[8] - m[2] * m[6]) / det;
+	inv[5] = (m[2] * m[3] - m[0] * m[5]) / det;
+	inv[6] = (m[3] * m[7] - m[4] * m[6]) / det;
+	inv[7] = (m[1] * m[6] - m[0] * m[7]) / det;
+	inv[8] = (m[0] * m[4] - m[1] * m[3]) / det;
+	canInvert = true;
+}
+
+void lensDistortWith(const LensModel &model, const LensEyeTransform &transform, int eye, int color,
+	double x, double y, double &outX, double &outY)
+{
+	double offsetX, offsetY;
+	transform.forward(x, y, offsetX, offsetY);
+
+	double maxRadius = lensMaxRadius(model.width, model.height);
+	int type = model.types[eye][color];
+	if (type == DISTORT_DPOLY3) {
+		double r2 = offsetX * offsetX + offsetY * offsetY;
+		double k = lensRadialScale(model.coeffs[eye][color], maxRadius, r2);
+		offsetX *= k;
+		offsetY *= k;
+	}
+	else {
+		distortionTypes[type].distort(model.coeffs[eye][color], maxRadius, offsetX, offsetY);
+	}
+
+	outX = transform.centerX() + offsetX;
+	outY = transform.centerY() + offsetY;
+}
+
+void lensDistortRow(const LensModel &model, const LensEyeTransform &transform, int eye, int color,
+	double x0, double step, double y, int count, double *outX, double *outY)
+{
+	// Affine eye transforms (all but rotated extrinsics) with the polynomial
+	// types take the whole row in one loop
+	static const DistortRow rows[] = { distortRowPolynomial<3>, distortRowPolynomial<4>,
+		distortRowPolynomial<5>, distortRowPolynomial<6> };
+	const double *m = transform.matrix();
+	int type = model.types[eye][color];
+	bool affine = m[6] == 0 && m[7] == 0 && m[8] == 1;
+	if (affine && distortionTypes[type].radial && distortionTypes[type].radialTerms >= 3) {
+		rows[distortionTypes[type].radialTerms - 3](model.coeffs[eye][color], lensMaxRadius(model.width, model.height),
+			m, transform.centerX(), transform.centerY(), x0, step, y, count, outX, outY);
+		return;
+	}
+
+	for (int i = 0; i < count; i++)
+		lensDistortWith(model, transform, eye, color, x0 + i * step, y, outX[i], outY[i]);
+}
+
+void lensDistortAround(const LensModel &model, int eye, int color, double copX, double copY,
+	double x, double y, double &outX, double &outY)
+{
+	lensDistortWith(model, LensEyeTransform(model, eye, copX, copY), eye, color, x, y, outX, outY);
+}
+
+void lensDistort(const LensModel &model, int eye, int color, double x, double y,
+	double &outX, double &outY)
+{
+	double copX, copY;
+	lensCenterOfProjection(model, eye, copX, copY);
+	lensDistortAround(model, eye, color, copX, copY, x, y, outX, outY);
+}
+
+void lensIdentityExtrinsics(double extrinsics[3][4])
+{
+	for (int row = 0; row < 3; row++)
+		for (int col = 0; col < 4; col++)
+			extrinsics[row][col] = row == col ? 1 : 0;
+}
+
+double lensFoldRadius(const LensModel &model, int eye, int color)
+{
+	const double *k = model.coeffs[eye][color];
+	int terms = distortionTypes[model.types[eye][color]].radialTerms;
+
+	// With q = (r / maxRadius)^2 and P(q) = 1 + k1*q + k2*q^2 + ... the drawn
+	// radius is r / P(q). It has to stay finite and positive, P(q) > 0, and
+	// keep growing. Its derivative is (P(q) - 2q P'(q)) / P(q)^2 so that's
+	// G(q) = 1 + (1 - 2) k1*q + (1 - 4) k2*q^2 + ... > 0.
+	double P[LENS_MAX_TERMS + 1], G[LENS_MAX_TERMS + 1];
+	P[0] = G[0] = 1;
+	for (int i = 1; i <= terms; i++) {
+		P[i] = k[i - 1];
+		G[i] = (1 - 2 * i) * k[i - 1];
+	}
+
+	double pole = firstNonPositive(P, terms);
+	double fold = firstNonPositive(G, terms);
+	double q = pole < 0 ? fold : fold < 0 ? pole : std::min(pole, fold);
+	return q < 0 ? -1 : sqrt(q) * lensMaxRadius(model.width, model.height);
+}
+
+void RadialInverse::build(const LensModel &model, int eye, int color, double maxIdeal, int samples)
+{
+	const double *k = model.coeffs[eye][color];
+	int terms = distortionTypes[model.types[eye][color]].radialTerms;
+	double maxRadius = lensMaxRadius(model.width, model.height);
+
+	table.clear();
+	step = limit = fineStep = lastIdeal = 0;
+	if (maxIdeal <= 0 || samples < 2)
+		return;
+
+	// Walk the forward mapping much finer than the table so the linear
+	// interpolation below doesn't add any noticeable error
+	int fine = samples * 8;
+	double h = maxIdeal / fine;
+	std::vector<double> drawn;
+	drawn.reserve(fine + 1);
+	drawn.push_back(0);
+	for (int i = 1; i <= fine; i++) {
+		double r = i * h;
+		double d = r * lensRadialScale(k, terms, maxRadius, r * r);
+		if (!(d > drawn.back()) || !std::isfinite(d))
+			break;
+		drawn.push_back(d);
+	}
+	if (drawn.size() < 2)
+		return;
+
+	limit = drawn.back();
+	step = limit / samples;
+	fineStep = h;
+	lastIdeal = (drawn.size() - 1) * h;
+	table.resize(samples + 1);
+	size_t i = 0;
+	for (int j = 0; j <= samples; j++) {
+		double target = std::min(j * step, limit);
+		while (i + 2 < drawn.size() && drawn[i + 1] < target)
+			i++;
+		double t = (target - drawn[i]) / (drawn[i + 1] - drawn[i]);
+		table[j] = (i + std::max(0.0, std::min(1.0, t))) * h;
+	}
+}
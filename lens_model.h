@@ -0,0 +1,249 @@
+/** @file
+@brief Lens distortion model shared by the widget and the offline tools
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+// Colors in the order SteamVR stores them in the config file
+// ("distortion", "distortion_blue", "distortion_red") which is also
+// the order NLT_Coeffecients uses.
+enum LensColor {
+	LENS_GREEN = 0,
+	LENS_BLUE = 1,
+	LENS_RED = 2
+};
+
+// The draw routines use red (0), green (1), blue (2) so translate those
+// into the config file order.
+inline int drawColorToLensColor(unsigned color)
+{
+	static const int lensColor[3] = { LENS_RED, LENS_GREEN, LENS_BLUE };
+	return lensColor[color];
+}
+
+// Names used in the measurement files and reports
+const char *lensEyeName(int eye);
+const char *lensColorName(int color);
+bool parseLensEye(const char *name, int &eye);		// left/right or 0/1
+bool parseLensColor(const char *name, int &color);	// green/blue/red
+
+// Most coefficients any distortion type uses
+#define LENS_MAX_TERMS 6
+
+// The distortion models a config can ask for with the "type" of each
+// distortion section. Each one has its own evaluator (the polynomials are
+// templates on the number of terms) so the DPOLY3 model SteamVR uses stays
+// as fast as it has always been.
+struct DistortionType {
+	const char *name;		// "type" in the config file
+	int terms;				// Number of "coeffs"
+	int radialTerms;		// Leading coeffs forming the 1 / (1 + k1*r^2 + k2*r^4 + ...) radial part
+	bool radial;			// Nothing but the radial part (RadialInverse is exact)
+
+	// Distort an offset (pixels, aspect ratio applied) from the center of projection
+	void (*distort)(const double *k, double maxRadius, double &x, double &y);
+};
+
+// Index of DISTORT_DPOLY3, also used for configs that don't give a type
+#define DISTORT_DPOLY3 0
+
+int distortionTypeCount();
+const DistortionType &distortionType(int type);
+int findDistortionType(const char *name);	// -1 if unknown
+
+// Copy of the calibration state the math needs so it can be handed to
+// worker threads and the offline tools without touching the widget.
+struct LensModel {
+	int types[2][3];						// Eyes, Colors: index of the DistortionType
+	double coeffs[2][3][LENS_MAX_TERMS];	// Eyes, Colors, Terms (same layout as NLT_Coeffecients)
+	double intrinsics[2][3][3];		// Eyes [3x3] matrix (same layout as Intrinsics)
+	double extrinsics[2][3][4];		// Eyes [3x4] eye to head pose (the top of Extrinsics)
+	int width, height;				// Size of the full panel (both eyes)
+	bool applyAspect;				// Apply the intrinsics aspect ratio like transformPoint() does
+	bool applyExtrinsics;			// Apply the rotation from the extrinsics like transformPoint() does
+};
+
+// The coefficients are normalized to the distance from the eye center to the
+// corner of the eye so SteamVR can keep them in the -1 < X < 1 range.
+// NOTE: Keeps the integer math transformPoint() has always used.
+inline double lensMaxRadius(int width, int height)
+{
+	return sqrt(width / 4 * width / 4 + height / 2 * height / 2);
+}
+
+// Scale applied to the offset from the center of projection for a point at
+// squared distance r2 (in pixels) from it: 1 / (1 + k1*r^2 + k2*r^4 + k3*r^6)
+inline double lensRadialScale(const double k[3], double maxRadius, double r2)
+{
+	double q = r2 / (maxRadius * maxRadius);
+	return 1 / (1 + q * (k[0] + q * (k[1] + q * k[2])));
+}
+
+// Same with any number of terms
+inline double lensRadialScale(const double *k, int terms, double maxRadius, double r2)
+{
+	double q = r2 / (maxRadius * maxRadius);
+	double sum = 0;
+	for (int i = terms - 1; i >= 0; i--)
+		sum = k[i] + q * sum;
+	return 1 / (1 + q * sum);
+}
+
+// Center of projection computed from the intrinsics the same way
+// setDeftCOPVals() does when the linear transform is applied.
+void lensCenterOfProjection(const LensModel &model, int eye, double &x, double &y);
+
+// Everything linear about one eye folded into a single 3x3 matrix: the offset
+// from the center of projection, the rotation from the extrinsics and the
+// aspect ratio from the intrinsics. Built once per eye so each point costs a
+// single multiply (plus a divide when the extrinsics rotate the eye) however
+// many of them are in use.
+//
+// The rotation works on directions where the ideal image of the eye spans
+// -1..1, the same normalized space the intrinsics use. The translation in the
+// extrinsics doesn't move anything at infinity so it has no effect here.
+class LensEyeTransform {
+public:
+	LensEyeTransform();
+	LensEyeTransform(const LensModel &model, int eye, double copX, double copY);
+
+	// Offset (pixels) from the center of projection the radial step works on
+	void forward(double x, double y, double &offsetX, double &offsetY) const
+	{
+		offsetX = m[0] * x + m[1] * y + m[2];
+		offsetY = m[3] * x + m[4] * y + m[5];
+		if (projective) {
+			double w = m[6] * x + m[7] * y + m[8];
+			offsetX /= w;
+			offsetY /= w;
+		}
+	}
+
+	// Panel point that ends up at the given offset
+	void backward(double offsetX, double offsetY, double &x, double &y) const
+	{
+		x = inv[0] * offsetX + inv[1] * offsetY + inv[2];
+		y = inv[3] * offsetX + inv[4] * offsetY + inv[5];
+		if (projective) {
+			double w = inv[6] * offsetX + inv[7] * offsetY + inv[8];
+			x /= w;
+			y /= w;
+		}
+	}
+
+	bool invertible() const { return canInvert; }
+	const double *matrix() const { return m; }	// Row major, for cache keys
+	double centerX() const { return copX; }
+	double centerY() const { return copY; }
+
+private:
+	double m[9];
+	double inv[9];
+	double copX, copY;
+	bool projective;
+	bool canInvert;
+};
+
+// Distort point (x, y) for an eye and a LensColor through a precomposed eye
+// transform. This is the one pass everything else goes through.
+void lensDistortWith(const LensModel &model, const LensEyeTransform &transform, int eye, int color,
+	double x, double y, double &outX, double &outY);
+
+// Distort count points of one panel row, (x0 + i * step, y), into outX/outY.
+// Gives the same results as lensDistortWith() on each point, but for the
+// polynomial types the loop has no branches or calls so it compiles to
+// vector code. Use this for dense maps of the whole panel.
+void lensDistortRow(const LensModel &model, const LensEyeTransform &transform, int eye, int color,
+	double x0, double step, double y, int count, double *outX, double *outY);
+
+// Distort point (x, y) for an eye and a LensColor around the given center of
+// projection. This is transformPoint() without the culling between the eyes.
+// Builds the eye transform every call so loops should use lensDistortWith().
+void lensDistortAround(const LensModel &model, int eye, int color, double copX, double copY,
+	double x, double y, double &outX, double &outY);
+
+// Same as above using the center of projection from the intrinsics
+void lensDistort(const LensModel &model, int eye, int color, double x, double y,
+	double &outX, double &outY);
+
+// Fill in the identity for configs that don't have extrinsics
+void lensIdentityExtrinsics(double extrinsics[3][4]);
+
+// Smallest radius (pixels, up to lensMaxRadius) where the radial part of an
+// eye/color stops being one to one: 1 + k1*r^2 + k2*r^4 + ... reaches 0 or
+// the drawn radius stops growing, which folds the image over. Solved exactly
+// on the polynomials in r^2 so it's cheap enough for every key repeat.
+// Negative when the whole range is fine.
+double lensFoldRadius(const LensModel &model, int eye, int color);
+
+// Inverse of the radial part for one eye/color. Given how far from the center
+// of projection a point is drawn, find how far the ideal point was (both after
+// the aspect ratio is applied). Tabulated since it has no closed form; this
+// is only the starting point LensInverse (lens_inverse.h) polishes.
+class RadialInverse {
+public:
+	RadialInverse() : step(0), limit(0), fineStep(0), lastIdeal(0) {}
+
+	// Tabulate ideal radii [0, maxIdeal] (pixels) of the radial part of an
+	// eye/color. The table stops early if the model folds back on itself
+	// since there's no unique inverse past that.
+	void build(const LensModel &model, int eye, int color, double maxIdeal, int samples = 4096);
+
+	// False when nothing inside the tabulated range is drawn that far out
+	bool ideal(double drawn, double &result) const
+	{
+		if (!(drawn <= limit) || table.empty())
+			return false;
+		double t = drawn / step;
+		int i = std::min((int)t, (int)table.size() - 2);
+		result = table[i] + (t - i) * (table[i + 1] - table[i]);
+		return true;
+	}
+
+	// The interpolated ideal radius plus a range the exact one is sure to be
+	// in, for LensInverse to polish. The table is built from samples a fraction
+	// of a cell apart so the range is a cell plus one of those on each side.
+	bool bracket(double drawn, double &guess, double &low, double &high) const
+	{
+		if (!ideal(drawn, guess))
+			return false;
+		int i = std::min((int)(drawn / step), (int)table.size() - 2);
+		low = std::max(0.0, table[i] - fineStep);
+		high = std::min(lastIdeal, table[i + 1] + fineStep);
+		return true;
+	}
+
+	double maxDrawn() const { return limit; }
+
+private:
+	std::vector<double> table;	// Ideal radius for drawn radius i * step
+	double step;
+	double limit;
+	double fineStep;			// Ideal radius between the samples the table was built from
+	double lastIdeal;			// Last ideal radius sampled
+};
@@ -0,0 +1,493 @@
+/** @file
+@brief Per-channel remap tables for showing an image through the lens model
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "lens_remap.h"
+#include "lens_inverse.h"
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+// Tiles small enough that a tile of all three tables stays in cache
+#define TILE_WIDTH 64
+#define TILE_HEIGHT 32
+
+// Marks a node the model can't be inverted at
+#define FIXED16_MISSING 0x8000
+#define HALF_MISSING 0x7e00
+
+// Bump whenever the way the tables are computed or laid out changes
+#define REMAP_CACHE_VERSION 2
+
+namespace {
+
+	// Stored in front of the nodes of a cached table
+	struct CachedTable {
+		int32_t x0, eyeWidth, nodesX, nodesY;
+		int32_t storage, subsample;
+		float scale;
+		float reserved;
+		double maxError;
+	};
+
+	struct Tiles {
+		int x0, width, height;
+		int columns, rows;
+
+		Tiles(int x0, int width, int height)
+			: x0(x0), width(width), height(height)
+			, columns((width + TILE_WIDTH - 1) / TILE_WIDTH), rows((height + TILE_HEIGHT - 1) / TILE_HEIGHT) {}
+
+		int count() const { return columns * rows; }
+
+		void bounds(int tile, int &left, int &right, int &bottom, int &top) const
+		{
+			left = x0 + (tile % columns) * TILE_WIDTH;
+			right = std::min(x0 + width, left + TILE_WIDTH);
+			bottom = (tile / columns) * TILE_HEIGHT;
+			top = std::min(height, bottom + TILE_HEIGHT);
+		}
+	};
+
+	// IEEE half float conversions (round to nearest, no denormals needed for pixel offsets)
+	uint16_t floatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+		int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+		uint32_t mantissa = bits & 0x7fffff;
+
+		if (exponent <= 0)
+			return sign;
+		if (exponent >= 31)
+			return sign | 0x7bff;	// Clamp to the largest finite half
+
+		uint16_t half = sign | (uint16_t)(exponent << 10) | (uint16_t)(mantissa >> 13);
+		if (mantissa & 0x1000)
+			half++;		// Carries into the exponent correctly
+		return half;
+	}
+
+	inline float halfToFloat(uint16_t half)
+	{
+		uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+		uint32_t exponent = (half >> 10) & 0x1f;
+		uint32_t mantissa = half & 0x3ff;
+		uint32_t bits = exponent == 0 ? sign : sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// Bilinear sample of one 8 bit channel, u/v in pixels
+	inline int sampleChannel(const uint32_t *image, int width, int height, int stride, float u, float v, int shift)
+	{
+		int x = (int)floorf(u), y = (int)floorf(v);
+		float fx = u - x, fy = v - y;
+		int x1 = std::min(x + 1, width - 1), y1 = std::min(y + 1, height - 1);
+		x = std::max(x, 0);
+		y = std::max(y, 0);
+
+		const uint32_t *row0 = image + (size_t)y * stride;
+		const uint32_t *row1 = image + (size_t)y1 * stride;
+		float top = ((row0[x] >> shift) & 0xff) * (1 - fx) + ((row0[x1] >> shift) & 0xff) * fx;
+		float bottom = ((row1[x] >> shift) & 0xff) * (1 - fx) + ((row1[x1] >> shift) & 0xff) * fx;
+		return (int)(top * (1 - fy) + bottom * fy + 0.5f);
+	}
+}
+
+LensRemap::LensRemap(RemapStorage storage, int subsample)
+	: storage(storage), subsample(std::max(subsample, 1)), cache(0), panelWidth(0), panelHeight(0)
+{
+	for (int eye = 0; eye < 2; eye++)
+		for (int color = 0; color < 3; color++)
+			tables[eye][color].nodes = 0;
+	invalidateAll();
+}
+
+void LensRemap::setStorage(RemapStorage newStorage, int newSubsample)
+{
+	storage = newStorage;
+	subsample = std::max(newSubsample, 1);
+	invalidateAll();
+}
+
+void LensRemap::setCache(CacheStore *newCache)
+{
+	cache = newCache;
+}
+
+void LensRemap::invalidate(int eye, int color)
+{
+	dirty[eye][color] = true;
+}
+
+void LensRemap::invalidateAll()
+{
+	for (int eye = 0; eye < 2; eye++)
+		for (int color = 0; color < 3; color++)
+			dirty[eye][color] = true;
+}
+
+bool LensRemap::update(const LensModel &model, const double cop[2][2])
+{
+	if (model.width != panelWidth || model.height != panelHeight) {
+		panelWidth = model.width;
+		panelHeight = model.height;
+		invalidateAll();
+	}
+
+	bool changed = false;
+	for (int eye = 0; eye < 2; eye++) {
+		for (int color = 0; color < 3; color++) {
+			if (dirty[eye][color]) {
+				uint64_t key = cacheKey(model, cop, eye, color);
+				if (!loadCached(key, eye, color)) {
+					build(model, cop, eye, color);
+					measure(model, cop, eye, color);
+					storeCached(key, eye, color);
+				}
+				dirty[eye][color] = false;
+				changed = true;
+			}
+		}
+	}
+	return changed;
+}
+
+uint64_t LensRemap::cacheKey(const LensModel &model, const double cop[2][2], int eye, int color) const
+{
+	// Everything build() reads
+	CacheKey key("remap", REMAP_CACHE_VERSION);
+	key.add((int32_t)storage).add((int32_t)subsample);
+	key.add((int32_t)model.width).add((int32_t)model.height).add((int32_t)eye);
+	key.add((int32_t)model.types[eye][color]);
+	for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+		key.add(model.coeffs[eye][color][cof]);
+	LensEyeTransform transform(model, eye, cop[eye][0], cop[eye][1]);
+	for (int i = 0; i < 9; i++)
+		key.add(transform.matrix()[i]);
+	key.add(cop[eye][0]).add(cop[eye][1]);
+	return key.value();
+}
+
+bool LensRemap::loadCached(uint64_t key, int eye, int color)
+{
+	if (!cache)
+		return false;
+
+	const void *data;
+	size_t size;
+	std::shared_ptr<const void> owner = cache->find(key, data, size);
+	if (!owner || size < sizeof(CachedTable))
+		return false;
+
+	const CachedTable *cached = (const CachedTable *)data;
+	if (cached->storage != storage || cached->subsample != subsample || cached->eyeWidth != panelWidth / 2
+		|| size != sizeof(CachedTable) + (size_t)cached->nodesX * cached->nodesY * 2 * sizeof(uint16_t))
+		return false;
+
+	// Use the nodes straight from the cache
+	Table &table = tables[eye][color];
+	table.x0 = cached->x0;
+	table.eyeWidth = cached->eyeWidth;
+	table.nodesX = cached->nodesX;
+	table.nodesY = cached->nodesY;
+	table.scale = cached->scale;
+	table.maxError = cached->maxError;
+	table.nodes = (const uint16_t *)(cached + 1);
+	table.owner = owner;
+	return true;
+}
+
+void LensRemap::storeCached(uint64_t key, int eye, int color)
+{
+	const Table &table = tables[eye][color];
+	if (!cache || !table.nodes)
+		return;
+
+	CachedTable cached;
+	cached.x0 = table.x0;
+	cached.eyeWidth = table.eyeWidth;
+	cached.nodesX = table.nodesX;
+	cached.nodesY = table.nodesY;
+	cached.storage = storage;
+	cached.subsample = subsample;
+	cached.scale = table.scale;
+	cached.reserved = 0;
+	cached.maxError = table.maxError;
+
+	size_t nodeBytes = (size_t)table.nodesX * table.nodesY * 2 * sizeof(uint16_t);
+	std::vector<char> entry(sizeof(cached) + nodeBytes);
+	memcpy(&entry[0], &cached, sizeof(cached));
+	memcpy(&entry[sizeof(cached)], table.nodes, nodeBytes);
+	cache->store(key, &entry[0], entry.size());
+}
+
+void LensRemap::build(const LensModel &model, const double cop[2][2], int eye, int color)
+{
+	Table &table = tables[eye][color];
+	table.eyeWidth = panelWidth / 2;
+	table.x0 = eye * table.eyeWidth;
+	table.nodesX = table.eyeWidth / subsample + 2;
+	table.nodesY = panelHeight / subsample + 2;
+	table.scale = 1;
+	table.maxError = 0;
+	std::shared_ptr<std::vector<uint16_t> > data(new std::vector<uint16_t>(
+		(size_t)table.nodesX * table.nodesY * 2, storage == REMAP_HALF ? HALF_MISSING : FIXED16_MISSING));
+	table.nodes = &(*data)[0];
+	table.owner = data;
+	if (table.eyeWidth <= 0 || panelHeight <= 0)
+		return;
+
+	int x0 = table.x0;
+	LensInverse inverse(model, LensEyeTransform(model, eye, cop[eye][0], cop[eye][1]), eye, color);
+	if (!inverse.valid())
+		return;
+
+	// Exact displacements first, then quantize once the range is known
+	std::vector<float> exact((size_t)table.nodesX * table.nodesY * 2);
+	std::vector<float> largest(workerThreadCount(), 0.0f);
+	Tiles tiles(0, table.nodesX, table.nodesY);
+	parallelFor(tiles.count(), [&](int begin, int end, int worker) {
+		float maxDisplacement = largest[worker];
+		for (int tile = begin; tile < end; tile++) {
+			int left, right, bottom, top;
+			tiles.bounds(tile, left, right, bottom, top);
+
+			for (int j = bottom; j < top; j++) {
+				float *out = &exact[((size_t)j * table.nodesX + left) * 2];
+				for (int i = left; i < right; i++, out += 2) {
+					double x = x0 + i * subsample, y = j * subsample;
+					double idealX, idealY;
+					if (inverse.invert(x, y, idealX, idealY) != LENS_INVERSE_OK) {
+						out[0] = out[1] = NAN;
+						continue;
+					}
+					out[0] = (float)(idealX - x);
+					out[1] = (float)(idealY - y);
+					maxDisplacement = std::max(maxDisplacement, std::max(fabsf(out[0]), fabsf(out[1])));
+				}
+			}
+		}
+		largest[worker] = maxDisplacement;
+	});
+
+	float maxDisplacement = *std::max_element(largest.begin(), largest.end());
+	table.scale = 32767 / std::max(maxDisplacement, 1.0f);
+	for (size_t i = 0; i < exact.size(); i++) {
+		if (std::isnan(exact[i]))
+			continue;
+		if (storage == REMAP_HALF)
+			(*data)[i] = floatToHalf(exact[i]);
+		else
+			(*data)[i] = (uint16_t)(int16_t)lrintf(exact[i] * table.scale);
+	}
+}
+
+namespace {
+
+	// Bilinear reconstruction of the displacement between four nodes.
+	// Nodes with no weight are skipped so they may be missing.
+	template <RemapStorage storage>
+	inline bool interpolate(const uint16_t *row0, const uint16_t *row1, float fx, float fy, float &dx, float &dy)
+	{
+		const uint16_t *node[4] = { row0, row0 + 2, row1, row1 + 2 };
+		float weight[4] = { (1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy };
+
+		dx = dy = 0;
+		for (int n = 0; n < 4; n++) {
+			if (weight[n] == 0)
+				continue;
+			if (storage == REMAP_HALF) {
+				if (node[n][0] == HALF_MISSING)
+					return false;
+				dx += weight[n] * halfToFloat(node[n][0]);
+				dy += weight[n] * halfToFloat(node[n][1]);
+			}
+			else {
+				if (node[n][0] == FIXED16_MISSING)
+					return false;
+				dx += weight[n] * (int16_t)node[n][0];
+				dy += weight[n] * (int16_t)node[n][1];
+			}
+		}
+		return true;
+	}
+}
+
+bool LensRemap::lookup(int eye, int color, int x, int y, float &idealX, float &idealY) const
+{
+	const Table &table = tables[eye][color];
+	if (!table.nodes)
+		return false;
+
+	int i = (x - table.x0) / subsample, j = y / subsample;
+	if (i < 0 || j < 0 || i + 1 >= table.nodesX || j + 1 >= table.nodesY)
+		return false;
+	float fx = (float)((x - table.x0) - i * subsample) / subsample;
+	float fy = (float)(y - j * subsample) / subsample;
+
+	const uint16_t *row0 = table.nodes + ((size_t)j * table.nodesX + i) * 2;
+	const uint16_t *row1 = row0 + table.nodesX * 2;
+	float dx, dy;
+	if (storage == REMAP_HALF) {
+		if (!interpolate<REMAP_HALF>(row0, row1, fx, fy, dx, dy))
+			return false;
+	}
+	else {
+		if (!interpolate<REMAP_FIXED16>(row0, row1, fx, fy, dx, dy))
+			return false;
+		dx /= table.scale;
+		dy /= table.scale;
+	}
+
+	idealX = x + dx;
+	idealY = y + dy;
+	return true;
+}
+
+void LensRemap::measure(const LensModel &model, const double cop[2][2], int eye, int color)
+{
+	Table &table = tables[eye][color];
+	std::vector<double> worst(workerThreadCount(), 0.0);
+	LensEyeTransform transform(model, eye, cop[eye][0], cop[eye][1]);
+
+	Tiles tiles(table.x0, table.eyeWidth, panelHeight);
+	parallelFor(tiles.count(), [&](int begin, int end, int worker) {
+		double maxError = worst[worker];
+		for (int tile = begin; tile < end; tile++) {
+			int left, right, bottom, top;
+			tiles.bounds(tile, left, right, bottom, top);
+
+			for (int y = bottom; y < top; y++) {
+				for (int x = left; x < right; x++) {
+					float idealX, idealY;
+					if (!lookup(eye, color, x, y, idealX, idealY))
+						continue;
+					// Pixels showing black don't matter
+					if (idealX < table.x0 || idealX > table.x0 + table.eyeWidth - 1 || idealY < 0 || idealY > panelHeight - 1)
+						continue;
+
+					double drawnX, drawnY;
+					lensDistortWith(model, transform, eye, color, idealX, idealY, drawnX, drawnY);
+					maxError = std::max(maxError, sqrt((drawnX - x) * (drawnX - x) + (drawnY - y) * (drawnY - y)));
+				}
+			}
+		}
+		worst[worker] = maxError;
+	});
+
+	table.maxError = *std::max_element(worst.begin(), worst.end());
+}
+
+double LensRemap::maxError() const
+{
+	double error = 0;
+	for (int eye = 0; eye < 2; eye++)
+		for (int color = 0; color < 3; color++)
+			error = std::max(error, tables[eye][color].maxError);
+	return error;
+}
+
+size_t LensRemap::memoryUsed() const
+{
+	size_t bytes = 0;
+	for (int eye = 0; eye < 2; eye++)
+		for (int color = 0; color < 3; color++)
+			if (tables[eye][color].nodes)
+				bytes += (size_t)tables[eye][color].nodesX * tables[eye][color].nodesY * 2 * sizeof(uint16_t);
+	return bytes;
+}
+
+void LensRemap::resample(const uint32_t *image, int imageWidth, int imageHeight, int imageStride, uint32_t *panel) const
+{
+	if (panelWidth <= 0 || panelHeight <= 0 || imageWidth <= 0 || imageHeight <= 0)
+		return;
+	if (storage == REMAP_HALF)
+		resampleAs<REMAP_HALF>(image, imageWidth, imageHeight, imageStride, panel);
+	else
+		resampleAs<REMAP_FIXED16>(image, imageWidth, imageHeight, imageStride, panel);
+}
+
+template <RemapStorage format>
+void LensRemap::resampleAs(const uint32_t *image, int imageWidth, int imageHeight, int imageStride, uint32_t *panel) const
+{
+	// LensColor order: green, blue, red
+	static const int shifts[3] = { 8, 0, 16 };
+	int eyeWidth = panelWidth / 2;
+	float scaleU = (float)(imageWidth - 1) / (eyeWidth - 1);
+	float scaleV = (float)(imageHeight - 1) / (panelHeight - 1);
+	float step = 1.0f / subsample;
+
+	Tiles tiles(0, panelWidth, panelHeight);
+	parallelFor(tiles.count(), [&](int begin, int end, int) {
+		for (int tile = begin; tile < end; tile++) {
+			int left, right, bottom, top;
+			tiles.bounds(tile, left, right, bottom, top);
+
+			for (int y = bottom; y < top; y++) {
+				uint32_t *out = panel + (size_t)y * panelWidth;
+				int j = y / subsample;
+				float fy = (y - j * subsample) * step;
+
+				for (int x = left; x < right; x++) {
+					int eye = x < eyeWidth ? 0 : 1;
+					int x0 = eye * eyeWidth;
+					int i = (x - x0) / subsample;
+					float fx = (x - x0 - i * subsample) * step;
+
+					uint32_t pixel = 0xff000000u;
+					for (int color = 0; color < 3; color++) {
+						const Table &table = tables[eye][color];
+						if (!table.nodes)
+							continue;
+						const uint16_t *row0 = table.nodes + ((size_t)j * table.nodesX + i) * 2;
+						float dx, dy;
+						if (!interpolate<format>(row0, row0 + table.nodesX * 2, fx, fy, dx, dy))
+							continue;
+						if (format == REMAP_FIXED16) {
+							dx /= table.scale;
+							dy /= table.scale;
+						}
+
+						float idealX = x + dx, idealY = y + dy;
+						if (idealX < x0 || idealX > x0 + eyeWidth - 1 || idealY < 0 || idealY > panelHeight - 1)
+							continue;
+						// The image rows go top down, the panel rows bottom up
+						int value = sampleChannel(image, imageWidth, imageHeight, imageStride,
+							(idealX - x0) * scaleU, (panelHeight - 1 - idealY) * scaleV, shifts[color]);
+						pixel |= (uint32_t)value << shifts[color];
+					}
+					out[x] = pixel;
+				}
+			}
+		}
+	});
+}
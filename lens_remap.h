@@ -0,0 +1,117 @@
+/** @file
+@brief Per-channel remap tables for showing an image through the lens model
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include "lens_model.h"
+#include "cache_store.h"
+#include <stdint.h>
+#include <vector>
+
+// How the remap tables are stored. Both keep the displacement from the
+// identity map (where the pixel comes from minus where it is) in 16 bits:
+//    REMAP_FIXED16 - fixed point scaled to the largest displacement in the table
+//    REMAP_HALF    - IEEE half floats, more precise near the center, less at the edges
+enum RemapStorage {
+	REMAP_FIXED16,
+	REMAP_HALF
+};
+
+// Pre-distorts an image the way SteamVR presents it. For every panel pixel and
+// color the table holds where in the (undistorted) eye image that pixel comes
+// from, so showing an image is a single resample pass over the panel.
+//
+// The tables only depend on the model so they are rebuilt for the eyes/colors
+// that were invalidated, in parallel and in tiles so each worker stays within
+// a small block of the panel. They can be kept at a fraction of the panel
+// resolution (every subsample pixels) and bilinearly reconstructed, which
+// together with the 16 bit storage brings a 2160x1200 panel from ~60 MB of
+// floats down to ~30 MB at full resolution, ~7.5 MB at subsample 2 and
+// ~2 MB at subsample 4.
+class LensRemap {
+public:
+	LensRemap(RemapStorage storage = REMAP_FIXED16, int subsample = 1);
+
+	// Changing the storage rebuilds all the tables on the next update()
+	void setStorage(RemapStorage storage, int subsample);
+
+	// Tables are looked up in (and new ones added to) the cache by a key made
+	// from everything they are computed from. Null turns the cache off.
+	void setCache(CacheStore *cache);
+
+	// Mark an eye/LensColor as changed
+	void invalidate(int eye, int color);
+	void invalidateAll();
+
+	// Rebuild whatever was invalidated (everything if the panel size changed)
+	// using the centers of projection being drawn (cop[eye][x/y]).
+	// Returns true if any table changed.
+	bool update(const LensModel &model, const double cop[2][2]);
+
+	// Stretch the image over each eye and resample it through the tables into
+	// a width() x height() buffer. Pixels are 0xffRRGGBB (QImage::Format_RGB32)
+	// and the rows go bottom up like the OpenGL frame buffer.
+	void resample(const uint32_t *image, int imageWidth, int imageHeight, int imageStride, uint32_t *panel) const;
+
+	// Ideal panel position shown at panel pixel (x, y) for an eye/LensColor,
+	// false where the model can't be inverted
+	bool lookup(int eye, int color, int x, int y, float &idealX, float &idealY) const;
+
+	// Largest distance (pixels) between a panel pixel and where the model
+	// (the same math transformPoint() uses) draws the ideal point the tables
+	// return for it. Measured over every pixel that shows part of the image
+	// each time a table is rebuilt.
+	double maxError() const;
+
+	size_t memoryUsed() const;	// Bytes
+	int width() const { return panelWidth; }
+	int height() const { return panelHeight; }
+
+private:
+	struct Table {
+		int x0, eyeWidth;				// Panel columns covered
+		int nodesX, nodesY;				// Samples every subsample pixels (one extra so bilinear never runs off the end)
+		float scale;					// REMAP_FIXED16 units per pixel
+		double maxError;
+		const uint16_t *nodes;			// Interleaved X/Y displacement per node, null if not built
+		std::shared_ptr<const void> owner;	// Keeps nodes valid (our own buffer or a cache mapping)
+	};
+
+	uint64_t cacheKey(const LensModel &model, const double cop[2][2], int eye, int color) const;
+	bool loadCached(uint64_t key, int eye, int color);
+	void storeCached(uint64_t key, int eye, int color);
+	void build(const LensModel &model, const double cop[2][2], int eye, int color);
+	void measure(const LensModel &model, const double cop[2][2], int eye, int color);
+	template <RemapStorage format>
+	void resampleAs(const uint32_t *image, int imageWidth, int imageHeight, int imageStride, uint32_t *panel) const;
+
+	RemapStorage storage;
+	int subsample;
+	CacheStore *cache;
+	int panelWidth, panelHeight;
+	Table tables[2][3];
+	bool dirty[2][3];
+};
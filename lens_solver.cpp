@@ -0,0 +1,346 @@
+/** @file
+@brief Fit the lens model to measured point correspondences
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lens_solver.h"
+#include "csv_reader.h"
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+// Parameters per eye: the coefficients (color * LENS_MAX_TERMS + term), center X/Y, aspect X/Y
+#define SOLVER_COEFFICIENTS (3 * LENS_MAX_TERMS)
+#define SOLVER_PARAMS (SOLVER_COEFFICIENTS + 4)
+
+namespace {
+
+	double &parameter(LensModel &model, int eye, int index)
+	{
+		if (index < SOLVER_COEFFICIENTS)
+			return model.coeffs[eye][index / LENS_MAX_TERMS][index % LENS_MAX_TERMS];
+
+		switch (index - SOLVER_COEFFICIENTS) {
+		case 0:
+			return model.intrinsics[eye][0][2];
+		case 1:
+			return model.intrinsics[eye][1][2];
+		case 2:
+			return model.intrinsics[eye][0][0];
+		default:
+			return model.intrinsics[eye][1][1];
+		}
+	}
+
+	// One eye worth of the least squares problem. Only the parameters listed in
+	// active[] are fitted, the rest keep whatever value the model has.
+	struct EyeProblem {
+		int eye;
+		int count;
+		int active[SOLVER_PARAMS];
+		std::vector<PointCorrespondence> points;
+
+		void residual(const LensModel &model, const PointCorrespondence &p, double &rx, double &ry) const
+		{
+			double x, y;
+			lensDistort(model, eye, p.color, p.idealX, p.idealY, x, y);
+			rx = x - p.observedX;
+			ry = y - p.observedY;
+		}
+
+		// Sum of squared residuals
+		double cost(const LensModel &model) const
+		{
+			int workers = workerThreadCount();
+			std::vector<double> partial(workers, 0.0);
+
+			parallelFor((int)points.size(), [&](int begin, int end, int worker) {
+				double sum = 0;
+				for (int i = begin; i < end; i++) {
+					double rx, ry;
+					residual(model, points[i], rx, ry);
+					sum += rx * rx + ry * ry;
+				}
+				partial[worker] = sum;
+			}, 64);
+
+			double sum = 0;
+			for (double value : partial)
+				sum += value;
+			return sum;
+		}
+
+		// Build J^T J and J^T r using central differences for the Jacobian.
+		// Each worker accumulates its own copy which are summed at the end.
+		double normalEquations(const LensModel &model, double *JtJ, double *Jtr) const
+		{
+			int workers = workerThreadCount();
+			int n = count;
+			std::vector<double> partial(workers * (n * n + n + 1), 0.0);
+
+			parallelFor((int)points.size(), [&](int begin, int end, int worker) {
+				double *pJtJ = &partial[worker * (n * n + n + 1)];
+				double *pJtr = pJtJ + n * n;
+				double *pCost = pJtr + n;
+
+				LensModel local = model;
+				double jx[SOLVER_PARAMS], jy[SOLVER_PARAMS];
+
+				for (int i = begin; i < end; i++) {
+					const PointCorrespondence &p = points[i];
+					double rx, ry;
+					residual(local, p, rx, ry);
+					*pCost += rx * rx + ry * ry;
+
+					for (int j = 0; j < n; j++) {
+						double &value = parameter(local, eye, active[j]);
+						double original = value;
+						double h = 1e-6 * std::max(1.0, fabs(original));
+						double px, py, mx, my;
+
+						value = original + h;
+						residual(local, p, px, py);
+						value = original - h;
+						residual(local, p, mx, my);
+						value = original;
+
+						jx[j] = (px - mx) / (2 * h);
+						jy[j] = (py - my) / (2 * h);
+					}
+
+					for (int a = 0; a < n; a++) {
+						pJtr[a] += jx[a] * rx + jy[a] * ry;
+						for (int b = 0; b <= a; b++)
+							pJtJ[a * n + b] += jx[a] * jx[b] + jy[a] * jy[b];
+					}
+				}
+			}, 64);
+
+			double cost = 0;
+			memset(JtJ, 0, sizeof(double) * n * n);
+			memset(Jtr, 0, sizeof(double) * n);
+			for (int worker = 0; worker < workers; worker++) {
+				const double *pJtJ = &partial[worker * (n * n + n + 1)];
+				for (int i = 0; i < n * n; i++)
+					JtJ[i] += pJtJ[i];
+				for (int i = 0; i < n; i++)
+					Jtr[i] += pJtJ[n * n + i];
+				cost += pJtJ[n * n + n];
+			}
+
+			// Only the lower triangle was accumulated
+			for (int a = 0; a < n; a++)
+				for (int b = a + 1; b < n; b++)
+					JtJ[a * n + b] = JtJ[b * n + a];
+
+			return cost;
+		}
+	};
+
+	void clampCoefficients(LensModel &model, int eye)
+	{
+		for (int col = 0; col < 3; col++)
+			for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+				model.coeffs[eye][col][cof] = std::max(-1.0, std::min(1.0, model.coeffs[eye][col][cof]));
+	}
+}
+
+bool loadCorrespondences(const std::string &filename, std::vector<PointCorrespondence> &points, std::string &error)
+{
+	std::ifstream file(filename.c_str());
+	if (!file) {
+		error = "Unable to open " + filename;
+		return false;
+	}
+
+	points.clear();
+	std::string line;
+	int lineNumber = 0;
+	std::vector<std::string> fields;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		if (!csvSplit(line, fields))
+			continue;
+
+		PointCorrespondence p;
+		bool ok = fields.size() == 6 && parseLensEye(fields[0].c_str(), p.eye) && parseLensColor(fields[1].c_str(), p.color)
+			&& csvNumber(fields[2], p.idealX) && csvNumber(fields[3], p.idealY)
+			&& csvNumber(fields[4], p.observedX) && csvNumber(fields[5], p.observedY);
+
+		if (!ok) {
+			// Allow a header line before any data
+			if (points.empty() && lineNumber == 1)
+				continue;
+			std::stringstream msg;
+			msg << filename << ":" << lineNumber << ": expected eye,color,ideal_x,ideal_y,observed_x,observed_y";
+			error = msg.str();
+			return false;
+		}
+		points.push_back(p);
+	}
+
+	if (points.empty()) {
+		error = filename + " does not contain any correspondences";
+		return false;
+	}
+	return true;
+}
+
+LensSolverReport solveLensModel(LensModel &model, const std::vector<PointCorrespondence> &points,
+	const LensSolverOptions &options)
+{
+	LensSolverReport report;
+	memset(&report, 0, sizeof(report));
+
+	// The solve always uses the full SteamVR pipeline
+	model.applyAspect = true;
+	model.applyExtrinsics = true;
+
+	for (int eye = 0; eye < 2; eye++) {
+		EyeProblem problem;
+		problem.eye = eye;
+		problem.count = 0;
+
+		bool hasColor[3] = { false, false, false };
+		for (const PointCorrespondence &p : points) {
+			if (p.eye == eye) {
+				problem.points.push_back(p);
+				hasColor[p.color] = true;
+			}
+		}
+
+		report.points[eye] = (int)problem.points.size();
+		if (problem.points.empty())
+			continue;
+
+		// As many coefficients as the distortion type of each color has
+		for (int col = 0; col < 3; col++)
+			if (hasColor[col])
+				for (int cof = 0; cof < distortionType(model.types[eye][col]).terms; cof++)
+					problem.active[problem.count++] = col * LENS_MAX_TERMS + cof;
+		if (options.fitCenter) {
+			problem.active[problem.count++] = SOLVER_COEFFICIENTS;
+			problem.active[problem.count++] = SOLVER_COEFFICIENTS + 1;
+		}
+		if (options.fitAspect) {
+			problem.active[problem.count++] = SOLVER_COEFFICIENTS + 2;
+			problem.active[problem.count++] = SOLVER_COEFFICIENTS + 3;
+		}
+
+		int n = problem.count;
+		double JtJ[SOLVER_PARAMS * SOLVER_PARAMS], Jtr[SOLVER_PARAMS];
+		double A[SOLVER_PARAMS * SOLVER_PARAMS], step[SOLVER_PARAMS];
+
+		clampCoefficients(model, eye);
+		double cost = problem.normalEquations(model, JtJ, Jtr);
+		report.rmsBefore[eye] = sqrt(cost / problem.points.size());
+
+		double lambda = 1e-3;
+		int iteration;
+		for (iteration = 0; iteration < options.maxIterations; iteration++) {
+			// Marquardt damping scales the diagonal so the very different
+			// parameter ranges (coefficients vs aspect ratio) don't matter
+			memcpy(A, JtJ, sizeof(double) * n * n);
+			for (int i = 0; i < n; i++) {
+				A[i * n + i] += lambda * std::max(JtJ[i * n + i], 1e-12);
+				step[i] = -Jtr[i];
+			}
+
+			if (!choleskySolve(n, A, step)) {
+				lambda *= 10;
+				continue;
+			}
+
+			LensModel candidate = model;
+			for (int i = 0; i < n; i++)
+				parameter(candidate, eye, problem.active[i]) += step[i];
+			clampCoefficients(candidate, eye);
+
+			double candidateCost = problem.cost(candidate);
+			if (candidateCost < cost) {
+				double improvement = (cost - candidateCost) / std::max(cost, 1e-300);
+				model = candidate;
+				cost = problem.normalEquations(model, JtJ, Jtr);
+				lambda = std::max(lambda / 10, 1e-12);
+				if (improvement < options.tolerance) {
+					report.converged[eye] = true;
+					break;
+				}
+			}
+			else {
+				lambda *= 10;
+				// No step makes it better so we're at the (constrained) minimum
+				if (lambda > 1e12) {
+					report.converged[eye] = true;
+					break;
+				}
+			}
+		}
+
+		report.iterations[eye] = iteration;
+		report.rmsAfter[eye] = sqrt(cost / problem.points.size());
+	}
+
+	return report;
+}
+
+bool choleskySolve(int n, double *A, double *b)
+{
+	// Decompose A = L L^T keeping L in the lower triangle of A
+	for (int j = 0; j < n; j++) {
+		double sum = A[j * n + j];
+		for (int k = 0; k < j; k++)
+			sum -= A[j * n + k] * A[j * n + k];
+		if (sum <= 0)
+			return false;
+		A[j * n + j] = sqrt(sum);
+
+		for (int i = j + 1; i < n; i++) {
+			double value = A[i * n + j];
+			for (int k = 0; k < j; k++)
+				value -= A[i * n + k] * A[j * n + k];
+			A[i * n + j] = value / A[j * n + j];
+		}
+	}
+
+	// Forward substitution L y = b
+	for (int i = 0; i < n; i++) {
+		double value = b[i];
+		for (int k = 0; k < i; k++)
+			value -= A[i * n + k] * b[k];
+		b[i] = value / A[i * n + i];
+	}
+
+	// Back substitution L^T x = y
+	for (int i = n - 1; i >= 0; i--) {
+		double value = b[i];
+		for (int k = i + 1; k < n; k++)
+			value -= A[k * n + i] * b[k];
+		b[i] = value / A[i * n + i];
+	}
+
+	return true;
+}
@@ -0,0 +1,72 @@
+/** @file
+@brief Fit the lens model to measured point correspondences
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "lens_model.h"
+#include <string>
+#include <vector>
+
+// A known grid intersection: where it should be (undistorted panel pixel)
+// and where it has to be drawn so it shows up there through the lens.
+// Both are full panel pixel coordinates, the same space transformPoint() uses.
+struct PointCorrespondence {
+	int eye;				// 0 = left, 1 = right
+	int color;				// LensColor
+	double idealX, idealY;
+	double observedX, observedY;
+};
+
+struct LensSolverOptions {
+	int maxIterations = 100;
+	bool fitCenter = true;		// Fit the center stored in the intrinsics
+	bool fitAspect = true;		// Fit the aspect ratio stored in the intrinsics
+	double tolerance = 1e-10;	// Stop once the relative improvement drops below this
+};
+
+struct LensSolverReport {
+	int points[2];
+	int iterations[2];
+	bool converged[2];
+	double rmsBefore[2];	// Pixels
+	double rmsAfter[2];		// Pixels
+};
+
+// Read correspondences from a CSV file with one point per line:
+//    eye, color, ideal_x, ideal_y, observed_x, observed_y
+// eye is left/right (or 0/1) and color is green/blue/red. Blank lines,
+// lines starting with # and a header line are skipped.
+bool loadCorrespondences(const std::string &filename, std::vector<PointCorrespondence> &points, std::string &error);
+
+// Levenberg-Marquardt fit of the coefficients, center and aspect ratio of each
+// eye that has correspondences. Each color fits as many coefficients as its
+// distortion type has. Colors without points keep their coefficients.
+// Coefficients are kept within the -1 <= X <= 1 range SteamVR accepts.
+LensSolverReport solveLensModel(LensModel &model, const std::vector<PointCorrespondence> &points,
+	const LensSolverOptions &options = LensSolverOptions());
+
+// Solve the symmetric positive definite system A x = b in place (b becomes x)
+// using a Cholesky decomposition. A is n x n row major and is overwritten.
+bool choleskySolve(int n, double *A, double *b);
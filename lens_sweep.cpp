@@ -0,0 +1,272 @@
+/** @file
+@brief Brute force search of the radial coefficients against a target
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "lens_sweep.h"
+#include "parallel_for.h"
+
+#include <QElapsedTimer>
+#include <fstream>
+#include <limits>
+#include <math.h>
+#include <sstream>
+
+namespace {
+
+	// Well mixed 64 bits from any index so each random candidate is the same
+	// whichever worker gets it
+	uint64_t splitMix(uint64_t x)
+	{
+		x += 0x9e3779b97f4a7c15ULL;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+		return x ^ (x >> 31);
+	}
+
+	// -1..1 spread of candidate index over coefficient term
+	double candidateOffset(const SweepOptions &options, int terms, long long index, int term)
+	{
+		if (options.random > 0) {
+			uint64_t bits = splitMix(options.seed * 0x100000001b3ULL + (uint64_t)index * SWEEP_MAX_TERMS + term);
+			return (bits >> 11) * (2.0 / 9007199254740992.0) - 1;
+		}
+
+		if (options.steps <= 1)
+			return 0;
+		for (int t = terms - 1; t > term; t--)
+			index /= options.steps;
+		return 2.0 * (index % options.steps) / (options.steps - 1) - 1;
+	}
+
+	// Best first, no more than keep of them
+	void insertCandidate(std::vector<SweepCandidate> &best, const SweepCandidate &candidate, int keep)
+	{
+		std::vector<SweepCandidate>::iterator at = std::upper_bound(best.begin(), best.end(), candidate,
+			[](const SweepCandidate &a, const SweepCandidate &b) { return a.rms < b.rms; });
+		best.insert(at, candidate);
+		if ((int)best.size() > keep)
+			best.pop_back();
+	}
+
+	// Sum of squared errors of the current coefficients of model, given up on
+	// (returning something > limit) once it passes limit
+	double sweepError(const LensModel &model, const LensEyeTransform &transform, const SweepTarget &target,
+		int eye, int color, double limit)
+	{
+		double sum = 0;
+		if (!target.radii.empty()) {
+			const DistortionType &type = distortionType(model.types[eye][color]);
+			double maxRadius = lensMaxRadius(model.width, model.height);
+			for (const RadiusSample &sample : target.radii) {
+				double error = sample.ideal * lensRadialScale(model.coeffs[eye][color], type.radialTerms, maxRadius, sample.ideal * sample.ideal) - sample.observed;
+				sum += error * error;
+				if (sum > limit)
+					break;
+			}
+			return sum;
+		}
+
+		for (size_t i = 0; i < target.idealX.size(); i++) {
+			double x, y;
+			lensDistortWith(model, transform, eye, color, target.idealX[i], target.idealY[i], x, y);
+			double dx = x - target.drawnX[i], dy = y - target.drawnY[i];
+			sum += dx * dx + dy * dy;
+			if (sum > limit)
+				break;
+		}
+		return sum;
+	}
+
+	size_t targetSize(const SweepTarget &target)
+	{
+		return target.radii.empty() ? target.idealX.size() : target.radii.size();
+	}
+}
+
+void sweepTargetsFromModel(const LensModel &target, int spacing, SweepTarget targets[2][3])
+{
+	// Through the full SteamVR pipeline like the candidates
+	LensModel reference = target;
+	reference.applyAspect = true;
+	reference.applyExtrinsics = true;
+
+	for (int eye = 0; eye < 2; eye++) {
+		double copX, copY;
+		lensCenterOfProjection(reference, eye, copX, copY);
+		LensEyeTransform transform(reference, eye, copX, copY);
+
+		for (int color = 0; color < 3; color++) {
+			SweepTarget &target = targets[eye][color];
+			target = SweepTarget();
+			for (int y = spacing / 2; y < reference.height; y += spacing) {
+				for (int x = eye * reference.width / 2 + spacing / 2; x < (eye + 1) * reference.width / 2; x += spacing) {
+					double drawnX, drawnY;
+					lensDistortWith(reference, transform, eye, color, x, y, drawnX, drawnY);
+					target.idealX.push_back(x);
+					target.idealY.push_back(y);
+					target.drawnX.push_back(drawnX);
+					target.drawnY.push_back(drawnY);
+				}
+			}
+		}
+	}
+}
+
+bool sweepTargetsFromTables(const std::string &directory, SweepTarget targets[2][3], std::string &error)
+{
+	bool found = false;
+	for (int eye = 0; eye < 2; eye++) {
+		for (int color = 0; color < 3; color++) {
+			SweepTarget &target = targets[eye][color];
+			target = SweepTarget();
+
+			std::string filename = directory + "/" + lensEyeName(eye) + "_" + lensColorName(color) + ".csv";
+			if (!std::ifstream(filename.c_str()))
+				continue;
+			if (!loadRadiusTable(filename, target.radii, error))
+				return false;
+			found = true;
+		}
+	}
+
+	if (!found)
+		error = "No radius tables found in \"" + directory + "\" (expected files like left_green.csv)";
+	return found;
+}
+
+void sweepLensModel(const LensModel &current, const SweepTarget targets[2][3], const SweepOptions &options, SweepResult results[2][3])
+{
+	int workers = workerThreadCount();
+
+	// Scored the way SteamVR draws it, like the solver
+	LensModel model = current;
+	model.applyAspect = true;
+	model.applyExtrinsics = true;
+
+	for (int eye = 0; eye < 2; eye++) {
+		double copX, copY;
+		lensCenterOfProjection(model, eye, copX, copY);
+		LensEyeTransform transform(model, eye, copX, copY);
+
+		for (int color = 0; color < 3; color++) {
+			SweepResult &result = results[eye][color];
+			const SweepTarget &target = targets[eye][color];
+			result.swept = options.enabled[eye][color] && !target.empty();
+			result.terms = std::min(SWEEP_MAX_TERMS, distortionType(model.types[eye][color]).radialTerms);
+			result.evaluated = result.rejected = 0;
+			result.rmsBefore = result.seconds = 0;
+			result.best.clear();
+			if (!result.swept)
+				continue;
+
+			QElapsedTimer timer;
+			timer.start();
+
+			int terms = result.terms;
+			long long count = options.random;
+			if (count <= 0) {
+				count = 1;
+				for (int term = 0; term < terms; term++)
+					count *= std::max(options.steps, 1);
+			}
+			count = std::min(count, (long long)std::numeric_limits<int>::max());
+
+			double samples = (double)targetSize(target);
+			result.rmsBefore = sqrt(sweepError(model, transform, target, eye, color, std::numeric_limits<double>::max()) / samples);
+
+			std::vector<std::vector<SweepCandidate> > best(workers);
+			std::vector<long long> evaluated(workers, 0), rejected(workers, 0);
+
+			parallelFor((int)count, [&](int begin, int end, int worker) {
+				LensModel local = model;
+				double *coeffs = local.coeffs[eye][color];
+				std::vector<SweepCandidate> &list = best[worker];
+
+				for (int index = begin; index < end; index++) {
+					bool inRange = true;
+					for (int term = 0; term < terms; term++) {
+						coeffs[term] = model.coeffs[eye][color][term] + options.range * candidateOffset(options, terms, index, term);
+						inRange = inRange && fabs(coeffs[term]) <= 1;
+					}
+					if (!inRange) {
+						rejected[worker]++;
+						continue;
+					}
+
+					// Only has to beat the worst of the list this worker has so far
+					double limit = (int)list.size() < options.keep ? std::numeric_limits<double>::max() : list.back().rms * list.back().rms * samples;
+					double sum = sweepError(local, transform, target, eye, color, limit);
+					evaluated[worker]++;
+					if (sum > limit)
+						continue;
+
+					SweepCandidate candidate;
+					for (int term = 0; term < SWEEP_MAX_TERMS; term++)
+						candidate.coeffs[term] = term < terms ? coeffs[term] : model.coeffs[eye][color][term];
+					candidate.rms = sqrt(sum / samples);
+					insertCandidate(list, candidate, options.keep);
+				}
+			}, 1024);
+
+			for (int worker = 0; worker < workers; worker++) {
+				for (const SweepCandidate &candidate : best[worker])
+					insertCandidate(result.best, candidate, options.keep);
+				result.evaluated += evaluated[worker];
+				result.rejected += rejected[worker];
+			}
+			result.seconds = timer.nsecsElapsed() / 1e9;
+		}
+	}
+}
+
+bool writeSweepResults(const std::string &filename, const SweepResult results[2][3], std::string &error)
+{
+	std::ofstream file(filename.c_str());
+	if (!file) {
+		error = "Unable to write " + filename;
+		return false;
+	}
+
+	file.precision(17);
+	file << "rank,eye,color,k1,k2,k3,rms\n";
+	for (int eye = 0; eye < 2; eye++) {
+		for (int color = 0; color < 3; color++) {
+			const std::vector<SweepCandidate> &best = results[eye][color].best;
+			for (size_t rank = 0; rank < best.size(); rank++) {
+				file << rank + 1 << "," << lensEyeName(eye) << "," << lensColorName(color);
+				for (int term = 0; term < SWEEP_MAX_TERMS; term++)
+					file << "," << best[rank].coeffs[term];
+				file << "," << best[rank].rms << "\n";
+			}
+		}
+	}
+
+	if (!file) {
+		error = "Unable to write " + filename;
+		return false;
+	}
+	return true;
+}
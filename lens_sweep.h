@@ -0,0 +1,90 @@
+/** @file
+@brief Brute force search of the radial coefficients against a target
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include "lens_model.h"
+#include "radius_table.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Most of the leading radial coefficients (k1..k3) a sweep varies
+#define SWEEP_MAX_TERMS 3
+
+// Where one eye/color has to end up. Either ideal points and where they have
+// to be drawn (from a reference config), scored through the full model like
+// transformPoint(), or a radius table scored through the radial part alone.
+struct SweepTarget {
+	std::vector<double> idealX, idealY;
+	std::vector<double> drawnX, drawnY;
+	std::vector<RadiusSample> radii;
+
+	bool empty() const { return idealX.empty() && radii.empty(); }
+};
+
+struct SweepOptions {
+	double range = 0.05;		// Each coefficient is swept over its current value +- range
+	int steps = 41;				// Grid: values per coefficient, steps^3 candidates per eye/color
+	int random = 0;				// When > 0 this many random candidates per eye/color instead of the grid
+	uint64_t seed = 1;			// For the random candidates, the same seed gives the same candidates
+	int keep = 10;				// Best candidates reported per eye/color
+	bool enabled[2][3] = { { true, true, true }, { true, true, true } };	// Eyes, LensColor
+};
+
+struct SweepCandidate {
+	double coeffs[SWEEP_MAX_TERMS];
+	double rms;					// Pixels from the target
+};
+
+struct SweepResult {
+	bool swept;					// Enabled and had a target
+	int terms;					// Coefficients varied
+	long long evaluated;		// Candidates scored (or dropped part way once they couldn't make the list)
+	long long rejected;			// Outside -1 <= X <= 1 so never scored
+	double rmsBefore;			// The current coefficients, pixels
+	double seconds;
+	std::vector<SweepCandidate> best;	// Best first
+};
+
+// Sample the grid of ideal points spacing pixels apart over each eye and
+// where the reference model draws them
+void sweepTargetsFromModel(const LensModel &reference, int spacing, SweepTarget targets[2][3]);
+
+// <directory>/<eye>_<color>.csv like fitRadiusTables(), eye/colors without a
+// table get no target. Fails if a table can't be read or there are none.
+bool sweepTargetsFromTables(const std::string &directory, SweepTarget targets[2][3], std::string &error);
+
+// Score every candidate of each enabled eye/color with a target, spread over
+// the worker threads, always through the full SteamVR pipeline like the
+// solver. Only the first (up to 3) radial coefficients vary, the rest of the
+// model stays as it is. Candidates with a coefficient outside the
+// -1 <= X <= 1 range SteamVR accepts are rejected before they're scored and
+// a candidate stops being scored as soon as it can't make the best list.
+void sweepLensModel(const LensModel &model, const SweepTarget targets[2][3], const SweepOptions &options, SweepResult results[2][3]);
+
+// The best of each eye/color, best first: rank, eye, color, k1, k2, k3, rms
+bool writeSweepResults(const std::string &filename, const SweepResult results[2][3], std::string &error);
@@ -27,9 +27,415 @@ https://github.com/OSVR/distortionizer
 
 #include <QApplication>
 #include "mainwindow.h"
+#include "lens_config.h"
+#include "config_edit.h"
+#include "config_store.h"
+#include "lens_diff.h"
+#include "lens_inverse.h"
+#include "lens_sweep.h"
+#include "mesh_accuracy.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImage>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Mesh sizes compared by --mesh-accuracy
+static const int meshSizes[] = { 8, 12, 16, 24, 32, 48, 64, 96, 128 };
+
+static int usage()
+{
+	printf("Usage:\n"
+		"  distortionizer                   Run the calibration tool\n"
+		"  distortionizer --mesh-accuracy <config.json> [--panel WIDTHxHEIGHT] [--tolerance PIXELS] [--step PIXELS]\n"
+		"                                   Report how closely distortion meshes of different sizes follow the model\n"
+		"  distortionizer --edit <script> <config.json|folder>... [--panel WIDTHxHEIGHT] [--dry-run]\n"
+		"                                   Apply an edit script to every config, see the README for the syntax\n"
+		"  distortionizer --sweep <config.json> --target <reference.json>|--tables <folder> [--steps N|--random N]\n"
+		"                 [--range R] [--keep N] [--seed N] [--panel WIDTHxHEIGHT] [--out results.csv] [--apply]\n"
+		"                                   Search k1..k3 of every eye/color for the best match and rank the results\n"
+		"  distortionizer --undistort <config.json> <points.csv> [--panel WIDTHxHEIGHT] [--out ideal.csv]\n"
+		"                                   Find the ideal (undistorted) point of every drawn point in eye,color,x,y\n"
+		"  distortionizer --compare <before.json> <after.json> [--panel WIDTHxHEIGHT] [--step PIXELS]\n"
+		"                 [--image diff.png] [--scale PIXELS]\n"
+		"                                   Report how far the second config moves each eye/color from the first\n");
+	return 1;
+}
+
+// Compare distortion meshes of different sizes against the exact model of a
+// config and recommend the smallest one within the tolerance
+static int meshAccuracy(int argc, char *argv[])
+{
+	const char *config = 0;
+	int width = 2160, height = 1200;
+	double tolerance = 0.25;
+	int step = 1;
+
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--panel") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+				return usage();
+		}
+		else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+			tolerance = atof(argv[++i]);
+		else if (strcmp(argv[i], "--step") == 0 && i + 1 < argc)
+			step = atoi(argv[++i]);
+		else if (!config && argv[i][0] != '-')
+			config = argv[i];
+		else
+			return usage();
+	}
+	if (!config)
+		return usage();
+
+	LensModel model;
+	std::string error;
+	if (!loadLensModel(config, width, height, model, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		return 1;
+	}
+
+	// SteamVR uses the center from the intrinsics
+	double cop[2][2];
+	for (int eye = 0; eye < 2; eye++)
+		lensCenterOfProjection(model, eye, cop[eye][0], cop[eye][1]);
+
+	MeshAccuracyReport report;
+	std::vector<int> sizes(meshSizes, meshSizes + sizeof(meshSizes) / sizeof(meshSizes[0]));
+	analyseMeshAccuracy(model, cop, sizes, tolerance, report, step);
+
+	printf("%s, %dx%d panel, %d samples in %.2f seconds\n\n", config, width, height, report.samples, report.seconds);
+	printf("Mesh     Color   Max error  RMS error  Max at\n");
+	for (const MeshAccuracy &accuracy : report.sizes) {
+		for (int color = 0; color < 3; color++) {
+			printf("%3dx%-3d  %-6s  %9.3f  %9.3f  %s eye (%.0f, %.0f)\n", accuracy.size, accuracy.size, lensColorName(color),
+				accuracy.maxError[color], accuracy.rmsError[color], lensEyeName(accuracy.maxEye[color]),
+				accuracy.maxX[color], accuracy.maxY[color]);
+		}
+	}
+	printf("\n");
+
+	if (report.recommended == 0) {
+		printf("None of the meshes is within %g pixels\n", tolerance);
+		return 2;
+	}
+	printf("Smallest mesh within %g pixels: %dx%d\n", tolerance, report.recommended, report.recommended);
+	return 0;
+}
+
+// Apply the same edits to a whole folder of headset configs
+static int editConfigFiles(int argc, char *argv[])
+{
+	const char *script = 0;
+	std::vector<std::string> files;
+	int width = 2160, height = 1200;
+	bool dryRun = false;
+
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--panel") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+				return usage();
+		}
+		else if (strcmp(argv[i], "--dry-run") == 0)
+			dryRun = true;
+		else if (argv[i][0] == '-')
+			return usage();
+		else if (!script)
+			script = argv[i];
+		else if (QFileInfo(argv[i]).isDir()) {
+			// Every config in the folder, the same ones the headset switcher lists
+			QFileInfoList entries = QDir(argv[i]).entryInfoList(QStringList() << "*.json", QDir::Files, QDir::Name);
+			for (const QFileInfo &entry : entries)
+				if (!entry.fileName().endsWith(CONFIG_AUTOSAVE_SUFFIX))
+					files.push_back(entry.filePath().toLocal8Bit().constData());
+		}
+		else
+			files.push_back(argv[i]);
+	}
+	if (!script || files.empty())
+		return usage();
+
+	std::vector<ConfigEdit> edits;
+	std::string error;
+	if (!loadEditScript(script, edits, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		return 1;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	std::vector<ConfigEditResult> results = editConfigs(files, edits, width, height, dryRun);
+
+	int failed = 0;
+	for (const ConfigEditResult &result : results) {
+		if (!result.ok) {
+			printf("FAILED     %s: %s\n", result.filename.c_str(), result.error.c_str());
+			failed++;
+		}
+		else if (result.changed == 0)
+			printf("UNCHANGED  %s\n", result.filename.c_str());
+		else
+			printf("%-10s %s: %d values\n", dryRun ? "WOULD EDIT" : "EDITED", result.filename.c_str(), result.changed);
+	}
+	printf("\n%d of %d configs failed, %.2f seconds%s\n", failed, (int)results.size(), timer.nsecsElapsed() / 1e9,
+		dryRun ? " (dry run, nothing was written)" : "");
+	return failed == 0 ? 0 : 2;
+}
+
+// Brute force k1..k3 of a config against a reference config or radius tables
+static int sweepConfig(int argc, char *argv[])
+{
+	const char *config = 0, *reference = 0, *tables = 0, *out = 0;
+	int width = 2160, height = 1200;
+	bool apply = false;
+	SweepOptions options;
+
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--panel") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+				return usage();
+		}
+		else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc)
+			reference = argv[++i];
+		else if (strcmp(argv[i], "--tables") == 0 && i + 1 < argc)
+			tables = argv[++i];
+		else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+			options.steps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--random") == 0 && i + 1 < argc)
+			options.random = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--range") == 0 && i + 1 < argc)
+			options.range = atof(argv[++i]);
+		else if (strcmp(argv[i], "--keep") == 0 && i + 1 < argc)
+			options.keep = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			options.seed = strtoull(argv[++i], 0, 10);
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			out = argv[++i];
+		else if (strcmp(argv[i], "--apply") == 0)
+			apply = true;
+		else if (!config && argv[i][0] != '-')
+			config = argv[i];
+		else
+			return usage();
+	}
+	if (!config || (reference == 0) == (tables == 0))
+		return usage();
+
+	LensModel model;
+	SweepTarget targets[2][3];
+	std::string error;
+	if (!loadLensModel(config, width, height, model, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		return 1;
+	}
+	if (reference) {
+		LensModel target;
+		if (!loadLensModel(reference, width, height, target, error)) {
+			printf("ERROR: %s\n", error.c_str());
+			return 1;
+		}
+		sweepTargetsFromModel(target, 40, targets);
+	}
+	else if (!sweepTargetsFromTables(tables, targets, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		return 1;
+	}
+
+	SweepResult results[2][3];
+	sweepLensModel(model, targets, options, results);
+
+	// The best of each eye/color as set edits so --apply only touches those numbers
+	std::vector<ConfigEdit> edits;
+	printf("Eye    Color   Candidates  Rejected   Seconds  RMS before  RMS best  k1..k3\n");
+	for (int eye = 0; eye < 2; eye++) {
+		for (int color = 0; color < 3; color++) {
+			const SweepResult &result = results[eye][color];
+			if (!result.swept || result.best.empty())
+				continue;
+			const SweepCandidate &best = result.best[0];
+			printf("%-6s %-6s  %10lld  %8lld  %8.2f  %10.4f  %8.4f ", lensEyeName(eye), lensColorName(color),
+				result.evaluated, result.rejected, result.seconds, result.rmsBefore, best.rms);
+			for (int term = 0; term < result.terms; term++)
+				printf(" %.8g", best.coeffs[term]);
+			printf("\n");
+
+			if (best.rms >= result.rmsBefore)
+				continue;
+			for (int term = 0; term < result.terms; term++) {
+				ConfigEdit edit;
+				memset(&edit, 0, sizeof(edit));
+				edit.operation = ConfigEdit::SET;
+				edit.eyes[eye] = true;
+				edit.colors[color] = true;
+				edit.terms[term] = true;
+				edit.values[0] = best.coeffs[term];
+				edits.push_back(edit);
+			}
+		}
+	}
+
+	if (out && !writeSweepResults(out, results, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		return 1;
+	}
+
+	if (apply && !edits.empty()) {
+		ConfigEditResult result = editConfigs(std::vector<std::string>(1, config), edits, width, height, false)[0];
+		if (!result.ok) {
+			printf("ERROR: %s: %s\n", config, result.error.c_str());
+			return 2;
+		}
+		printf("\nApplied to %s: %d values\n", config, result.changed);
+	}
+	return 0;
+}
+
+// Map drawn panel points back to where they come from on the ideal image
+static int undistortFile(int argc, char *argv[])
+{
+	const char *config = 0, *input = 0, *out = 0;
+	int width = 2160, height = 1200;
+
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--panel") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+				return usage();
+		}
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			out = argv[++i];
+		else if (!config && argv[i][0] != '-')
+			config = argv[i];
+		else if (!input && argv[i][0] != '-')
+			input = argv[i];
+		else
+			return usage();
+	}
+	if (!config || !input)
+		return usage();
+
+	LensModel model;
+	std::vector<DrawnPoint> points;
+	std::string error;
+	if (!loadLensModel(config, width, height, model, error) || !loadDrawnPoints(input, points, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		return 1;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	std::vector<double> ideal;
+	std::vector<uint8_t> status;
+	LensInverseReport reports[2][3];
+	undistortPoints(model, points, ideal, status, reports);
+	double seconds = timer.nsecsElapsed() / 1e9;
+
+	LensInverseReport total;
+	printf("Eye    Color       Points   Outside  Failed  Max error  RMS error  Steps\n");
+	for (int eye = 0; eye < 2; eye++) {
+		for (int color = 0; color < 3; color++) {
+			const LensInverseReport &report = reports[eye][color];
+			if (report.points == 0)
+				continue;
+			printf("%-6s %-6s  %10zu  %8zu  %6zu  %9.2e  %9.2e  %5d\n", lensEyeName(eye), lensColorName(color),
+				report.points, report.outside, report.notConverged, report.maxError, report.rmsError(), report.maxSteps);
+			total.add(report);
+		}
+	}
+	printf("\n%zu points in %.3f seconds (%.1f million per second)\n", total.points, seconds,
+		total.points / std::max(seconds, 1e-9) / 1e6);
+
+	if (out && !writeUndistortedPoints(out, points, ideal, status, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		return 1;
+	}
+	return total.notConverged == 0 ? 0 : 2;
+}
+
+// How far a new calibration moves anything compared with an archived one
+static int compareConfigs(int argc, char *argv[])
+{
+	const char *before = 0, *after = 0, *image = 0;
+	int width = 2160, height = 1200;
+	int step = 1;
+	double scale = 1;
+
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--panel") == 0 && i + 1 < argc) {
+			if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+				return usage();
+		}
+		else if (strcmp(argv[i], "--step") == 0 && i + 1 < argc)
+			step = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc)
+			image = argv[++i];
+		else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+			scale = atof(argv[++i]);
+		else if (!before && argv[i][0] != '-')
+			before = argv[i];
+		else if (!after && argv[i][0] != '-')
+			after = argv[i];
+		else
+			return usage();
+	}
+	if (!before || !after)
+		return usage();
+
+	LensModel models[2];
+	const char *files[2] = { before, after };
+	for (int which = 0; which < 2; which++) {
+		std::string error;
+		if (!loadLensModel(files[which], width, height, models[which], error)) {
+			printf("ERROR: %s\n", error.c_str());
+			return 1;
+		}
+	}
+
+	DistortionDiff diff;
+	diffLensModels(models[0], models[1], diff, step);
+
+	printf("%s -> %s, %dx%d panel, %d samples in %.3f seconds\n\n", before, after, width, height,
+		diff.columns * diff.rows, diff.seconds);
+	printf("Eye    Color   Max error        99%%  RMS error  Max at\n");
+	for (int eye = 0; eye < 2; eye++) {
+		for (int color = 0; color < 3; color++) {
+			const DisplacementStats &stats = diff.stats[eye][color];
+			printf("%-6s %-6s  %9.3f  %9.3f  %9.3f  (%.0f, %.0f)", lensEyeName(eye), lensColorName(color),
+				stats.maxError, stats.p99, stats.rmsError, stats.maxX, stats.maxY);
+			if (stats.invalid)
+				printf("  %d samples fold over", stats.invalid);
+			printf("\n");
+		}
+	}
+
+	if (image) {
+		std::vector<uint32_t> pixels;
+		distortionDiffImage(diff, scale, pixels);
+		QImage picture((const uchar *)&pixels[0], diff.columns, diff.rows, diff.columns * 4, QImage::Format_RGB32);
+		if (!picture.save(image)) {
+			printf("ERROR: Unable to write %s\n", image);
+			return 1;
+		}
+		printf("\nDiff image written to %s (%g pixels of movement is full brightness)\n", image, scale);
+	}
+	return 0;
+}
 
 int main(int argc, char *argv[])
 {
+	if (argc > 1 && strcmp(argv[1], "--mesh-accuracy") == 0)
+		return meshAccuracy(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--edit") == 0)
+		return editConfigFiles(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--sweep") == 0)
+		return sweepConfig(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--undistort") == 0)
+		return undistortFile(argc, argv);
+	if (argc > 1 && strcmp(argv[1], "--compare") == 0)
+		return compareConfigs(argc, argv);
 
     QApplication a(argc, argv);
     MainWindow w;
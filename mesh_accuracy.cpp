@@ -0,0 +1,220 @@
+/** @file
+@brief How accurately distortion meshes of different sizes follow the model
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "mesh_accuracy.h"
+#include "lens_mesh.h"
+#include "parallel_for.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+namespace {
+
+	// Exact sample coordinates of one eye as separate U and V planes so the
+	// comparison loops run over contiguous floats
+	struct DenseEye {
+		int columns, rows;
+		std::vector<float> x, y;		// Panel pixel of each sample column/row
+		std::vector<float> u[3], v[3];	// Per LensColor, row major
+	};
+
+	struct Accumulator {
+		double sumSq[3];
+		int count[3];
+		double maxSq[3];
+		int maxEye[3];
+		float maxX[3], maxY[3];
+	};
+
+	void evaluateExact(const LensModel &model, const double cop[2][2], int eye, int step, DenseEye &dense)
+	{
+		EyeSampler sampler(model, cop, eye);
+		dense.columns = (sampler.eyeWidth() + step - 1) / step;
+		dense.rows = (model.height + step - 1) / step;
+		dense.x.resize(dense.columns);
+		dense.y.resize(dense.rows);
+		for (int i = 0; i < dense.columns; i++)
+			dense.x[i] = (float)(sampler.eyeLeft() + i * step);
+		for (int j = 0; j < dense.rows; j++)
+			dense.y[j] = (float)(j * step);
+		for (int color = 0; color < 3; color++) {
+			dense.u[color].resize((size_t)dense.columns * dense.rows);
+			dense.v[color].resize((size_t)dense.columns * dense.rows);
+		}
+
+		parallelFor(dense.rows, [&](int begin, int end, int) {
+			for (int j = begin; j < end; j++) {
+				for (int color = 0; color < 3; color++) {
+					float *u = &dense.u[color][(size_t)j * dense.columns];
+					float *v = &dense.v[color][(size_t)j * dense.columns];
+					for (int i = 0; i < dense.columns; i++) {
+						float uv[2];
+						sampler.sample(color, dense.x[i], dense.y[j], uv);
+						u[i] = uv[0];
+						v[i] = uv[1];
+					}
+				}
+			}
+		});
+	}
+
+	inline const float *vertexColor(const MeshVertex &vertex, int color)
+	{
+		return color == LENS_RED ? vertex.red : color == LENS_GREEN ? vertex.green : vertex.blue;
+	}
+
+	void compare(const DenseEye &dense, const DistortionMesh &mesh, int eye, int eyeWidth, int height,
+		std::vector<Accumulator> &accumulators)
+	{
+		// Which cell each sample column falls in only depends on the mesh size
+		std::vector<int> cellX(dense.columns);
+		std::vector<float> fracX(dense.columns);
+		float x0 = dense.x[0];
+		for (int i = 0; i < dense.columns; i++) {
+			float gx = (dense.x[i] - x0) / eyeWidth * (mesh.columns - 1);
+			cellX[i] = std::min((int)gx, mesh.columns - 2);
+			fracX[i] = gx - cellX[i];
+		}
+
+		parallelFor(dense.rows, [&](int begin, int end, int worker) {
+			Accumulator &acc = accumulators[worker];
+			std::vector<float> errorSq(dense.columns);
+			std::vector<float> rowU[4], rowV[4];
+			for (int corner = 0; corner < 4; corner++) {
+				rowU[corner].resize(dense.columns);
+				rowV[corner].resize(dense.columns);
+			}
+
+			for (int j = begin; j < end; j++) {
+				// Mesh rows go top down
+				float gy = (1 - dense.y[j] / height) * (mesh.rows - 1);
+				int cellY = std::max(0, std::min((int)gy, mesh.rows - 2));
+				float fy = gy - cellY;
+
+				for (int color = 0; color < 3; color++) {
+					// Gather the corners of each sample's cell first so the
+					// interpolation below is a straight loop over floats
+					for (int i = 0; i < dense.columns; i++) {
+						const MeshVertex *top = &mesh.vertices[(size_t)cellY * mesh.columns + cellX[i]];
+						const MeshVertex *bottom = top + mesh.columns;
+						const MeshVertex *corners[4] = { top, top + 1, bottom, bottom + 1 };
+						for (int corner = 0; corner < 4; corner++) {
+							rowU[corner][i] = vertexColor(*corners[corner], color)[0];
+							rowV[corner][i] = vertexColor(*corners[corner], color)[1];
+						}
+					}
+
+					const float *u = &dense.u[color][(size_t)j * dense.columns];
+					const float *v = &dense.v[color][(size_t)j * dense.columns];
+					const float *u00 = &rowU[0][0], *u10 = &rowU[1][0], *u01 = &rowU[2][0], *u11 = &rowU[3][0];
+					const float *v00 = &rowV[0][0], *v10 = &rowV[1][0], *v01 = &rowV[2][0], *v11 = &rowV[3][0];
+					const float *fx = &fracX[0];
+					float *error = &errorSq[0];
+					for (int i = 0; i < dense.columns; i++) {
+						bool upper = fx[i] >= fy;
+						float mu = upper ? u00[i] + fx[i] * (u10[i] - u00[i]) + fy * (u11[i] - u10[i])
+							: u00[i] + fy * (u01[i] - u00[i]) + fx[i] * (u11[i] - u01[i]);
+						float mv = upper ? v00[i] + fx[i] * (v10[i] - v00[i]) + fy * (v11[i] - v10[i])
+							: v00[i] + fy * (v01[i] - v00[i]) + fx[i] * (v11[i] - v01[i]);
+
+						// Samples that show black either way don't count
+						bool valid = u[i] >= 0 && u[i] <= 1 && v[i] >= 0 && v[i] <= 1
+							&& u00[i] != MESH_NO_SAMPLE && u10[i] != MESH_NO_SAMPLE && u01[i] != MESH_NO_SAMPLE && u11[i] != MESH_NO_SAMPLE;
+						float du = (mu - u[i]) * eyeWidth, dv = (mv - v[i]) * height;
+						error[i] = valid ? du * du + dv * dv : -1.0f;
+					}
+
+					for (int i = 0; i < dense.columns; i++) {
+						if (error[i] < 0)
+							continue;
+						acc.sumSq[color] += error[i];
+						acc.count[color]++;
+						if (error[i] > acc.maxSq[color]) {
+							acc.maxSq[color] = error[i];
+							acc.maxEye[color] = eye;
+							acc.maxX[color] = dense.x[i];
+							acc.maxY[color] = dense.y[j];
+						}
+					}
+				}
+			}
+		});
+	}
+}
+
+void analyseMeshAccuracy(const LensModel &model, const double cop[2][2], const std::vector<int> &sizes,
+	double tolerance, MeshAccuracyReport &report, int step)
+{
+	auto start = std::chrono::steady_clock::now();
+	step = std::max(step, 1);
+	report.sizes.clear();
+	report.recommended = 0;
+
+	DenseEye dense[2];
+	for (int eye = 0; eye < 2; eye++)
+		evaluateExact(model, cop, eye, step, dense[eye]);
+	report.samples = 2 * dense[0].columns * dense[0].rows;
+
+	for (int size : sizes) {
+		std::vector<Accumulator> accumulators(workerThreadCount());
+		memset(&accumulators[0], 0, sizeof(Accumulator) * accumulators.size());
+
+		for (int eye = 0; eye < 2; eye++) {
+			DistortionMesh mesh;
+			buildDistortionMesh(model, cop, eye, size, size, mesh);
+			compare(dense[eye], mesh, eye, model.width / 2, model.height, accumulators);
+		}
+
+		MeshAccuracy accuracy;
+		memset(&accuracy, 0, sizeof(accuracy));
+		accuracy.size = std::max(size, 2);
+		for (int color = 0; color < 3; color++) {
+			double sumSq = 0, maxSq = 0;
+			int count = 0;
+			for (const Accumulator &acc : accumulators) {
+				sumSq += acc.sumSq[color];
+				count += acc.count[color];
+				if (acc.maxSq[color] > maxSq) {
+					maxSq = acc.maxSq[color];
+					accuracy.maxEye[color] = acc.maxEye[color];
+					accuracy.maxX[color] = acc.maxX[color];
+					accuracy.maxY[color] = acc.maxY[color];
+				}
+			}
+			accuracy.maxError[color] = sqrt(maxSq);
+			accuracy.rmsError[color] = count ? sqrt(sumSq / count) : 0;
+		}
+		report.sizes.push_back(accuracy);
+
+		double worst = std::max(accuracy.maxError[0], std::max(accuracy.maxError[1], accuracy.maxError[2]));
+		if (worst <= tolerance && (report.recommended == 0 || accuracy.size < report.recommended))
+			report.recommended = accuracy.size;
+	}
+
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
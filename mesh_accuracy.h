@@ -0,0 +1,55 @@
+/** @file
+@brief How accurately distortion meshes of different sizes follow the model
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include "lens_model.h"
+#include <vector>
+
+// Interpolation error of an N x N distortion mesh (see lens_mesh.h) against
+// the exact model. Errors are in eye image pixels: how far the color sampled
+// through the mesh is from where the model says it should be sampled.
+struct MeshAccuracy {
+	int size;					// Vertices across and down each eye
+	double maxError[3];			// Per LensColor, both eyes
+	double rmsError[3];
+	int maxEye[3];				// Where the max error is
+	double maxX[3], maxY[3];	// Panel pixel
+};
+
+struct MeshAccuracyReport {
+	std::vector<MeshAccuracy> sizes;	// In the order they were asked for
+	int recommended;					// Smallest size within the tolerance, 0 if none is
+	int samples;						// Panel pixels the exact model was evaluated at
+	double seconds;
+};
+
+// Evaluate the exact model at every step'th panel pixel once and compare each
+// mesh size against it. The mesh is interpolated linearly over two triangles
+// per cell (split from the top left to the bottom right corner) the way the
+// GPU draws it. tolerance is in pixels.
+void analyseMeshAccuracy(const LensModel &model, const double cop[2][2], const std::vector<int> &sizes,
+	double tolerance, MeshAccuracyReport &report, int step = 1);
@@ -26,6 +26,14 @@ https://github.com/OSVR/distortionizer
 
 
 #include "opengl_widget.h"
+#include "lens_solver.h"
+#include "radius_table.h"
+#include "grid_detector.h"
+#include "lens_mesh.h"
+#include "lens_inverse.h"
+#include "lens_sweep.h"
+#include "lens_config.h"
+#include "config_edit.h"
 
 
 
@@ -33,16 +41,55 @@ https://github.com/OSVR/distortionizer
 #include <QtOpenGL>
 #include <QColor>
 #include <QFileDialog>
+#include <QDir>
+#include <QFileInfo>
 #include <iostream>
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
+#include <sstream>
 #include <QJsonDocument> 
 
 #ifndef GL_MULTISAMPLE
 #define GL_MULTISAMPLE  0x809D
 #endif
+#ifndef GL_BGRA
+#define GL_BGRA  0x80E1
+#endif
 
 #define CONFIG_FILE "HMD_Config.json"
+#define CONFIG_STORE_DIR "HMD_Configs"	// One config per headset, switched between with PageUp/PageDown
+
+// Unsaved values are written next to the config (HMD_Config.autosave.json) every so often while tuning
+#define AUTOSAVE_INTERVAL 30000		// Milliseconds
+#define SAVE_POLL_INTERVAL 250		// Milliseconds between checks for finished saves
+#define JOURNAL_SYNC_INTERVAL 1000	// Milliseconds between syncs of the change journal to disk
+#define CONFIG_RELOAD_DELAY 250	// Milliseconds without further writes before a changed config is reloaded
+#define CONTROL_SOCKET "HMD_Distortionizer"	// Local socket (named pipe on Windows) automation drives the tool through
+#define CORRESPONDENCE_FILE "HMD_Correspondences.csv"
+#define RADIUS_TABLE_DIR "HMD_RadiusTables"
+#define GRID_SPACING 40				// Pixels between the grid lines
+#define DRAG_PICK_RADIUS 15			// Pixels from a drawn grid intersection a click still grabs it
+#define DRAG_ITERATIONS 4			// Gauss-Newton steps per mouse move
+#define SWEEP_FILE "HMD_Sweep.csv"	// Ranked results of the last sweep
+#define SWEEP_STEPS 41				// Values per coefficient, 41^3 candidates per eye/color
+#define SWEEP_RANGE 0.05			// Around the current value
+#define SWEEP_SPACING 40			// Pixels between the points compared against a reference config
+#define CAPTURE_FILE "HMD_Capture.png"
+#define CAPTURE_DIR "HMD_Captures"
+#define TARGET_FILE "HMD_Target.json"
+#define TEST_IMAGE_FILE "HMD_TestImage.png"
+
+// Keep the test image remap tables at every 2nd pixel in 16 bit fixed point (~7.5 MB
+// for a Vive). The error this adds is shown on the overlay and is well under a pixel.
+#define REMAP_STORAGE REMAP_FIXED16
+#define REMAP_SUBSAMPLE 2
+
+#define CACHE_DIR "HMD_Cache"
+
+// Vertices across/down each eye of the exported distortion mesh
+#define MESH_COLUMNS 48
+#define MESH_ROWS 48
 
 //----------------------------------------------------------------------
 // Helper functions
@@ -54,6 +101,10 @@ OpenGL_Widget::OpenGL_Widget(QWidget *parent)
 	, d_cop(QPoint(0, 0))
 	, d_cop_l_Prev(QPoint(0, 0))
 	, d_cop_r_Prev(QPoint(0, 0))
+	, configFile(CONFIG_FILE)
+	, configStore(CONFIG_STORE_DIR)
+	, journal(JOURNAL_SYNC_INTERVAL)
+	, distortionCache(CACHE_DIR)
 
 {
 	using namespace std;
@@ -79,19 +130,68 @@ OpenGL_Widget::OpenGL_Widget(QWidget *parent)
 		<< "J - Reset aspect ratio to default for all active eyes" << endl
 		<< "K - Reset recenter (DOES affect intrensics) for active eye" << endl
 		<< endl
-		<< "S/L: Save/Load state from JSON config file (" << CONFIG_FILE << ")" << endl
+		<< "S/L: Save/Load state from JSON config file (" << CONFIG_FILE << " or the headset picked below)" << endl
+		<< "PAGE UP/PAGE DOWN: Switch to the previous/next headset in the " << CONFIG_STORE_DIR << " folder" << endl
+		<< "D: List the headsets in the " << CONFIG_STORE_DIR << " folder" << endl
+		<< "C: Solve coefficients/center/aspect ratio from measured points (" << CORRESPONDENCE_FILE << ") and save" << endl
+		<< "R: Fit coefficients to the lens radius tables in the " << RADIUS_TABLE_DIR << " folder" << endl
+		<< "O: Sweep k1..k3 of the active eyes/colors against " << TARGET_FILE << " (or the radius tables) and apply the best" << endl
+		<< "P: Measure the grid lines in a photo of the lens (" << CAPTURE_FILE << " or every image in the " << CAPTURE_DIR << " folder)" << endl
+		<< "T: Load the target for the residual metric on the overlay (" << TARGET_FILE << " or " << CORRESPONDENCE_FILE << ")" << endl
+		<< "V: Toggle showing a test image (" << TEST_IMAGE_FILE << ") through the current distortion instead of the grid" << endl
+		<< "F: Color the panel under the grid by distortion/red-blue separation/green-blue separation/off" << endl
+		<< "M: Export the SteamVR style distortion mesh for both eyes (next to the config, HMD_Config.mesh for " << CONFIG_FILE << ")" << endl
+		<< "N: Switch the active eyes/colors to the next distortion type (only DISTORT_DPOLY3 is known to work in SteamVR)" << endl
+		<< "U: Replay the changes a session that crashed or quit never saved" << endl
+		<< "CTRL+Z/CTRL+Y: Undo/redo the last change (holding or repeating a key is one step)" << endl
+		<< "LEFT MOUSE: Drag a grid intersection to where it should be, the active coefficients follow" << endl
 		<< "ESCAPE: Quit the application" << endl
 		<< endl;
 
 	displayOverValues = false;
 
+	// Eyes looking straight ahead until a config says otherwise
 	for (int eye = 0; eye < 2; eye++)
-		for (int color = 0; color < 3; color++)
-			for (int term = 0; term < 3; term++)
+		for (int row = 0; row < 4; row++)
+			for (int col = 0; col < 4; col++)
+				Extrinsics[eye][row][col] = row == col ? 1.0 : 0.0;
+
+	for (int eye = 0; eye < 2; eye++) {
+		for (int color = 0; color < 3; color++) {
+			distortionTypes[eye][color] = DISTORT_DPOLY3;
+			for (int term = 0; term < LENS_MAX_TERMS; term++)
 				NLT_Coeffecients[eye][color][term] = 0.0;
+		}
+	}
 
 	coeffecientOffset = 0.001;
 
+	lensRemap.setStorage(REMAP_STORAGE, REMAP_SUBSAMPLE);
+	lensRemap.setCache(&distortionCache);
+
+	// Saves happen on a background thread, these report how they went and autosave
+	QTimer *saveTimer = new QTimer(this);
+	connect(saveTimer, &QTimer::timeout, this, [=] { reportSaves(); });
+	saveTimer->start(SAVE_POLL_INTERVAL);
+	QTimer *autosaveTimer = new QTimer(this);
+	connect(autosaveTimer, &QTimer::timeout, this, [=] { autosave(); });
+	autosaveTimer->start(AUTOSAVE_INTERVAL);
+
+	// Other programs changing the config while it's open
+	configWatcher = new QFileSystemWatcher(this);
+	connect(configWatcher, &QFileSystemWatcher::fileChanged, this, [=] { configFileChanged(false); });
+	connect(configWatcher, &QFileSystemWatcher::directoryChanged, this, [=] { configFileChanged(true); });
+	configReloadTimer = new QTimer(this);
+	configReloadTimer->setSingleShot(true);
+	configReloadTimer->setInterval(CONFIG_RELOAD_DELAY);
+	connect(configReloadTimer, &QTimer::timeout, this, [=] { reloadChangedConfig(); });
+
+	// Requests from automation are applied together once whatever arrived at the same time is in
+	controlServer.setNotify([=] { QTimer::singleShot(0, this, [=] { handleControlRequests(); }); });
+	QString controlError;
+	if (!controlServer.listen(CONTROL_SOCKET, controlError))
+		printf("NOTE: No control socket \"%s\": %s\n", CONTROL_SOCKET, controlError.toLocal8Bit().constData());
+
 	// Set default settings
 	// TODO: The Intrinsics isn't quite working right yet so it's disabled by default
 	status = LEFT_EYE | RIGHT_EYE | GREEN | BLUE | RED | FIRST_COEFFICIENT | SECOND_COEFFICIENT | THIRD_COEFFICIENT; // | APPLY_LINEAR_TRANSFORM;
@@ -146,105 +246,43 @@ void OpenGL_Widget::initializeGL()
 QPointF OpenGL_Widget::transformPoint(QPointF p, QPointF cop, unsigned color, StatusValues eye, bool debug)
 {
 	QPointF ret = p;
+	int eyeIndex = (eye == LEFT_EYE) ? 0 : 1;
 
 	// SteamVR has three distortion components
 	// Two linear (Intrinsics, and Extrinsics) and the non linear inverse radial distortion. 
 	// The Intrinsics allows you to adjust the center and aspect ratio of each dimention.
-	// We adjust the center in setDeftCOPVals() but here is where we adjust the aspect ratios
-	// TODO: Impliment the Extrinsics
-	if ((status & APPLY_LINEAR_TRANSFORM) == APPLY_LINEAR_TRANSFORM || (status & ONLY_ASEPECT_RATIO) == ONLY_ASEPECT_RATIO) {
-		double x, y;
-		double rX, rY;
-		x = p.x();
-		y = p.y();
-
-		rX = cop.x() - x;
-		rY = cop.y() - y;
-
-		if (eye == LEFT_EYE) {
-			x = cop.x() - (rX*Intrinsics[0][0][0]);
-			y = cop.y() - (rY*Intrinsics[0][1][1]);
-		}
-		else {
-			x = cop.x() - (rX*Intrinsics[1][0][0]);
-			y = cop.y() - (rY*Intrinsics[1][1][1]);
-		}
-		ret.setX(x);
-		ret.setY(y);
-	}
-
+	// We adjust the center in setDeftCOPVals() but the aspect ratios and the rotation from the Extrinsics
+	// are precomposed into one transform per eye so the linear part is a single matrix multiply per point.
+	double offsetX, offsetY;
+	eyeTransform(eyeIndex, cop).forward(p.x(), p.y(), offsetX, offsetY);
+	QPointF offset(offsetX, offsetY);
 
 	// Non linear transform
 	// Formula for reversing the lens distortion obtained form Wikipeida as it is slightly different than what the
 	// original OSVR Distortionizer application was using. 
 	//	https://en.wikipedia.org/wiki/Distortion_(optics)#Software_correction
 
-	// TODO: SteamVR has a "type": "DISTORT_DPOLY3" paramater for each eye's "distortion", "distortion_blue", "distortion_red" section
-	//		and I believe this informs SteamVR to use a different algorithm... So in the future might need to check this value
-	//		to ensure the proper algorithm is being used.
-
-	QPointF offset = ret - cop;
-	double r2 = offset.x() * offset.x() + offset.y() * offset.y();
-	double r = sqrt(r2);
-	double k1, k2, k3;
-
-	switch (color) {
-	case 0:
-		if (eye == LEFT_EYE) {
-			k1 = NLT_Coeffecients[0][2][0];
-			k2 = NLT_Coeffecients[0][2][1];
-			k3 = NLT_Coeffecients[0][2][2];
-		}
-		else {
-			k1 = NLT_Coeffecients[1][2][0];
-			k2 = NLT_Coeffecients[1][2][1];
-			k3 = NLT_Coeffecients[1][2][2];
-		}
-		break;
-	case 1:
-		if (eye == LEFT_EYE) {
-			k1 = NLT_Coeffecients[0][0][0];
-			k2 = NLT_Coeffecients[0][0][1];
-			k3 = NLT_Coeffecients[0][0][2];
-		}
-		else {
-			k1 = NLT_Coeffecients[1][0][0];
-			k2 = NLT_Coeffecients[1][0][1];
-			k3 = NLT_Coeffecients[1][0][2];
-		}
-		break;
-	case 2:
-		if (eye == LEFT_EYE) {
-			k1 = NLT_Coeffecients[0][1][0];
-			k2 = NLT_Coeffecients[0][1][1];
-			k3 = NLT_Coeffecients[0][1][2];
-		}
-		else {
-			k1 = NLT_Coeffecients[1][1][0];
-			k2 = NLT_Coeffecients[1][1][1];
-			k3 = NLT_Coeffecients[1][1][2];
-		}
-		break;
-	}
+	// Each eye/color uses the algorithm named by the "type" of its distortion section.
+	// DISTORT_DPOLY3 (what SteamVR uses) stays inline so the grid draws as fast as ever.
+	int lensColor = drawColorToLensColor(color);
+	const double *coeffs = NLT_Coeffecients[eyeIndex][lensColor];
+	int type = distortionTypes[eyeIndex][lensColor];
 
 	// Normalized fix
 	// SteamVR seems to require these coeffiecnts fall in the range of -1 < X < 1
 	// The original tool was not properly normalizing for non square screens like the Vive.
 	// Also, I believe it was incorrectly scaling them by a factor of 16 so I dropped it from the equation.
-	double maxRadius = sqrt(d_width / 4 * d_width / 4 + d_height / 2 * d_height / 2);
-	k1 = k1 / pow(maxRadius, 2);
-	k2 = k2 / pow(maxRadius, 4);
-	k3 = k3 / pow(maxRadius, 6);
-
-
-	double c1, c2, c3;
-
-	c1 = k1 * pow(r, 2);
-	c2 = k2 * pow(r, 4);
-	c3 = k3 * pow(r, 6);
-	double k = 1 / (1 + c1 + c2 + c3);
-
-	ret = cop + (k * offset);
+	double maxRadius = lensMaxRadius(d_width, d_height);
+	if (type == DISTORT_DPOLY3) {
+		double r2 = offset.x() * offset.x() + offset.y() * offset.y();
+		double k = lensRadialScale(coeffs, maxRadius, r2);
+		ret = cop + (k * offset);
+	}
+	else {
+		double x = offset.x(), y = offset.y();
+		distortionType(type).distort(coeffs, maxRadius, x, y);
+		ret = cop + QPointF(x, y);
+	}
 
 
 	// Cull the two eyes so any drawings on one doesn't overlap with the other. 
@@ -354,7 +392,7 @@ void OpenGL_Widget::drawGrid()
 	// green, and blue line at each location with less than
 	// full brightness.  Draw from the top of the screen to
 	// the bottom.
-	int spacing = 40;
+	int spacing = GRID_SPACING;
 
 	// Vertical lines
 	// Left Eye - Right side of mid point
@@ -441,20 +479,17 @@ void OpenGL_Widget::paintGL()
 	glDisable(GL_TEXTURE_2D);
 
 
-	drawCrossHairs();
-	drawGrid();
-	drawCircles();
-
-	//if (!IntrensicsMode) {
-	//	printf("here");
-	//	drawCrossHairs();
-	//	drawGrid();
-	//	drawCircles();
-	//}
-	//else {
-	//	drawImages();
-	//	drawImagesOverlay();
-	//}
+	if (!imageMode) {
+		if (heatmapMode != HEATMAP_OFF)
+			drawHeatmap();
+		drawCrossHairs();
+		drawGrid();
+		drawCircles();
+	}
+	else {
+		drawImages();
+		drawImagesOverlay();
+	}
 
 	// Draw text overlays
 	// TODO: Figure out why the hell the QPainter is filling the screen with white making the overlay aspect not really work...
@@ -550,6 +585,22 @@ void OpenGL_Widget::paintGL()
 		painter.drawText(rtX + xOffset, rtY + yOffset, msg);
 		yOffset = yOffset + 50;
 
+		// Distortion type without the DISTORT_ prefix every one of them has
+		const char *typeNames[2][3];
+		int maxTerms = 3;
+		for (int eye = 0; eye < 2; eye++) {
+			for (int col = 0; col < 3; col++) {
+				const DistortionType &type = distortionType(distortionTypes[eye][col]);
+				typeNames[eye][col] = strncmp(type.name, "DISTORT_", 8) == 0 ? type.name + 8 : type.name;
+				maxTerms = std::max(maxTerms, type.terms);
+			}
+		}
+		sprintf(msg, "type:   %-13s%-13s%-13s%-13s%-13s%-13s\n", typeNames[0][0], typeNames[0][1], typeNames[0][2],
+			typeNames[1][0], typeNames[1][1], typeNames[1][2]);
+		painter.drawText(ltX + xOffset, ltY + yOffset, msg);
+		painter.drawText(rtX + xOffset, rtY + yOffset, msg);
+		yOffset = yOffset + 50;
+
 		sprintf(msg, "coeff1: %-13.8g%-13.8g%-13.8g%-13.8g%-13.8g%-13.8g\n", NLT_Coeffecients[0][0][0], NLT_Coeffecients[0][1][0],
 			NLT_Coeffecients[0][2][0], NLT_Coeffecients[1][0][0], NLT_Coeffecients[1][1][0], NLT_Coeffecients[1][2][0]);
 		painter.drawText(ltX + xOffset, ltY + yOffset, msg);
@@ -568,6 +619,15 @@ void OpenGL_Widget::paintGL()
 		painter.drawText(rtX + xOffset, rtY + yOffset, msg);
 		yOffset = yOffset + 50;
 
+		// Only the types with more than three coefficients use these
+		for (int cof = 3; cof < maxTerms; cof++) {
+			sprintf(msg, "coeff%d: %-13.8g%-13.8g%-13.8g%-13.8g%-13.8g%-13.8g\n", cof + 1, NLT_Coeffecients[0][0][cof], NLT_Coeffecients[0][1][cof],
+				NLT_Coeffecients[0][2][cof], NLT_Coeffecients[1][0][cof], NLT_Coeffecients[1][1][cof], NLT_Coeffecients[1][2][cof]);
+			painter.drawText(ltX + xOffset, ltY + yOffset, msg);
+			painter.drawText(rtX + xOffset, rtY + yOffset, msg);
+			yOffset = yOffset + 50;
+		}
+
 		sprintf(msg, "Center X: %-13.8g Center Y: %-13.8g     Center X: %-13.8g Center Y: %-13.8g"
 			, Intrinsics[0][0][2], Intrinsics[0][1][2], Intrinsics[1][0][2], Intrinsics[1][1][2]);
 		painter.drawText(ltX + xOffset, ltY + yOffset, msg);
@@ -579,6 +639,61 @@ void OpenGL_Widget::paintGL()
 		painter.drawText(ltX + xOffset, ltY + yOffset, msg);
 		painter.drawText(rtX + xOffset, rtY + yOffset, msg);
 		yOffset = yOffset + 50;
+
+		// Which of the headsets in the config store this is
+		if (!headsetName.isEmpty()) {
+			sprintf(msg, "Headset: %s", headsetName.toLocal8Bit().constData());
+			painter.drawText(ltX + xOffset, ltY + yOffset, msg);
+			painter.drawText(rtX + xOffset, rtY + yOffset, msg);
+			yOffset = yOffset + 50;
+		}
+
+		// Only the eyes/colors changed since the last frame get evaluated again
+		if (residualMetric.hasTarget()) {
+			double cop[2][2] = { { d_cop_l.x(), d_cop_l.y() }, { d_cop_r.x(), d_cop_r.y() } };
+			residualMetric.update(currentLensModel(), cop);
+
+			sprintf(msg, "Bend: %-8.3f R-G: %-8.3f B-G: %-8.3f     Bend: %-8.3f R-G: %-8.3f B-G: %-8.3f",
+				residualMetric.bend(0), residualMetric.redToGreen(0), residualMetric.blueToGreen(0),
+				residualMetric.bend(1), residualMetric.redToGreen(1), residualMetric.blueToGreen(1));
+			painter.drawText(ltX + xOffset, ltY + yOffset, msg);
+			painter.drawText(rtX + xOffset, rtY + yOffset, msg);
+			yOffset = yOffset + 50;
+		}
+
+		if (imageMode) {
+			sprintf(msg, "Remap tables: %.1f MB  Max error: %.3f px", lensRemap.memoryUsed() / (1024.0 * 1024.0), lensRemap.maxError());
+			painter.drawText(ltX + xOffset, ltY + yOffset, msg);
+			painter.drawText(rtX + xOffset, rtY + yOffset, msg);
+			yOffset = yOffset + 50;
+		}
+
+		if (heatmapMode != HEATMAP_OFF && !imageMode) {
+			sprintf(msg, "Heatmap: %s  Largest: %.3f px / %.3f px  (red is %.3f px)", heatmapModeName(heatmapMode),
+				heatmap.largest(0), heatmap.largest(1), heatmap.fullScale());
+			painter.drawText(ltX + xOffset, ltY + yOffset, msg);
+			painter.drawText(rtX + xOffset, rtY + yOffset, msg);
+			yOffset = yOffset + 50;
+		}
+
+		if (!photoSummary.isEmpty()) {
+			painter.drawText(ltX + xOffset, ltY + yOffset, photoSummary);
+			painter.drawText(rtX + xOffset, rtY + yOffset, photoSummary);
+			yOffset = yOffset + 50;
+		}
+
+		if (!dragStatus.isEmpty()) {
+			painter.drawText(ltX + xOffset, ltY + yOffset, dragStatus);
+			painter.drawText(rtX + xOffset, rtY + yOffset, dragStatus);
+			yOffset = yOffset + 50;
+		}
+
+		// The last coefficient change that was refused because it folds the image
+		if (!foldWarning.isEmpty()) {
+			painter.drawText(ltX + xOffset, ltY + yOffset, foldWarning);
+			painter.drawText(rtX + xOffset, rtY + yOffset, foldWarning);
+			yOffset = yOffset + 50;
+		}
 		painter.end();
 	}
 }
@@ -659,12 +774,31 @@ void OpenGL_Widget::setDeftCOPVals() {
 		d_cop_r = d_cop_r_Prev;
 	}
 
+	lensChanged(LEFT_EYE | RIGHT_EYE, GREEN | BLUE | RED);
 }
 
 void OpenGL_Widget::keyPressEvent(QKeyEvent *event)
 {
 	StatusValues toggle = NO_VALUE;
 
+	// Undo/redo are handled before anything else so they never become steps themselves
+	CalibrationState before = calibrationState();
+	history.sync(before);
+	if (event->modifiers() & Qt::ControlModifier) {
+		if (event->key() == Qt::Key_Z && !(event->modifiers() & Qt::ShiftModifier)) {
+			undo();
+			journalChange(calibrationState());
+			updateGL();
+			return;
+		}
+		if (event->key() == Qt::Key_Y || event->key() == Qt::Key_Z) {
+			redo();
+			journalChange(calibrationState());
+			updateGL();
+			return;
+		}
+	}
+
 	switch (event->key()) {
 	case Qt::Key_Escape:
 		QApplication::quit();
@@ -672,12 +806,51 @@ void OpenGL_Widget::keyPressEvent(QKeyEvent *event)
 	case Qt::Key_S: // Save the state to an output file.
 					// XXX Would like to throw a dialog box, but it shows in HMD
 					// and cannot be moved.
-		saveConfigToJson(CONFIG_FILE);
+		saveConfigToJson(configFile);
 		break;
 	case Qt::Key_L: // Load the state from an output file.
 					// XXX Would like to throw a dialog box, but it shows in HMD
 					// and cannot be moved.
-		loadConfigFromJson(CONFIG_FILE);
+		loadConfigFromJson(configFile);
+		break;
+	case Qt::Key_PageDown: // Next headset in the config store
+		switchHeadset(1);
+		break;
+	case Qt::Key_PageUp:
+		switchHeadset(-1);
+		break;
+	case Qt::Key_D: // List the headsets in the config store
+		listHeadsets();
+		break;
+	case Qt::Key_U: // Replay the changes a crashed session never saved
+		replayJournal();
+		break;
+	case Qt::Key_C: // Solve from measured points and save the result
+		solveFromCorrespondences();
+		break;
+	case Qt::Key_R: // Fit the coefficients to the vendor radius tables
+		importRadiusTables();
+		break;
+	case Qt::Key_O: // Search the coefficients around the current ones for the best match to the target
+		sweepCoefficients();
+		break;
+	case Qt::Key_P: // Measure the grid in a photo taken through the lens
+		analysePhoto();
+		break;
+	case Qt::Key_T: // Load the target the residual metric compares against
+		loadResidualTarget();
+		break;
+	case Qt::Key_V: // Show the test image through the lens model
+		toggleImageMode();
+		break;
+	case Qt::Key_F: // Next heatmap under the grid
+		cycleHeatmap();
+		break;
+	case Qt::Key_M: // Export the distortion mesh
+		exportDistortionMesh();
+		break;
+	case Qt::Key_N: // Next distortion type
+		cycleDistortionType();
 		break;
 
 		// Toggle coeffiecents
@@ -802,6 +975,11 @@ void OpenGL_Widget::keyPressEvent(QKeyEvent *event)
 		break;
 	}
 
+	// Runs of the same key (and modifiers) are merged into one step
+	CalibrationState after = calibrationState();
+	history.record(after, event->key() | (int)event->modifiers());
+	if (memcmp(&before, &after, sizeof(after)) != 0)
+		journalChange(after);
 	updateGL();
 }
 
@@ -809,13 +987,61 @@ void OpenGL_Widget::keyPressEvent(QKeyEvent *event)
 
 void OpenGL_Widget::mousePressEvent(QMouseEvent *event)
 {
+	if (event->button() != Qt::LeftButton)
+		return;
+
+	// GL has Y going up
+	QPointF pointer(event->x(), d_height - 1 - event->y());
+	int eye = pointer.x() < d_width / 2 ? 0 : 1;
+	QPointF cop = eye == 0 ? d_cop_l : d_cop_r;
+	StatusValues eyeFlag = eye == 0 ? LEFT_EYE : RIGHT_EYE;
+	if ((status & eyeFlag) != eyeFlag)
+		return;
+
+	// The drawn grid of the first active color is what's being grabbed
+	const StatusValues colorFlags[3] = { GREEN, BLUE, RED };	// Same order as NLT_Coeffecients
+	int color = -1;
+	for (int col = 2; col >= 0; col--)
+		if ((status & colorFlags[col]) == colorFlags[col])
+			color = col;
+	if (color < 0)
+		return;
+
+	// Where the pointer is on the undistorted grid, then the nearest intersection there
+	LensModel model = currentLensModel();
+	const LensEyeTransform &transform = eyeTransform(eye, cop);
+	if (!transform.invertible())
+		return;
+
+	double idealX, idealY;
+	if (LensInverse(model, transform, eye, color).invert(pointer.x(), pointer.y(), idealX, idealY) != LENS_INVERSE_OK)
+		return;
+
+	// Same rounding drawGrid() gets from QPoint
+	int column = (int)floor((idealX - cop.x()) / GRID_SPACING + 0.5);
+	int row = (int)floor((idealY - cop.y()) / GRID_SPACING + 0.5);
+	double gridX = column == 0 ? cop.x() : (int)(cop.x() + column * GRID_SPACING);
+	double gridY = row == 0 ? cop.y() : (int)(cop.y() + row * GRID_SPACING);
+
+	double x, y;
+	lensDistortWith(model, transform, eye, color, gridX, gridY, x, y);
+	if ((x - pointer.x()) * (x - pointer.x()) + (y - pointer.y()) * (y - pointer.y()) > DRAG_PICK_RADIUS * DRAG_PICK_RADIUS)
+		return;
+
+	dragging = true;
+	dragEye = eye;
+	dragPoint = QPointF(gridX, gridY);
+	dragBefore = calibrationState();
+	memcpy(dragStart, NLT_Coeffecients[eye], sizeof(dragStart));
+	history.sync(dragBefore);
 }
 
 void OpenGL_Widget::mouseMoveEvent(QMouseEvent *event)
 {
 
 	if (event->buttons() & Qt::LeftButton) {
-		// XXX
+		if (dragging)
+			dragGridPoint(QPointF(event->x(), d_height - 1 - event->y()));
 	}
 	else if (event->buttons() & Qt::RightButton) {
 		// XXX
@@ -823,6 +1049,120 @@ void OpenGL_Widget::mouseMoveEvent(QMouseEvent *event)
 
 }
 
+void OpenGL_Widget::mouseReleaseEvent(QMouseEvent *event)
+{
+	if (event->button() != Qt::LeftButton || !dragging)
+		return;
+	dragging = false;
+	dragStatus.clear();
+
+	// The whole drag is one step to undo
+	CalibrationState after = calibrationState();
+	if (memcmp(&after, &dragBefore, sizeof(after)) != 0) {
+		history.record(after, 0);
+		journalChange(after);
+
+		const StatusValues colorFlags[3] = { GREEN, BLUE, RED };
+		for (int col = 0; col < 3; col++) {
+			if ((status & colorFlags[col]) != colorFlags[col])
+				continue;
+			printf("%s %s:", lensEyeName(dragEye), lensColorName(col));
+			for (int cof = 0; cof < distortionType(distortionTypes[dragEye][col]).terms; cof++)
+				printf(" %.8g", NLT_Coeffecients[dragEye][col][cof]);
+			printf("\n");
+		}
+	}
+	update();
+}
+
+void OpenGL_Widget::dragGridPoint(QPointF target)
+{
+	const StatusValues colorFlags[3] = { GREEN, BLUE, RED };	// Same order as NLT_Coeffecients
+	const StatusValues termFlags[3] = { FIRST_COEFFICIENT, SECOND_COEFFICIENT, THIRD_COEFFICIENT };
+	int eye = dragEye;
+	LensModel model = currentLensModel();
+	LensModel before = model;
+	const LensEyeTransform &transform = eyeTransform(eye, eye == 0 ? d_cop_l : d_cop_r);
+	double worst = 0;
+	dragStatus.clear();
+
+	for (int col = 0; col < 3; col++) {
+		if ((status & colorFlags[col]) != colorFlags[col])
+			continue;
+		int active[3], count = 0;
+		for (int cof = 0; cof < 3 && cof < distortionType(model.types[eye][col]).terms; cof++)
+			if ((status & termFlags[cof]) == termFlags[cof])
+				active[count++] = cof;
+		if (count == 0)
+			continue;
+
+		// Smallest change from where the drag started that draws the point at the
+		// target: damped Gauss-Newton on |f(k) - target|^2 + lambda |k - start|^2,
+		// starting from the last move's answer so a few steps keep up with the pointer
+		double *k = model.coeffs[eye][col];
+		double x, y;
+		for (int iteration = 0; iteration < DRAG_ITERATIONS; iteration++) {
+			lensDistortWith(model, transform, eye, col, dragPoint.x(), dragPoint.y(), x, y);
+			double rx = target.x() - x, ry = target.y() - y;
+
+			double jx[3], jy[3];
+			for (int j = 0; j < count; j++) {
+				double original = k[active[j]];
+				double h = 1e-6;
+				double px, py, mx, my;
+				k[active[j]] = original + h;
+				lensDistortWith(model, transform, eye, col, dragPoint.x(), dragPoint.y(), px, py);
+				k[active[j]] = original - h;
+				lensDistortWith(model, transform, eye, col, dragPoint.x(), dragPoint.y(), mx, my);
+				k[active[j]] = original;
+				jx[j] = (px - mx) / (2 * h);
+				jy[j] = (py - my) / (2 * h);
+			}
+
+			// The radial terms all pull along the same line so only a little
+			// damping picks the smallest of the many changes that get there
+			double A[9], b[3], trace = 0;
+			for (int a = 0; a < count; a++)
+				for (int c = 0; c < count; c++)
+					A[a * count + c] = jx[a] * jx[c] + jy[a] * jy[c];
+			for (int a = 0; a < count; a++)
+				trace += A[a * count + a];
+			double lambda = 1e-6 * trace / count + 1e-12;
+			for (int a = 0; a < count; a++) {
+				A[a * count + a] += lambda;
+				b[a] = jx[a] * rx + jy[a] * ry - lambda * (k[active[a]] - dragStart[col][active[a]]);
+			}
+			if (!choleskySolve(count, A, b))
+				break;
+			for (int a = 0; a < count; a++)
+				k[active[a]] += b[a];
+		}
+
+		// The same limits as the keyboard, otherwise this color stays where it was
+		bool inRange = true;
+		for (int a = 0; a < count; a++)
+			inRange = inRange && fabs(k[active[a]]) <= 1;
+		double fold = inRange ? lensFoldRadius(model, eye, col) : -1;
+		if (!inRange || (fold >= 0 && (lensFoldRadius(before, eye, col) < 0 || fold < lensFoldRadius(before, eye, col)))) {
+			memcpy(k, before.coeffs[eye][col], sizeof(before.coeffs[eye][col]));
+			dragStatus = QString("Can't reach that with the ") + lensColorName(col) + (inRange ? " coefficients without folding the image" : " coefficients inside -1..1");
+			continue;
+		}
+
+		lensDistortWith(model, transform, eye, col, dragPoint.x(), dragPoint.y(), x, y);
+		worst = std::max(worst, sqrt((x - target.x()) * (x - target.x()) + (y - target.y()) * (y - target.y())));
+	}
+
+	applyChangedLensModel(model);
+	if (dragStatus.isEmpty()) {
+		// Only the distance from the center can change, the rest of a sideways drag stays
+		char msg[256];
+		sprintf(msg, "Dragging %s grid point (%.0f, %.0f): %.2f pixels from the pointer", lensEyeName(eye), dragPoint.x(), dragPoint.y(), worst);
+		dragStatus = msg;
+	}
+	update();
+}
+
 QPointF OpenGL_Widget::pixelToRelative(QPointF cop) {
 	QPointF relative_cop;
 	float cop_x, cop_y;
@@ -849,175 +1189,526 @@ QPoint OpenGL_Widget::relativeToPixel(QPointF cop) {
 
 bool OpenGL_Widget::saveConfigToJson(QString filename)
 {
-	// Todo... Add some basic error checking
+	if (!configHandles.valid()) {
+		printf("ERROR: No config loaded to save into\n");
+		QApplication::beep();
+		return false;
+	}
 
-	// Left Eye
-	json["tracking_to_eye_transform"][0]["distortion"]["center_x"].SetDouble(Centers[0][0]);
-	json["tracking_to_eye_transform"][0]["distortion"]["center_y"].SetDouble(Centers[0][1]);
-
-	// Intrinsics
-	json["tracking_to_eye_transform"][0]["intrinsics"][0][0].SetDouble(Intrinsics[0][0][0]);
-	json["tracking_to_eye_transform"][0]["intrinsics"][0][1].SetDouble(Intrinsics[0][0][1]);
-	json["tracking_to_eye_transform"][0]["intrinsics"][0][2].SetDouble(Intrinsics[0][0][2]);
-	json["tracking_to_eye_transform"][0]["intrinsics"][1][0].SetDouble(Intrinsics[0][1][0]);
-	json["tracking_to_eye_transform"][0]["intrinsics"][1][1].SetDouble(Intrinsics[0][1][1]);
-	json["tracking_to_eye_transform"][0]["intrinsics"][1][2].SetDouble(Intrinsics[0][1][2]);
-	json["tracking_to_eye_transform"][0]["intrinsics"][2][0].SetDouble(Intrinsics[0][2][0]);
-	json["tracking_to_eye_transform"][0]["intrinsics"][2][1].SetDouble(Intrinsics[0][2][1]);
-	json["tracking_to_eye_transform"][0]["intrinsics"][2][2].SetDouble(Intrinsics[0][2][2]);
-
-	// Green
-	json["tracking_to_eye_transform"][0]["distortion"]["coeffs"][0].SetDouble(NLT_Coeffecients[0][0][0]);
-	json["tracking_to_eye_transform"][0]["distortion"]["coeffs"][1].SetDouble(NLT_Coeffecients[0][0][1]);
-	json["tracking_to_eye_transform"][0]["distortion"]["coeffs"][2].SetDouble(NLT_Coeffecients[0][0][2]);
-	json["tracking_to_eye_transform"][0]["distortion"]["center_x"].SetDouble(Intrinsics[0][0][2]);
-	json["tracking_to_eye_transform"][0]["distortion"]["center_y"].SetDouble(Intrinsics[0][1][2]);
-
-	// Blue
-	json["tracking_to_eye_transform"][0]["distortion_blue"]["coeffs"][0].SetDouble(NLT_Coeffecients[0][1][0]);
-	json["tracking_to_eye_transform"][0]["distortion_blue"]["coeffs"][1].SetDouble(NLT_Coeffecients[0][1][1]);
-	json["tracking_to_eye_transform"][0]["distortion_blue"]["coeffs"][2].SetDouble(NLT_Coeffecients[0][1][2]);
-	json["tracking_to_eye_transform"][0]["distortion_blue"]["center_x"].SetDouble(Intrinsics[0][0][2]);
-	json["tracking_to_eye_transform"][0]["distortion_blue"]["center_y"].SetDouble(Intrinsics[0][1][2]);
-
-	// Red
-	json["tracking_to_eye_transform"][0]["distortion_red"]["coeffs"][0].SetDouble(NLT_Coeffecients[0][2][0]);
-	json["tracking_to_eye_transform"][0]["distortion_red"]["coeffs"][1].SetDouble(NLT_Coeffecients[0][2][1]);
-	json["tracking_to_eye_transform"][0]["distortion_red"]["coeffs"][2].SetDouble(NLT_Coeffecients[0][2][2]);
-	json["tracking_to_eye_transform"][0]["distortion_red"]["center_x"].SetDouble(Intrinsics[0][0][2]);
-	json["tracking_to_eye_transform"][0]["distortion_red"]["center_y"].SetDouble(Intrinsics[0][1][2]);
+	// Straight into the values resolved at load, then the copy is written in the background
+	configHandles.write(currentLensModel());
+	configSaver.save(filename, json);
+
+	// The journal starts over from what was saved. Should the save never make it
+	// to disk the next start finds this state differs from the config and offers it.
+	if (filename == configFile) {
+		configModel = currentLensModel();
+		autosaveModel = configModel;
+		memcpy(configCenters, Centers, sizeof(configCenters));
+
+		journalReplay = 0;
+		QString error;
+		if (journal.start(configJournalFile(configFile), sizeof(CalibrationState), error)) {
+			CalibrationState state = calibrationState();
+			journal.append(&state);
+		}
+	}
+	return true;
+}
 
+void OpenGL_Widget::autosave()
+{
+	// Only once for the same values
+	if (!configHandles.valid() || !unsavedChanges() || !lensValuesDiffer(autosaveModel))
+		return;
 
-	// Right Eye
-	json["tracking_to_eye_transform"][1]["distortion"]["center_x"].SetDouble(Centers[1][0]);
-	json["tracking_to_eye_transform"][1]["distortion"]["center_y"].SetDouble(Centers[1][1]);
-
-	// Intrinsics
-	json["tracking_to_eye_transform"][1]["intrinsics"][0][0].SetDouble(Intrinsics[1][0][0]);
-	json["tracking_to_eye_transform"][1]["intrinsics"][0][1].SetDouble(Intrinsics[1][0][1]);
-	json["tracking_to_eye_transform"][1]["intrinsics"][0][2].SetDouble(Intrinsics[1][0][2]);
-	json["tracking_to_eye_transform"][1]["intrinsics"][1][0].SetDouble(Intrinsics[1][1][0]);
-	json["tracking_to_eye_transform"][1]["intrinsics"][1][1].SetDouble(Intrinsics[1][1][1]);
-	json["tracking_to_eye_transform"][1]["intrinsics"][1][2].SetDouble(Intrinsics[1][1][2]);
-	json["tracking_to_eye_transform"][1]["intrinsics"][2][0].SetDouble(Intrinsics[1][2][0]);
-	json["tracking_to_eye_transform"][1]["intrinsics"][2][1].SetDouble(Intrinsics[1][2][1]);
-	json["tracking_to_eye_transform"][1]["intrinsics"][2][2].SetDouble(Intrinsics[1][2][2]);
-
-	// Green
-	json["tracking_to_eye_transform"][1]["distortion"]["coeffs"][0].SetDouble(NLT_Coeffecients[1][0][0]);
-	json["tracking_to_eye_transform"][1]["distortion"]["coeffs"][1].SetDouble(NLT_Coeffecients[1][0][1]);
-	json["tracking_to_eye_transform"][1]["distortion"]["coeffs"][2].SetDouble(NLT_Coeffecients[1][0][2]);
-	json["tracking_to_eye_transform"][1]["distortion"]["center_x"].SetDouble(Intrinsics[1][0][2]);
-	json["tracking_to_eye_transform"][1]["distortion"]["center_y"].SetDouble(Intrinsics[1][1][2]);
-
-	// Blue
-	json["tracking_to_eye_transform"][1]["distortion_blue"]["coeffs"][0].SetDouble(NLT_Coeffecients[1][1][0]);
-	json["tracking_to_eye_transform"][1]["distortion_blue"]["coeffs"][1].SetDouble(NLT_Coeffecients[1][1][1]);
-	json["tracking_to_eye_transform"][1]["distortion_blue"]["coeffs"][2].SetDouble(NLT_Coeffecients[1][1][2]);
-	json["tracking_to_eye_transform"][1]["distortion_blue"]["center_x"].SetDouble(Intrinsics[1][0][2]);
-	json["tracking_to_eye_transform"][1]["distortion_blue"]["center_y"].SetDouble(Intrinsics[1][1][2]);
-
-	// Red
-	json["tracking_to_eye_transform"][1]["distortion_red"]["coeffs"][0].SetDouble(NLT_Coeffecients[1][2][0]);
-	json["tracking_to_eye_transform"][1]["distortion_red"]["coeffs"][1].SetDouble(NLT_Coeffecients[1][2][1]);
-	json["tracking_to_eye_transform"][1]["distortion_red"]["coeffs"][2].SetDouble(NLT_Coeffecients[1][2][2]);
-	json["tracking_to_eye_transform"][1]["distortion_red"]["center_x"].SetDouble(Intrinsics[1][0][2]);
-	json["tracking_to_eye_transform"][1]["distortion_red"]["center_y"].SetDouble(Intrinsics[1][1][2]);
-
-	QFile file(filename);
-	file.open(QIODevice::WriteOnly | QIODevice::Text);
-
-	rapidjson::StringBuffer buffer;
-	buffer.Clear();
-
-	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-	json.Accept(writer);
-
-	file.write(buffer.GetString());
-	file.close();
+	autosaveModel = currentLensModel();
+	configHandles.write(autosaveModel);
+	configSaver.save(configAutosaveFile(configFile), json);
+}
 
-	return true;
+bool OpenGL_Widget::unsavedChanges()
+{
+	return lensValuesDiffer(configModel);
 }
 
-bool OpenGL_Widget::loadConfigFromJson(QString filename)
+bool OpenGL_Widget::lensValuesDiffer(const LensModel &model)
 {
-	// Todo: Add some basic error checking/sanity checking
+	// Only what a save writes, changes that go back to the saved values don't count
+	LensModel current = currentLensModel();
+	return memcmp(current.types, model.types, sizeof(current.types)) != 0
+		|| memcmp(current.coeffs, model.coeffs, sizeof(current.coeffs)) != 0
+		|| memcmp(current.intrinsics, model.intrinsics, sizeof(current.intrinsics)) != 0
+		|| memcmp(current.extrinsics, model.extrinsics, sizeof(current.extrinsics)) != 0;
+}
 
-	QString val;
-	QFile file("HMD_Config.json");
-	if (!file.exists())
+void OpenGL_Widget::reportSaves()
+{
+	for (const ConfigSaveResult &result : configSaver.finished()) {
+		if (!result.ok) {
+			printf("ERROR: Unable to save \"%s\": %s\n", result.filename.toLocal8Bit().constData(), result.error.toLocal8Bit().constData());
+			QApplication::beep();
+		}
+		else if (!result.filename.endsWith(CONFIG_AUTOSAVE_SUFFIX)) {
+			printf("Saved \"%s\"\n", result.filename.toLocal8Bit().constData());
+		}
+	}
+}
+
+bool OpenGL_Widget::loadConfigFromJson(QString filename)
+{
+	// Parsed on the side so a bad file leaves the current config alone
+	std::vector<char> buffer;
+	rapidjson::Document loaded;
+	LensModel model;
+	std::string error;
+	if (!readConfig(filename, buffer, loaded, model, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		QApplication::beep();
 		return false;
+	}
 
-	file.open(QIODevice::ReadOnly | QIODevice::Text);
+	adoptConfig(filename, buffer, loaded, model);
+	return true;
+}
 
-	val = file.readAll();
-	file.close();
+bool OpenGL_Widget::readConfig(const QString &filename, std::vector<char> &buffer, rapidjson::Document &loaded, LensModel &model, std::string &error)
+{
+	model = currentLensModel();
+	if (!parseConfigFile(filename.toLocal8Bit().constData(), buffer, loaded, error) || !readLensModel(loaded, model, error)) {
+		error = "\"" + std::string(filename.toLocal8Bit().constData()) + "\" is not a valid config file: " + error;
+		return false;
+	}
+	return true;
+}
+
+void OpenGL_Widget::adoptConfig(const QString &filename, std::vector<char> &buffer, rapidjson::Document &loaded, const LensModel &model)
+{
+	std::string error;
 
-	using namespace rapidjson;
+	// Queued saves can still refer to strings in the old buffer
+	configSaver.flush();
+	json.Swap(loaded);
+	jsonBuffer.swap(buffer);
 
-	json.Parse(val.toStdString().c_str());
-	// Todo make sure all the various parts of the JSON file actually exist....
+	// Find everything a save writes to, it can't fail on a validated config
+	configHandles.resolve(json, error);
+	configFile = filename;
 
 	// Left Eye
-	Centers[0][0] = json["tracking_to_eye_transform"][0]["distortion"]["center_x"].GetDouble();
-	Centers[0][1] = json["tracking_to_eye_transform"][0]["distortion"]["center_y"].GetDouble();
-
-	Intrinsics[0][0][0] = json["tracking_to_eye_transform"][0]["intrinsics"][0][0].GetDouble();
-	Intrinsics[0][0][1] = json["tracking_to_eye_transform"][0]["intrinsics"][0][1].GetDouble();
-	Intrinsics[0][0][2] = json["tracking_to_eye_transform"][0]["intrinsics"][0][2].GetDouble();
-	Intrinsics[0][1][0] = json["tracking_to_eye_transform"][0]["intrinsics"][1][0].GetDouble();
-	Intrinsics[0][1][1] = json["tracking_to_eye_transform"][0]["intrinsics"][1][1].GetDouble();
-	Intrinsics[0][1][2] = json["tracking_to_eye_transform"][0]["intrinsics"][1][2].GetDouble();
-	Intrinsics[0][2][0] = json["tracking_to_eye_transform"][0]["intrinsics"][2][0].GetDouble();
-	Intrinsics[0][2][1] = json["tracking_to_eye_transform"][0]["intrinsics"][2][1].GetDouble();
-	Intrinsics[0][2][2] = json["tracking_to_eye_transform"][0]["intrinsics"][2][2].GetDouble();
-
-	// Green
-	NLT_Coeffecients[0][0][0] = json["tracking_to_eye_transform"][0]["distortion"]["coeffs"][0].GetDouble();
-	NLT_Coeffecients[0][0][1] = json["tracking_to_eye_transform"][0]["distortion"]["coeffs"][1].GetDouble();
-	NLT_Coeffecients[0][0][2] = json["tracking_to_eye_transform"][0]["distortion"]["coeffs"][2].GetDouble();
-	// Blue
-	NLT_Coeffecients[0][1][0] = json["tracking_to_eye_transform"][0]["distortion_blue"]["coeffs"][0].GetDouble();
-	NLT_Coeffecients[0][1][1] = json["tracking_to_eye_transform"][0]["distortion_blue"]["coeffs"][1].GetDouble();
-	NLT_Coeffecients[0][1][2] = json["tracking_to_eye_transform"][0]["distortion_blue"]["coeffs"][2].GetDouble();
-	// Red
-	NLT_Coeffecients[0][2][0] = json["tracking_to_eye_transform"][0]["distortion_red"]["coeffs"][0].GetDouble();
-	NLT_Coeffecients[0][2][1] = json["tracking_to_eye_transform"][0]["distortion_red"]["coeffs"][1].GetDouble();
-	NLT_Coeffecients[0][2][2] = json["tracking_to_eye_transform"][0]["distortion_red"]["coeffs"][2].GetDouble();
+	Centers[0][0] = readConfigCenter(json, 0, 0);
+	Centers[0][1] = readConfigCenter(json, 0, 1);
 
 	// Right Eye
-	Centers[1][0] = json["tracking_to_eye_transform"][1]["distortion"]["center_x"].GetDouble();
-	Centers[1][1] = json["tracking_to_eye_transform"][1]["distortion"]["center_y"].GetDouble();
-
-	Intrinsics[1][0][0] = json["tracking_to_eye_transform"][1]["intrinsics"][0][0].GetDouble();
-	Intrinsics[1][0][1] = json["tracking_to_eye_transform"][1]["intrinsics"][0][1].GetDouble();
-	Intrinsics[1][0][2] = json["tracking_to_eye_transform"][1]["intrinsics"][0][2].GetDouble();
-	Intrinsics[1][1][0] = json["tracking_to_eye_transform"][1]["intrinsics"][1][0].GetDouble();
-	Intrinsics[1][1][1] = json["tracking_to_eye_transform"][1]["intrinsics"][1][1].GetDouble();
-	Intrinsics[1][1][2] = json["tracking_to_eye_transform"][1]["intrinsics"][1][2].GetDouble();
-	Intrinsics[1][2][0] = json["tracking_to_eye_transform"][1]["intrinsics"][2][0].GetDouble();
-	Intrinsics[1][2][1] = json["tracking_to_eye_transform"][1]["intrinsics"][2][1].GetDouble();
-	Intrinsics[1][2][2] = json["tracking_to_eye_transform"][1]["intrinsics"][2][2].GetDouble();
-
-	// Green
-	NLT_Coeffecients[1][0][0] = json["tracking_to_eye_transform"][1]["distortion"]["coeffs"][0].GetDouble();
-	NLT_Coeffecients[1][0][1] = json["tracking_to_eye_transform"][1]["distortion"]["coeffs"][1].GetDouble();
-	NLT_Coeffecients[1][0][2] = json["tracking_to_eye_transform"][1]["distortion"]["coeffs"][2].GetDouble();
-	// Blue			 											  
-	NLT_Coeffecients[1][1][0] = json["tracking_to_eye_transform"][1]["distortion_blue"]["coeffs"][0].GetDouble();
-	NLT_Coeffecients[1][1][1] = json["tracking_to_eye_transform"][1]["distortion_blue"]["coeffs"][1].GetDouble();
-	NLT_Coeffecients[1][1][2] = json["tracking_to_eye_transform"][1]["distortion_blue"]["coeffs"][2].GetDouble();
-	// Red			 											  
-	NLT_Coeffecients[1][2][0] = json["tracking_to_eye_transform"][1]["distortion_red"]["coeffs"][0].GetDouble();
-	NLT_Coeffecients[1][2][1] = json["tracking_to_eye_transform"][1]["distortion_red"]["coeffs"][1].GetDouble();
-	NLT_Coeffecients[1][2][2] = json["tracking_to_eye_transform"][1]["distortion_red"]["coeffs"][2].GetDouble();
+	Centers[1][0] = readConfigCenter(json, 1, 0);
+	Centers[1][1] = readConfigCenter(json, 1, 1);
+
+	// Intrinsics and coeffiecents for both eyes
+	applyLensModel(model);
 
 	ApplyIntrincstsToCenter();
 	//	setDeftCOPVals();
 
+	// What the file holds, so a change made to it by another program can be told apart
+	configModel = model;
+	autosaveModel = model;
+	memcpy(configCenters, Centers, sizeof(configCenters));
+	watchConfig();
+
+	// Nothing to undo until something is changed
+	history.reset(calibrationState());
+
+	// Changes that never made it into this config, kept until the next change
+	journal.close();
+	std::vector<char> last;
+	journalReplay = ChangeJournal::read(configJournalFile(configFile), sizeof(CalibrationState), last);
+	if (journalReplay > 0) {
+		memcpy(&journalState, &last[0], sizeof(journalState));
+		// Only the last state counts, if it's what was loaded it was saved after all
+		CalibrationState loaded = calibrationState();
+		if (memcmp(journalState.coeffs, loaded.coeffs, sizeof(loaded.coeffs)) == 0 && memcmp(journalState.aspect, loaded.aspect, sizeof(loaded.aspect)) == 0
+			&& memcmp(journalState.center, loaded.center, sizeof(loaded.center)) == 0 && memcmp(journalState.types, loaded.types, sizeof(loaded.types)) == 0)
+			journalReplay = 0;
+	}
+	if (journalReplay > 0) {
+		printf("NOTE: \"%s\" has %d changes that were never saved, press U to replay them (they're dropped on the next change)\n",
+			configJournalFile(configFile).toLocal8Bit().constData(), journalReplay);
+	}
+}
+
+void OpenGL_Widget::watchConfig()
+{
+	// The folder as well, saving by renaming a new file over the old one drops the file from the watch
+	QStringList watched = configWatcher->files() + configWatcher->directories();
+	if (!watched.isEmpty())
+		configWatcher->removePaths(watched);
+	configWatcher->addPath(configFile);
+	configWatcher->addPath(QFileInfo(configFile).absolutePath());
+}
+
+void OpenGL_Widget::configFileChanged(bool folder)
+{
+	// Anything else in the folder (autosaves, the journal) changes far more often than the config
+	if (folder && configWatcher->files().contains(configFile))
+		return;
+
+	// Back from being replaced, or still gone in which case the folder says when it returns
+	if (!configWatcher->files().contains(configFile) && (!QFile::exists(configFile) || !configWatcher->addPath(configFile)))
+		return;
+
+	// Every change restarts the wait so a file written in pieces is only read once it's done
+	configReloadTimer->start();
+}
+
+void OpenGL_Widget::reloadChangedConfig()
+{
+	// Our own saves have to be on disk first or they'd look like someone else's change
+	configSaver.flush();
+
+	QElapsedTimer timer;
+	timer.start();
+
+	std::vector<char> buffer;
+	rapidjson::Document loaded;
+	LensModel model = currentLensModel();
+	std::string error;
+	if (!parseConfigFile(configFile.toLocal8Bit().constData(), buffer, loaded, error) || !readLensModel(loaded, model, error)) {
+		// Most likely caught halfway through a write, the rest of it triggers another try
+		printf("NOTE: \"%s\" changed but can't be loaded (yet): %s\n", configFile.toLocal8Bit().constData(), error.c_str());
+		return;
+	}
+
+	// Everything else in the file is kept for the next save
+	json.Swap(loaded);
+	jsonBuffer.swap(buffer);
+	configHandles.resolve(json, error);
+
+	// Only what differs from the file as it was loaded or saved came from the other program
+	LensModel merged = currentLensModel();
+	for (int eye = 0; eye < 2; eye++) {
+		for (int axis = 0; axis < 2; axis++) {
+			double center = readConfigCenter(json, eye, axis);
+			if (center != configCenters[eye][axis])
+				Centers[eye][axis] = center;
+			configCenters[eye][axis] = center;
+		}
+
+		if (memcmp(model.intrinsics[eye], configModel.intrinsics[eye], sizeof(model.intrinsics[eye])) != 0)
+			memcpy(merged.intrinsics[eye], model.intrinsics[eye], sizeof(merged.intrinsics[eye]));
+		if (memcmp(model.extrinsics[eye], configModel.extrinsics[eye], sizeof(model.extrinsics[eye])) != 0)
+			memcpy(merged.extrinsics[eye], model.extrinsics[eye], sizeof(merged.extrinsics[eye]));
+		for (int col = 0; col < 3; col++) {
+			if (model.types[eye][col] != configModel.types[eye][col]
+				|| memcmp(model.coeffs[eye][col], configModel.coeffs[eye][col], sizeof(model.coeffs[eye][col])) != 0) {
+				merged.types[eye][col] = model.types[eye][col];
+				memcpy(merged.coeffs[eye][col], model.coeffs[eye][col], sizeof(merged.coeffs[eye][col]));
+			}
+		}
+	}
+	std::string changes = applyChangedLensModel(merged);
+	configModel = model;
+
+	// Nothing new, most likely our own save
+	if (changes.empty())
+		return;
+
+	// Taking on what's in the file is a step of its own to undo
+	CalibrationState state = calibrationState();
+	history.sync(state);
+	if (journal.active())
+		journal.append(&state);
+	update();
+
+	printf("Reloaded \"%s\", changed by another program: %s (%.1f ms)\n", configFile.toLocal8Bit().constData(),
+		changes.c_str(), timer.nsecsElapsed() / 1e6);
+}
+
+void OpenGL_Widget::handleControlRequests()
+{
+	for (const ControlRequest &request : controlServer.take()) {
+		rapidjson::StringBuffer reply;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(reply);
+		std::string error;
+		writer.StartObject();
+		bool ok = handleControlRequest(request.text, writer, error);
+		if (!ok) {
+			writer.Key("error");
+			writer.String(error.c_str());
+		}
+		writer.Key("ok");
+		writer.Bool(ok);
+		writer.EndObject();
+		controlServer.reply(request.client, std::string(reply.GetString(), reply.GetSize()));
+	}
+
+	// Everything taken above shows up in the same frame
+	update();
+}
+
+bool OpenGL_Widget::handleControlRequest(const std::string &text, rapidjson::Writer<rapidjson::StringBuffer> &writer, std::string &error)
+{
+	rapidjson::Document request;
+	request.Parse(text.c_str());
+	if (request.HasParseError() || !request.IsObject()) {
+		error = "expected a JSON object";
+		return false;
+	}
+	if (request.HasMember("id")) {
+		writer.Key("id");
+		request["id"].Accept(writer);
+	}
+
+	// In this order whatever order the request has them in, but nothing
+	// changes until the file to load and the edits are known to be good
+	QString loadFile;
+	std::vector<char> loadBuffer;
+	rapidjson::Document loaded;
+	LensModel loadedModel;
+	if (request.HasMember("load")) {
+		loadFile = configFile;
+		if (request["load"].IsString() && !controlPath(request["load"], QStringList() << "json", loadFile, error))
+			return false;
+		if (!readConfig(loadFile, loadBuffer, loaded, loadedModel, error))
+			return false;
+	}
+
+	std::vector<ConfigEdit> edits;
+	if (request.HasMember("edits")) {
+		const rapidjson::Value &list = request["edits"];
+		if (!list.IsArray()) {
+			error = "\"edits\" should be an array of edit script lines";
+			return false;
+		}
+
+		edits.resize(list.Size());
+		for (rapidjson::SizeType i = 0; i < list.Size(); i++) {
+			std::string expected = "should be a string";
+			edits[i].line = i + 1;
+			if (!list[i].IsString() || !parseEdit(list[i].GetString(), edits[i], expected)) {
+				error = "line " + std::to_string(i + 1) + ": " + expected;
+				return false;
+			}
+		}
+	}
+
+	// All of them or none, on top of the file being loaded
+	LensModel model = loadFile.isEmpty() ? currentLensModel() : loadedModel;
+	if (!applyConfigEdits(edits, model, error))
+		return false;
+
+	QString saveFile;
+	if (request.HasMember("save")) {
+		if (request["save"].IsString() && !controlPath(request["save"], QStringList() << "json", saveFile, error))
+			return false;
+		if (loadFile.isEmpty() && !configHandles.valid()) {
+			error = "nothing loaded to save";
+			return false;
+		}
+	}
+
+	if (request.HasMember("metrics")) {
+		if (!residualMetric.hasTarget())
+			loadResidualTarget();
+		if (!residualMetric.hasTarget()) {
+			error = "no residual target, see " TARGET_FILE;
+			return false;
+		}
+	}
+
+	QString frameFile;
+	if (request.HasMember("frame")) {
+		if (!request["frame"].IsString()) {
+			error = "\"frame\" should be the file to save the frame to";
+			return false;
+		}
+		if (!controlPath(request["frame"], QStringList() << "png" << "jpg" << "jpeg" << "bmp", frameFile, error))
+			return false;
+	}
+
+	if (!loadFile.isEmpty())
+		adoptConfig(loadFile, loadBuffer, loaded, loadedModel);
+
+	if (request.HasMember("edits")) {
+		history.sync(calibrationState());
+		std::string changes = applyChangedLensModel(model);
+		if (!changes.empty()) {
+			CalibrationState state = calibrationState();
+			history.record(state, 0);
+			journalChange(state);
+		}
+		writer.Key("changed");
+		writer.String(changes.c_str());
+	}
+
+	if (request.HasMember("save"))
+		saveConfigToJson(saveFile.isEmpty() ? configFile : saveFile);
+
+	if (request.HasMember("get")) {
+		writer.Key("state");
+		writeControlState(writer);
+	}
+
+	if (request.HasMember("metrics")) {
+		double cop[2][2] = { { d_cop_l.x(), d_cop_l.y() }, { d_cop_r.x(), d_cop_r.y() } };
+		residualMetric.update(currentLensModel(), cop);
+
+		writer.Key("metrics");
+		writer.StartObject();
+		for (int eye = 0; eye < 2; eye++) {
+			writer.Key(lensEyeName(eye));
+			writer.StartObject();
+			writer.Key("bend");
+			writer.Double(residualMetric.bend(eye));
+			for (int col = 0; col < 3; col++) {
+				writer.Key((std::string("bend_") + lensColorName(col)).c_str());
+				writer.Double(residualMetric.bend(eye, col));
+			}
+			writer.Key("red_to_green");
+			writer.Double(residualMetric.redToGreen(eye));
+			writer.Key("blue_to_green");
+			writer.Double(residualMetric.blueToGreen(eye));
+			writer.EndObject();
+		}
+		writer.EndObject();
+	}
+
+	if (request.HasMember("frame")) {
+		// Drawn now so it shows this request's values even if more follow before the next frame
+		updateGL();
+		if (!grabFrameBuffer().save(frameFile)) {
+			error = "unable to save the frame to " + frameFile.toStdString();
+			return false;
+		}
+		writer.Key("frame");
+		writer.String(request["frame"].GetString());
+	}
+
 	return true;
 }
 
+bool OpenGL_Widget::controlPath(const rapidjson::Value &value, const QStringList &suffixes, QString &filename, std::string &error)
+{
+#ifdef _WIN32
+	const Qt::CaseSensitivity sensitivity = Qt::CaseInsensitive;
+#else
+	const Qt::CaseSensitivity sensitivity = Qt::CaseSensitive;
+#endif
+
+	QFileInfo info(QString::fromUtf8(value.GetString()));
+	if (!suffixes.contains(info.suffix().toLower())) {
+		error = std::string(value.GetString()) + " should end in ." + suffixes.join(", .").toStdString();
+		return false;
+	}
+
+	// Resolved so neither .. nor a link can lead out of the folders
+	QString folder = QDir(info.absolutePath()).canonicalPath();
+	QString resolved = info.exists() ? info.canonicalFilePath() : folder + "/" + info.fileName();
+	QStringList allowed;
+	allowed << QDir::current().canonicalPath() << QDir(CONFIG_STORE_DIR).canonicalPath();
+	for (const QString &root : allowed) {
+		if (!folder.isEmpty() && !root.isEmpty() && resolved.startsWith(root + "/", sensitivity)) {
+			filename = resolved;
+			return true;
+		}
+	}
+
+	error = std::string(value.GetString()) + " is not in the folder " CONFIG_FILE " is in or the " CONFIG_STORE_DIR " folder";
+	return false;
+}
+
+void OpenGL_Widget::writeControlState(rapidjson::Writer<rapidjson::StringBuffer> &writer)
+{
+	writer.StartObject();
+	writer.Key("file");
+	writer.String(configFile.toUtf8().constData());
+	writer.Key("unsaved");
+	writer.Bool(unsavedChanges());
+
+	for (int eye = 0; eye < 2; eye++) {
+		writer.Key(lensEyeName(eye));
+		writer.StartObject();
+
+		writer.Key("intrinsics");
+		writer.StartArray();
+		for (int row = 0; row < 3; row++) {
+			writer.StartArray();
+			for (int col = 0; col < 3; col++)
+				writer.Double(Intrinsics[eye][row][col]);
+			writer.EndArray();
+		}
+		writer.EndArray();
+
+		// Where it's drawn from, in pixels
+		QPointF cop = eye == 0 ? d_cop_l : d_cop_r;
+		writer.Key("center_of_projection");
+		writer.StartArray();
+		writer.Double(cop.x());
+		writer.Double(cop.y());
+		writer.EndArray();
+
+		for (int col = 0; col < 3; col++) {
+			const DistortionType &type = distortionType(distortionTypes[eye][col]);
+			writer.Key(lensColorName(col));
+			writer.StartObject();
+			writer.Key("type");
+			writer.String(type.name);
+			writer.Key("coeffs");
+			writer.StartArray();
+			for (int cof = 0; cof < type.terms; cof++)
+				writer.Double(NLT_Coeffecients[eye][col][cof]);
+			writer.EndArray();
+			writer.EndObject();
+		}
+		writer.EndObject();
+	}
+	writer.EndObject();
+}
+
+std::string OpenGL_Widget::applyChangedLensModel(const LensModel &model)
+{
+	const StatusValues eyeFlags[2] = { LEFT_EYE, RIGHT_EYE };
+	const StatusValues colorFlags[3] = { GREEN, BLUE, RED };	// Same order as NLT_Coeffecients
+	std::string changes;
+
+	for (int eye = 0; eye < 2; eye++) {
+		// The intrinsics and extrinsics are shared by all colors of the eye
+		bool eyeChanged = false;
+		if (memcmp(model.intrinsics[eye], Intrinsics[eye], sizeof(Intrinsics[eye])) != 0) {
+			bool moved = Intrinsics[eye][0][2] != model.intrinsics[eye][0][2] || Intrinsics[eye][1][2] != model.intrinsics[eye][1][2];
+			memcpy(Intrinsics[eye], model.intrinsics[eye], sizeof(Intrinsics[eye]));
+			if (moved) {
+				QPointF &cop = eye == 0 ? d_cop_l : d_cop_r;
+				QPointF &copPrev = eye == 0 ? d_cop_l_Prev : d_cop_r_Prev;
+				cop = copPrev = intrinsicsCenter(eye);
+			}
+			eyeChanged = true;
+		}
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 4; col++)
+				if (Extrinsics[eye][row][col] != model.extrinsics[eye][row][col]) {
+					Extrinsics[eye][row][col] = model.extrinsics[eye][row][col];
+					eyeChanged = true;
+				}
+		if (eyeChanged) {
+			lensChanged(eyeFlags[eye], GREEN | BLUE | RED);
+			changes += std::string(changes.empty() ? "" : ", ") + lensEyeName(eye) + " eye";
+		}
+
+		for (int col = 0; col < 3; col++) {
+			if (model.types[eye][col] == distortionTypes[eye][col]
+				&& memcmp(model.coeffs[eye][col], NLT_Coeffecients[eye][col], sizeof(NLT_Coeffecients[eye][col])) == 0)
+				continue;
+
+			distortionTypes[eye][col] = model.types[eye][col];
+			memcpy(NLT_Coeffecients[eye][col], model.coeffs[eye][col], sizeof(NLT_Coeffecients[eye][col]));
+			if (!eyeChanged) {
+				lensChanged(eyeFlags[eye], colorFlags[col]);
+				changes += std::string(changes.empty() ? "" : ", ") + lensEyeName(eye) + " " + lensColorName(col);
+			}
+		}
+	}
+	return changes;
+}
 
 void OpenGL_Widget::shiftCoeffecientOffset(int direction)
 {
@@ -1093,12 +1784,42 @@ void OpenGL_Widget::adjustCoeffecients(int direction) {
 				if (abs(tCoeffecientets[eye][col][cof]) > 1)
 					foundDiscprepancy = true;
 
+	// Nor can they fold the image over inside the eye, unless it already did and this moves the fold further out
+	if (!foundDiscprepancy) {
+		LensModel before = currentLensModel();
+		LensModel after = before;
+		for (int eye = 0; eye < 2; eye++)
+			for (int col = 0; col < 3; col++)
+				for (int cof = 0; cof < 3; cof++)
+					after.coeffs[eye][col][cof] = tCoeffecientets[eye][col][cof];
+
+		for (int eye = 0; eye < 2 && !foundDiscprepancy; eye++) {
+			for (int col = 0; col < 3 && !foundDiscprepancy; col++) {
+				if (memcmp(after.coeffs[eye][col], before.coeffs[eye][col], sizeof(after.coeffs[eye][col])) == 0)
+					continue;
+				double fold = lensFoldRadius(after, eye, col);
+				double was = lensFoldRadius(before, eye, col);
+				if (fold >= 0 && (was < 0 || fold < was)) {
+					char msg[256];
+					sprintf(msg, "REFUSED: %s %s would fold over %.0f pixels from the center (%.0f%% of the way to the corner)",
+						lensEyeName(eye), lensColorName(col), fold, 100 * fold / lensMaxRadius(d_width, d_height));
+					printf("%s\n", msg);
+					foldWarning = msg;
+					foundDiscprepancy = true;
+				}
+			}
+		}
+	}
+
 
 	if (!foundDiscprepancy) {
 		for (int eye = 0; eye < 2; eye++)
 			for (int col = 0; col < 3; col++)
 				for (int cof = 0; cof < 3; cof++)
 					NLT_Coeffecients[eye][col][cof] = tCoeffecientets[eye][col][cof];
+
+		lensChanged(status & (LEFT_EYE | RIGHT_EYE), status & (GREEN | BLUE | RED));
+		foldWarning.clear();
 	}
 	else {
 		QApplication::beep();
@@ -1143,6 +1864,8 @@ void OpenGL_Widget::shiftCenter(int v, int h)
 				d_cop_r.setY(d_cop_r.y() + -v);
 		}
 	}
+
+	lensChanged(status & (LEFT_EYE | RIGHT_EYE), GREEN | BLUE | RED);
 }
 
 void OpenGL_Widget::toggleLinearTransform() {
@@ -1196,6 +1919,8 @@ void OpenGL_Widget::adjustAspectRatio(int w, int h) {
 		else
 			Intrinsics[1][1][1] = (double)d_width / 1000 / 2; // The frame buffer is just one screen so both eyes share the horizontal resolution
 	}
+
+	lensChanged(status & (LEFT_EYE | RIGHT_EYE), GREEN | BLUE | RED);
 }
 
 void OpenGL_Widget::ApplyCenterToIntrinsics() {
@@ -1215,29 +1940,39 @@ void OpenGL_Widget::ApplyCenterToIntrinsics() {
 
 	d_cop_l_Prev = d_cop_l;
 	d_cop_r_Prev = d_cop_r;
+
+	lensChanged(LEFT_EYE | RIGHT_EYE, GREEN | BLUE | RED);
 }
 
-void OpenGL_Widget::ApplyIntrincstsToCenter() {
+QPointF OpenGL_Widget::intrinsicsCenter(int eye) {
 	double CxL, CxR, Cy;
 	CxL = d_width / 4;
 	CxR = d_width / 2 + CxL;
 	Cy = d_height / 2;
 
-	d_cop_l.setX(CxL + (CxL * Intrinsics[0][0][2]));
-	d_cop_l.setY(Cy + (Cy * Intrinsics[0][1][2]));
+	double Cx = eye == 0 ? CxL : CxR;
+	return QPointF(Cx + (Cx * Intrinsics[eye][0][2]), Cy + (Cy * Intrinsics[eye][1][2]));
+}
 
-	d_cop_r.setX(CxR + (CxR * Intrinsics[1][0][2]));
-	d_cop_r.setY(Cy + (Cy * Intrinsics[1][1][2]));
+void OpenGL_Widget::ApplyIntrincstsToCenter() {
+	d_cop_l = intrinsicsCenter(0);
+	d_cop_r = intrinsicsCenter(1);
 
 	d_cop_l_Prev = d_cop_l;
 	d_cop_r_Prev = d_cop_r;
 
-
-
+	lensChanged(LEFT_EYE | RIGHT_EYE, GREEN | BLUE | RED);
 }
 
 void OpenGL_Widget::loadInitalValues() {
-	if (!loadConfigFromJson(CONFIG_FILE)) {
+	// Without a config of its own start on the first headset in the store
+	QString initial = CONFIG_FILE;
+	if (!QFile::exists(initial) && configStore.refresh() > 0) {
+		initial = configStore.entries()[0].filename;
+		headsetName = configStore.entries()[0].serial;
+	}
+
+	if (!loadConfigFromJson(initial)) {
 		printf("ERROR: Unable to load default config file called \"HMD_Config.json\"");
 		printf("\n\nPlease ensure this file exists in the same folder as this appication and try again.\n\n");
 
@@ -1248,7 +1983,527 @@ void OpenGL_Widget::loadInitalValues() {
 #endif
 
 		QApplication::quit();
+		return;
+	}
+
+	// Left behind by a session that ended without saving
+	noteAutosave();
+}
+
+void OpenGL_Widget::noteAutosave()
+{
+	QFileInfo autosaved(configAutosaveFile(configFile)), config(configFile);
+	if (autosaved.exists() && autosaved.lastModified().toMSecsSinceEpoch() > config.lastModified().toMSecsSinceEpoch()) {
+		printf("NOTE: \"%s\" has newer values that were never saved, copy it over \"%s\" to use them\n",
+			autosaved.filePath().toLocal8Bit().constData(), configFile.toLocal8Bit().constData());
+	}
+}
+
+CalibrationState OpenGL_Widget::calibrationState()
+{
+	// Zeroed first so padding doesn't make equal states look different
+	CalibrationState state;
+	memset(&state, 0, sizeof(state));
+	for (int eye = 0; eye < 2; eye++) {
+		for (int col = 0; col < 3; col++) {
+			state.types[eye][col] = (unsigned char)distortionTypes[eye][col];
+			for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+				state.coeffs[eye][col][cof] = NLT_Coeffecients[eye][col][cof];
+		}
+		for (int axis = 0; axis < 2; axis++) {
+			state.aspect[eye][axis] = Intrinsics[eye][axis][axis];
+			state.center[eye][axis] = Intrinsics[eye][axis][2];
+			state.centers[eye][axis] = Centers[eye][axis];
+		}
+	}
+	state.cop[0][0] = d_cop_l.x();		state.cop[0][1] = d_cop_l.y();
+	state.cop[1][0] = d_cop_r.x();		state.cop[1][1] = d_cop_r.y();
+	state.copPrev[0][0] = d_cop_l_Prev.x();		state.copPrev[0][1] = d_cop_l_Prev.y();
+	state.copPrev[1][0] = d_cop_r_Prev.x();		state.copPrev[1][1] = d_cop_r_Prev.y();
+	state.status = status;
+	return state;
+}
+
+void OpenGL_Widget::restoreCalibrationState(const CalibrationState &state)
+{
+	for (int eye = 0; eye < 2; eye++) {
+		for (int col = 0; col < 3; col++) {
+			distortionTypes[eye][col] = state.types[eye][col];
+			for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+				NLT_Coeffecients[eye][col][cof] = state.coeffs[eye][col][cof];
+		}
+		for (int axis = 0; axis < 2; axis++) {
+			Intrinsics[eye][axis][axis] = state.aspect[eye][axis];
+			Intrinsics[eye][axis][2] = state.center[eye][axis];
+			Centers[eye][axis] = state.centers[eye][axis];
+		}
+	}
+	d_cop_l = QPointF(state.cop[0][0], state.cop[0][1]);
+	d_cop_r = QPointF(state.cop[1][0], state.cop[1][1]);
+	d_cop_l_Prev = QPointF(state.copPrev[0][0], state.copPrev[0][1]);
+	d_cop_r_Prev = QPointF(state.copPrev[1][0], state.copPrev[1][1]);
+	status = static_cast<StatusValues>(state.status);
+
+	lensChanged(LEFT_EYE | RIGHT_EYE, GREEN | BLUE | RED);
+}
+
+void OpenGL_Widget::undo()
+{
+	CalibrationState state;
+	if (!history.undo(state)) {
+		QApplication::beep();
+		return;
+	}
+	restoreCalibrationState(state);
+	printf("Undo (%d more, %d to redo)\n", history.undoSteps(), history.redoSteps());
+}
+
+void OpenGL_Widget::redo()
+{
+	CalibrationState state;
+	if (!history.redo(state)) {
+		QApplication::beep();
+		return;
+	}
+	restoreCalibrationState(state);
+	printf("Redo (%d more, %d to undo)\n", history.redoSteps(), history.undoSteps());
+}
+
+void OpenGL_Widget::journalChange(const CalibrationState &state)
+{
+	if (!journal.active()) {
+		// Changes left from before are gone once there are new ones
+		if (journalReplay > 0)
+			printf("NOTE: Dropped the %d changes in \"%s\"\n", journalReplay, configJournalFile(configFile).toLocal8Bit().constData());
+		journalReplay = 0;
+
+		QString error;
+		if (!journal.start(configJournalFile(configFile), sizeof(CalibrationState), error)) {
+			printf("ERROR: No crash recovery journal, %s\n", error.toLocal8Bit().constData());
+			return;
+		}
+	}
+	journal.append(&state);
+}
+
+void OpenGL_Widget::replayJournal()
+{
+	if (journalReplay == 0) {
+		printf("ERROR: No unsaved changes to replay for \"%s\"\n", configFile.toLocal8Bit().constData());
+		QApplication::beep();
+		return;
+	}
+
+	// Each entry is the whole state so replaying is putting back the last one.
+	// It goes through keyPressEvent() like any other change, so it can be undone.
+	printf("Replayed %d changes from \"%s\"\n", journalReplay, configJournalFile(configFile).toLocal8Bit().constData());
+	journalReplay = 0;
+	restoreCalibrationState(journalState);
+}
+
+void OpenGL_Widget::switchHeadset(int direction)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	int count = configStore.refresh();
+	if (count == 0) {
+		printf("ERROR: No headset configs in the \"%s\" folder\n", CONFIG_STORE_DIR);
+		QApplication::beep();
+		return;
+	}
+
+	// Step from the headset being worked on, or start at either end
+	int current = configStore.find(configFile);
+	int next = current < 0 ? (direction > 0 ? 0 : count - 1) : (current + direction + count) % count;
+	const StoredConfig &config = configStore.entries()[next];
+
+	// Nothing is lost, it's waiting in the autosave for when we come back
+	if (unsavedChanges()) {
+		printf("NOTE: Unsaved values for \"%s\" are in \"%s\"\n", configFile.toLocal8Bit().constData(),
+			configAutosaveFile(configFile).toLocal8Bit().constData());
+		autosave();
+	}
+
+	if (!loadConfigFromJson(config.filename))
+		return;
+	headsetName = config.serial;
+	printf("Switched to headset %s%s%s%s (%d of %d) in %.1f ms\n", config.serial.toLocal8Bit().constData(),
+		config.model.isEmpty() ? "" : " (", config.model.toLocal8Bit().constData(), config.model.isEmpty() ? "" : ")",
+		next + 1, count, timer.nsecsElapsed() / 1e6);
+	noteAutosave();
+	update();
+}
+
+void OpenGL_Widget::listHeadsets()
+{
+	int count = configStore.refresh();
+	if (count == 0) {
+		printf("No headset configs in the \"%s\" folder\n", CONFIG_STORE_DIR);
+		return;
+	}
+
+	int current = configStore.find(configFile);
+	printf("Headsets in \"%s\":\n", CONFIG_STORE_DIR);
+	for (int i = 0; i < count; i++) {
+		const StoredConfig &config = configStore.entries()[i];
+		printf("%s %-24s %-20s %s\n", i == current ? "*" : " ", config.serial.toLocal8Bit().constData(),
+			config.model.toLocal8Bit().constData(), QFileInfo(config.filename).fileName().toLocal8Bit().constData());
+	}
+}
+
+LensModel OpenGL_Widget::currentLensModel() {
+	LensModel model;
+	for (int eye = 0; eye < 2; eye++) {
+		for (int col = 0; col < 3; col++) {
+			model.types[eye][col] = distortionTypes[eye][col];
+			for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+				model.coeffs[eye][col][cof] = NLT_Coeffecients[eye][col][cof];
+		}
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				model.intrinsics[eye][row][col] = Intrinsics[eye][row][col];
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 4; col++)
+				model.extrinsics[eye][row][col] = Extrinsics[eye][row][col];
+	}
+	model.width = d_width;
+	model.height = d_height;
+	model.applyAspect = (status & APPLY_LINEAR_TRANSFORM) == APPLY_LINEAR_TRANSFORM || (status & ONLY_ASEPECT_RATIO) == ONLY_ASEPECT_RATIO;
+	model.applyExtrinsics = (status & APPLY_LINEAR_TRANSFORM) == APPLY_LINEAR_TRANSFORM;
+
+	return model;
+}
+
+void OpenGL_Widget::applyLensModel(const LensModel &model) {
+	for (int eye = 0; eye < 2; eye++) {
+		for (int col = 0; col < 3; col++) {
+			distortionTypes[eye][col] = model.types[eye][col];
+			for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+				NLT_Coeffecients[eye][col][cof] = model.coeffs[eye][col][cof];
+		}
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 3; col++)
+				Intrinsics[eye][row][col] = model.intrinsics[eye][row][col];
+		for (int row = 0; row < 3; row++)
+			for (int col = 0; col < 4; col++)
+				Extrinsics[eye][row][col] = model.extrinsics[eye][row][col];
+	}
+
+	lensChanged(LEFT_EYE | RIGHT_EYE, GREEN | BLUE | RED);
+}
+
+void OpenGL_Widget::solveFromCorrespondences() {
+	std::vector<PointCorrespondence> points;
+	std::string error;
+	if (!loadCorrespondences(CORRESPONDENCE_FILE, points, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		QApplication::beep();
+		return;
+	}
+
+	LensModel model = currentLensModel();
+	LensSolverReport report = solveLensModel(model, points);
+
+	const char *eyeNames[2] = { "LEFT", "RIGHT" };
+	for (int eye = 0; eye < 2; eye++) {
+		if (report.points[eye] == 0)
+			continue;
+		printf("%s EYE: %d points, %d iterations%s, RMS error %g -> %g pixels\n", eyeNames[eye], report.points[eye],
+			report.iterations[eye], report.converged[eye] ? "" : " (not converged)", report.rmsBefore[eye], report.rmsAfter[eye]);
+	}
+
+	// The solve works on the intrinsics so move the centers over to match
+	applyLensModel(model);
+	ApplyIntrincstsToCenter();
+	saveConfigToJson(configFile);
+}
+
+void OpenGL_Widget::importRadiusTables() {
+	LensModel before = currentLensModel();
+	LensModel after = before;
+	RadialFit fits[2][3];
+	fitRadiusTables(RADIUS_TABLE_DIR, before, fits);
+
+	bool found = false, refused = false;
+	for (int eye = 0; eye < 2; eye++) {
+		for (int col = 0; col < 3; col++) {
+			const RadialFit &fit = fits[eye][col];
+			if (!fit.loaded)
+				continue;
+			found = true;
+
+			if (!fit.valid) {
+				printf("%s %s: NOT APPLIED - %s\n", lensEyeName(eye), lensColorName(col), fit.error.c_str());
+				continue;
+			}
+
+			std::stringstream k;
+			for (int cof = 0; cof < fit.terms; cof++)
+				k << " " << fit.coeffs[cof];
+			printf("%s %s: %d samples, k =%s, RMS error %g pixels, max error %g pixels\n", lensEyeName(eye), lensColorName(col),
+				fit.samples, k.str().c_str(), fit.rmsResidual, fit.maxResidual);
+
+			// A radius table can't say anything about terms past the radial part so those go back to 0
+			for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+				after.coeffs[eye][col][cof] = fit.coeffs[cof];
+
+			// Same rule as adjustCoeffecients(): no fold inside the eye unless it already had one further in
+			double fold = lensFoldRadius(after, eye, col);
+			double was = lensFoldRadius(before, eye, col);
+			if (fold >= 0 && (was < 0 || fold < was)) {
+				char msg[256];
+				sprintf(msg, "REFUSED: %s %s would fold over %.0f pixels from the center (%.0f%% of the way to the corner)",
+					lensEyeName(eye), lensColorName(col), fold, 100 * fold / lensMaxRadius(d_width, d_height));
+				printf("%s\n", msg);
+				foldWarning = msg;
+				refused = true;
+			}
+		}
+	}
+
+	if (!found) {
+		printf("ERROR: No radius tables found in \"%s\" (expected files like left_green.csv)\n", RADIUS_TABLE_DIR);
+		QApplication::beep();
+		return;
+	}
+	// All or nothing so the tables are never half applied
+	if (refused) {
+		printf("ERROR: Radius tables not applied\n");
+		QApplication::beep();
+		return;
+	}
+
+	applyChangedLensModel(after);
+	foldWarning.clear();
+
+	// Its own undo step even when R is hit again after editing the tables
+	history.record(calibrationState(), 0);
+}
+
+void OpenGL_Widget::sweepCoefficients() {
+	const StatusValues eyeFlags[2] = { LEFT_EYE, RIGHT_EYE };
+	const StatusValues colorFlags[3] = { GREEN, BLUE, RED };	// Same order as NLT_Coeffecients
+
+	// A config known to be right for the lens, otherwise the vendor's radius tables
+	SweepTarget targets[2][3];
+	std::string error;
+	if (QFile::exists(TARGET_FILE)) {
+		LensModel reference;
+		if (!loadLensModel(TARGET_FILE, d_width, d_height, reference, error)) {
+			printf("ERROR: %s\n", error.c_str());
+			QApplication::beep();
+			return;
+		}
+		sweepTargetsFromModel(reference, SWEEP_SPACING, targets);
+	}
+	else if (!sweepTargetsFromTables(RADIUS_TABLE_DIR, targets, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		QApplication::beep();
+		return;
+	}
+
+	SweepOptions options;
+	options.steps = SWEEP_STEPS;
+	options.range = SWEEP_RANGE;
+	for (int eye = 0; eye < 2; eye++)
+		for (int col = 0; col < 3; col++)
+			options.enabled[eye][col] = (status & eyeFlags[eye]) == eyeFlags[eye] && (status & colorFlags[col]) == colorFlags[col];
+
+	SweepResult results[2][3];
+	LensModel model = currentLensModel();
+	sweepLensModel(model, targets, options, results);
+
+	for (int eye = 0; eye < 2; eye++) {
+		for (int col = 0; col < 3; col++) {
+			const SweepResult &result = results[eye][col];
+			if (!result.swept)
+				continue;
+
+			printf("%s %s: %lld candidates (%lld outside -1..1) in %.2f seconds, RMS %g -> %g pixels\n", lensEyeName(eye), lensColorName(col),
+				result.evaluated, result.rejected, result.seconds, result.rmsBefore, result.best.empty() ? result.rmsBefore : result.best[0].rms);
+
+			// Only ever an improvement
+			if (result.best.empty() || result.best[0].rms >= result.rmsBefore)
+				continue;
+			for (int cof = 0; cof < result.terms; cof++)
+				model.coeffs[eye][col][cof] = result.best[0].coeffs[cof];
+		}
+	}
+	applyChangedLensModel(model);
+
+	if (!writeSweepResults(SWEEP_FILE, results, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		QApplication::beep();
+	}
+}
+
+void OpenGL_Widget::cycleDistortionType() {
+	StatusValues eyes[2] = { LEFT_EYE, RIGHT_EYE };
+	StatusValues colors[3] = { GREEN, BLUE, RED };
+
+	for (int eye = 0; eye < 2; eye++) {
+		if ((status & eyes[eye]) != eyes[eye])
+			continue;
+		for (int col = 0; col < 3; col++) {
+			if ((status & colors[col]) != colors[col])
+				continue;
+
+			// Every type starts with the same radial terms so the ones both have carry over, the rest start at 0
+			int type = (distortionTypes[eye][col] + 1) % distortionTypeCount();
+			int keep = std::min(distortionType(distortionTypes[eye][col]).radialTerms, distortionType(type).radialTerms);
+			for (int cof = keep; cof < LENS_MAX_TERMS; cof++)
+				NLT_Coeffecients[eye][col][cof] = 0.0;
+			distortionTypes[eye][col] = type;
+			printf("%s %s: %s\n", lensEyeName(eye), lensColorName(col), distortionType(type).name);
+		}
+	}
+
+	lensChanged(status & (LEFT_EYE | RIGHT_EYE), status & (GREEN | BLUE | RED));
+}
+
+void OpenGL_Widget::exportDistortionMesh() {
+	// The mesh is built from the center actually being drawn
+	LensModel model = currentLensModel();
+	double cop[2][2] = { { d_cop_l.x(), d_cop_l.y() }, { d_cop_r.x(), d_cop_r.y() } };
+
+	DistortionMesh meshes[2];
+	uint64_t keys[2];
+	for (int eye = 0; eye < 2; eye++) {
+		buildDistortionMesh(model, cop, eye, MESH_COLUMNS, MESH_ROWS, meshes[eye], &distortionCache);
+		keys[eye] = distortionMeshKey(model, cop, eye, MESH_COLUMNS, MESH_ROWS);
+	}
+
+	// Next to the config it's for. Nothing to do if the file on disk was made from the same values
+	QString meshFile = configMeshFile(configFile);
+	std::string filename = meshFile.toLocal8Bit().constData();
+	DistortionMesh existing[2];
+	int width, height;
+	uint64_t existingKeys[2];
+	std::string error;
+	if (loadDistortionMeshes(filename, existing, width, height, existingKeys, error)
+		&& existingKeys[0] == keys[0] && existingKeys[1] == keys[1]) {
+		printf("\"%s\" is already up to date\n", filename.c_str());
+		return;
+	}
+
+	if (!saveDistortionMeshes(filename, meshes, d_width, d_height, keys, error)) {
+		printf("ERROR: %s\n", error.c_str());
+		QApplication::beep();
+		return;
+	}
+	printf("Saved %dx%d distortion mesh for both eyes to \"%s\"\n", MESH_COLUMNS, MESH_ROWS, filename.c_str());
+}
+
+void OpenGL_Widget::analysePhoto() {
+	// A single photo or an image sequence standing in for a camera
+	QStringList files;
+	if (QFile::exists(CAPTURE_FILE)) {
+		files << CAPTURE_FILE;
+	}
+	else {
+		QDir captures(CAPTURE_DIR);
+		QStringList filters;
+		filters << "*.png" << "*.jpg" << "*.jpeg" << "*.bmp" << "*.tif" << "*.tiff";
+		foreach(const QString &name, captures.entryList(filters, QDir::Files, QDir::Name))
+			files << captures.filePath(name);
+	}
+
+	if (files.isEmpty()) {
+		printf("ERROR: No photo found. Save it as \"%s\" or put an image sequence in the \"%s\" folder\n", CAPTURE_FILE, CAPTURE_DIR);
+		QApplication::beep();
+		return;
+	}
+
+	const char *channelNames[3] = { "RED", "GREEN", "BLUE" };
+	foreach(const QString &filename, files) {
+		QImage image;
+		if (!image.load(filename)) {
+			printf("ERROR: Unable to load \"%s\"\n", filename.toLocal8Bit().constData());
+			continue;
+		}
+		image = image.convertToFormat(QImage::Format_RGB32);
+
+		GridAnalysis analysis;
+		analyseGridImage(reinterpret_cast<const uint32_t *>(image.constBits()), image.width(), image.height(),
+			image.bytesPerLine() / 4, analysis);
+
+		printf("%s (%dx%d) analysed in %.3f seconds\n", filename.toLocal8Bit().constData(), image.width(), image.height(), analysis.seconds);
+		for (int c = 0; c < 3; c++)
+			printf("    %-5s %4d lines, RMS straightness %.3f pixels\n", channelNames[c], analysis.lineCount[c], analysis.rmsStraightness[c]);
+		for (const DetectedLine &line : analysis.lines) {
+			printf("    %-5s %s line at %8.2f: RMS %.3f max %.3f pixels from straight\n", channelNames[line.channel],
+				line.vertical ? "vertical  " : "horizontal", line.position, line.rmsStraightness, line.maxStraightness);
+		}
+		printf("    RED to GREEN separation:  RMS %.3f max %.3f pixels (%d lines)\n",
+			analysis.redToGreen.rms, analysis.redToGreen.max, analysis.redToGreen.matched);
+		printf("    BLUE to GREEN separation: RMS %.3f max %.3f pixels (%d lines)\n",
+			analysis.blueToGreen.rms, analysis.blueToGreen.max, analysis.blueToGreen.matched);
+
+		char msg[1024];
+		sprintf(msg, "Photo: straightness R %.2f G %.2f B %.2f px    separation R-G %.2f B-G %.2f px",
+			analysis.rmsStraightness[GRID_RED], analysis.rmsStraightness[GRID_GREEN], analysis.rmsStraightness[GRID_BLUE],
+			analysis.redToGreen.rms, analysis.blueToGreen.rms);
+		photoSummary = msg;
+	}
+}
+
+void OpenGL_Widget::lensChanged(StatusValues eyes, StatusValues colors) {
+	const StatusValues eyeFlags[2] = { LEFT_EYE, RIGHT_EYE };
+	const StatusValues colorFlags[3] = { GREEN, BLUE, RED };	// Same order as NLT_Coeffecients
+
+	for (int eye = 0; eye < 2; eye++)
+		if ((eyes & eyeFlags[eye]) == eyeFlags[eye])
+			eyeTransformDirty[eye] = true;
+
+	for (int eye = 0; eye < 2; eye++)
+		for (int col = 0; col < 3; col++)
+			if ((eyes & eyeFlags[eye]) == eyeFlags[eye] && (colors & colorFlags[col]) == colorFlags[col]) {
+				residualMetric.invalidate(eye, col);
+				lensRemap.invalidate(eye, col);
+				heatmap.invalidate(eye, col);
+			}
+}
+
+const LensEyeTransform &OpenGL_Widget::eyeTransform(int eye, QPointF cop) {
+	LensEyeTransform &transform = eyeTransforms[eye];
+	if (eyeTransformDirty[eye] || transform.centerX() != cop.x() || transform.centerY() != cop.y()) {
+		transform = LensEyeTransform(currentLensModel(), eye, cop.x(), cop.y());
+		eyeTransformDirty[eye] = false;
 	}
+	return transform;
+}
+
+void OpenGL_Widget::loadResidualTarget() {
+	// A reference config known to be right for this lens wins over measured points
+	if (QFile::exists(TARGET_FILE)) {
+		std::vector<char> buffer;
+		rapidjson::Document target;
+		LensModel model = currentLensModel();
+		std::string error;
+		if (!parseConfigFile(TARGET_FILE, buffer, target, error) || !readLensModel(target, model, error)) {
+			printf("ERROR: \"%s\" is not a valid config file: %s\n", TARGET_FILE, error.c_str());
+			QApplication::beep();
+			return;
+		}
+
+		// SteamVR always applies the full linear transform
+		model.applyAspect = true;
+		model.applyExtrinsics = true;
+		residualMetric.setTarget(model);
+		printf("Residual metric now compares against the profile in \"%s\"\n", TARGET_FILE);
+		return;
+	}
+
+	std::vector<PointCorrespondence> points;
+	std::string error;
+	if (!loadCorrespondences(CORRESPONDENCE_FILE, points, error)) {
+		printf("ERROR: No \"%s\" and %s\n", TARGET_FILE, error.c_str());
+		QApplication::beep();
+		return;
+	}
+	residualMetric.setTarget(points);
+	printf("Residual metric now compares against %d measured points from \"%s\"\n", (int)points.size(), CORRESPONDENCE_FILE);
 }
 
 void OpenGL_Widget::resetCenter(bool resetIntrinsics) {
@@ -1278,6 +2533,8 @@ void OpenGL_Widget::resetCenter(bool resetIntrinsics) {
 			Intrinsics[1][1][2] = 0.0;
 		}
 	}
+
+	lensChanged(status & (LEFT_EYE | RIGHT_EYE), GREEN | BLUE | RED);
 }
 
 void OpenGL_Widget::resetCoeffiecents() {
@@ -1325,16 +2582,72 @@ void OpenGL_Widget::resetCoeffiecents() {
 	if ((status & RIGHT_EYE) && (status & RED) && (status & THIRD_COEFFICIENT))
 		NLT_Coeffecients[1][2][2] = 0;
 
+	lensChanged(status & (LEFT_EYE | RIGHT_EYE), status & (GREEN | BLUE | RED));
+}
+
+void OpenGL_Widget::toggleImageMode() {
+	if (imageMode) {
+		imageMode = false;
+		return;
+	}
+
+	// Load it every time so you can swap the image without restarting
+	QImage image;
+	if (!image.load(TEST_IMAGE_FILE)) {
+		printf("ERROR: Unable to load \"%s\"\n", TEST_IMAGE_FILE);
+		QApplication::beep();
+		return;
+	}
+	testImage = image.convertToFormat(QImage::Format_RGB32);
+	warpedDirty = true;
+	imageMode = true;
 }
 
 void OpenGL_Widget::drawImages() {
-	update();
-	return;
+	if (testImage.isNull())
+		return;
+
+	// The tables are only rebuilt for the eyes/colors lensChanged() reported and
+	// the image only gets resampled again when they (or the image) changed
+	double cop[2][2] = { { d_cop_l.x(), d_cop_l.y() }, { d_cop_r.x(), d_cop_r.y() } };
+	if (lensRemap.update(currentLensModel(), cop))
+		warpedDirty = true;
+
+	if (warpedImage.width() != d_width || warpedImage.height() != d_height) {
+		warpedImage = QImage(d_width, d_height, QImage::Format_RGB32);
+		warpedDirty = true;
+	}
 
+	if (warpedDirty) {
+		lensRemap.resample((const uint32_t *)testImage.constBits(), testImage.width(), testImage.height(),
+			testImage.bytesPerLine() / 4, (uint32_t *)warpedImage.bits());
+		warpedDirty = false;
+	}
 
+	glRasterPos2i(0, 0);
+	glDrawPixels(d_width, d_height, GL_BGRA, GL_UNSIGNED_BYTE, warpedImage.constBits());
 }
-void OpenGL_Widget::drawImagesOverlay() {
 
+void OpenGL_Widget::cycleHeatmap() {
+	heatmapMode = (HeatmapMode)((heatmapMode + 1) % HEATMAP_MODES);
+	printf("Heatmap: %s\n", heatmapModeName(heatmapMode));
+}
+
+void OpenGL_Widget::drawHeatmap() {
+	// Only the eyes/colors lensChanged() reported that this mode uses get
+	// computed again
+	double cop[2][2] = { { d_cop_l.x(), d_cop_l.y() }, { d_cop_r.x(), d_cop_r.y() } };
+	heatmap.update(currentLensModel(), cop, heatmapMode);
+	if (!heatmap.pixels())
+		return;
+
+	glRasterPos2i(0, 0);
+	glDrawPixels(heatmap.width(), heatmap.height(), GL_BGRA, GL_UNSIGNED_BYTE, heatmap.pixels());
+}
+
+void OpenGL_Widget::drawImagesOverlay() {
+	// Keep the centers visible so the image can be lined up
+	drawCrossHairs();
 }
 
 //void OpenGL_Widget::paintEvent(QPaintEvent *event) {
@@ -1366,4 +2679,4 @@ void OpenGL_Widget::drawImagesOverlay() {
 //
 //	painter.end();
 //	printf("here!!!");
-//}
\ No newline at end of file
+//}
@@ -26,7 +26,20 @@ https://github.com/OSVR/distortionizer
 
 #pragma once
 #include "opengl_widget.h"
+#include "lens_model.h"
+#include "residual_metric.h"
+#include "lens_remap.h"
+#include "lens_heatmap.h"
+#include "distortion_cache.h"
+#include "lens_config.h"
+#include "config_saver.h"
+#include "config_store.h"
+#include "undo_history.h"
+#include "change_journal.h"
+#include "control_server.h"
 #include <QGLWidget>
+#include <QFileSystemWatcher>
+#include <QTimer>
 //#include "undistort_shader.h"
 
 #include "rapidjson/document.h"
@@ -78,6 +91,22 @@ inline StatusValues operator&&(StatusValues a, StatusValues b)
 {
 	return static_cast<StatusValues>(static_cast<int>(a) && static_cast<int>(b));
 }
+
+// Everything the keys change, about 450 bytes, for undo/redo. The Extrinsics
+// aren't in here because nothing in the tool edits them.
+struct CalibrationState {
+	double coeffs[2][3][LENS_MAX_TERMS];	// NLT_Coeffecients
+	double aspect[2][2];					// Intrinsics [0][0] and [1][1]
+	double center[2][2];					// Intrinsics [0][2] and [1][2]
+	double centers[2][2];					// Centers
+	double cop[2][2];						// d_cop_l, d_cop_r
+	double copPrev[2][2];					// d_cop_l_Prev, d_cop_r_Prev
+	int status;
+	unsigned char types[2][3];				// distortionTypes
+};
+
+#define UNDO_STEPS 256
+
 // There are three different indices of refraction for the three
 // different wavelengths in the head-mounted display (R, G, B).
 // This is equivalent to having lenses with three different
@@ -113,7 +142,8 @@ inline StatusValues operator&&(StatusValues a, StatusValues b)
 //
 // When there are nonzero coefficients for higher-order terms
 // (K2 and above), the result is a fourth-order polynomial that
-// is challenging to invert analytically.
+// is challenging to invert analytically. LensInverse (lens_inverse.h)
+// does it numerically instead.
 
 class OpenGL_Widget : public QGLWidget 
 {
@@ -134,11 +164,58 @@ protected:
 	void resizeGL(int width, int height);
 	void mousePressEvent(QMouseEvent *event);
 	void mouseMoveEvent(QMouseEvent *event);
+	void mouseReleaseEvent(QMouseEvent *event);
 	void keyPressEvent(QKeyEvent *event);
 
 	//------------------------------------------------------
 	bool saveConfigToJson(QString filename);
 	bool loadConfigFromJson(QString filename);
+	// Parse a config without touching the current one, then make it the current one
+	bool readConfig(const QString &filename, std::vector<char> &buffer, rapidjson::Document &loaded, LensModel &model, std::string &error);
+	void adoptConfig(const QString &filename, std::vector<char> &buffer, rapidjson::Document &loaded, const LensModel &model);
+
+	// Write the current values to the autosave file if anything changed since the last save
+	void autosave();
+	// Whether the values a save writes differ from what configFile holds
+	bool unsavedChanges();
+	bool lensValuesDiffer(const LensModel &model);
+	// Print how the background saves went
+	void reportSaves();
+	// Mention an autosave of the current config newer than the config itself
+	void noteAutosave();
+
+	CalibrationState calibrationState();
+	void restoreCalibrationState(const CalibrationState &state);
+	// Step back/forward through the history, CTRL+Z and CTRL+Y
+	void undo();
+	void redo();
+
+	// Append a changed state to the journal of the config, starting a new journal if needed
+	void journalChange(const CalibrationState &state);
+	// Put back the changes left in the journal by a session that didn't save them
+	void replayJournal();
+
+	// Watch configFile for other programs writing to it
+	void watchConfig();
+	// The config (or its folder when folder is set) changed on disk, reload once the writes stop
+	void configFileChanged(bool folder);
+	// Take on what changed in the config since it was loaded or saved, only rebuilding the eyes/colors that differ
+	void reloadChangedConfig();
+	// Copy in the parts of model that differ from the values in use and rebuild only the eyes/colors
+	// they belong to. Returns which those were, for the console.
+	std::string applyChangedLensModel(const LensModel &model);
+
+	// Answer everything the control socket received, see README for the requests
+	void handleControlRequests();
+	bool handleControlRequest(const std::string &text, rapidjson::Writer<rapidjson::StringBuffer> &writer, std::string &error);
+	void writeControlState(rapidjson::Writer<rapidjson::StringBuffer> &writer);
+	// Where a file named in a request resolves to, as long as it's in the folder
+	// of CONFIG_FILE or the store and has one of the suffixes
+	bool controlPath(const rapidjson::Value &value, const QStringList &suffixes, QString &filename, std::string &error);
+
+	// Load the next (direction 1) or previous (-1) headset in the config store
+	void switchHeadset(int direction);
+	void listHeadsets();
 
 	//------------------------------------------------------
 	// Used as options in the rendering, depending on our
@@ -190,14 +267,58 @@ protected:
 	// The user is possbility maintaining two centers so we need to allow them to convert the one center to intrinsics if they wamt
 	void ApplyCenterToIntrinsics();		
 	void ApplyIntrincstsToCenter();
+	// Center of projection in pixels the intrinsics of an eye put it at
+	QPointF intrinsicsCenter(int eye);
 
 	void resetCenter(bool resetIntrinsics = false);
 	void resetCoeffiecents();
 
 	void loadInitalValues();
 
+	// Copy the calibration state in/out of the shared lens model used by the solvers
+	LensModel currentLensModel();
+	void applyLensModel(const LensModel &model);
+
+	// Fit coefficients, center and aspect ratio to measured grid intersections
+	void solveFromCorrespondences();
+
+	// Fit the coefficients to the lens vendor's radius tables
+	void importRadiusTables();
+
+	// Change the active coefficients of the dragged eye as little as possible so the grabbed
+	// grid intersection is drawn at target
+	void dragGridPoint(QPointF target);
+
+	// Search k1..k3 of the active eyes/colors around their values for the best match
+	// to the target config or the radius tables, apply the best and save the ranking
+	void sweepCoefficients();
+
+	// Switch the active eyes/colors to the next distortion type
+	void cycleDistortionType();
+
+	// Find the grid lines in a photo of the lens output and report how straight
+	// they are and how far the colors sit apart
+	void analysePhoto();
+
+	// Something changed the model for the given eyes/colors so the cached
+	// results that depend on it need to be evaluated again
+	void lensChanged(StatusValues eyes, StatusValues colors);
+
+	// Precomposed linear transform of an eye around cop, rebuilt after lensChanged()
+	const LensEyeTransform &eyeTransform(int eye, QPointF cop);
+
+	// Load the reference profile (or measured points) the residual metric compares against
+	void loadResidualTarget();
+
+	// Build the per eye mesh SteamVR draws with and save it next to the config
+	void exportDistortionMesh();
+
+	// Show the test image pre-distorted through the current model instead of the grid
+	void toggleImageMode();
 	void drawImages();
 	void drawImagesOverlay();
+	void cycleHeatmap();
+	void drawHeatmap();
 	//void paintEvent(QPaintEvent *event);
 
 private:
@@ -213,20 +334,61 @@ private:
 									
 
 	bool displayOverValues;
-	double NLT_Coeffecients[2][3][3];	 // Eyes, Colors, Terms
+	double NLT_Coeffecients[2][3][LENS_MAX_TERMS];	 // Eyes, Colors, Terms
+	int distortionTypes[2][3];			 // Eyes, Colors: index of the DistortionType ("type" in the config)
 	double Centers[2][2];				 // Eyes, X/Y
 	double Intrinsics[2][3][3];			// Eyes [3x4] matrix
 										//[ horizontal aspect ratio,		0,								CenterX]
 										//[ 0,								vertical aspect ratio,			Center Y]
 										//[ 0,								0,								-1]
 
-	// Extrinsics crrently not supported
-	double Extrinsics[2][4][4];			// Eyes [4x4] matrix
+	double Extrinsics[2][4][4];			// Eyes [4x4] matrix, the 3x4 eye to head pose from the config plus [0 0 0 1]
+
+	// Aspect ratio, Extrinsics rotation and center folded into one transform per eye for transformPoint()
+	LensEyeTransform eyeTransforms[2];
+	bool eyeTransformDirty[2] = { true, true };
 	
+	std::vector<char> jsonBuffer;	// The file json was parsed in place from, its strings point into this
 	rapidjson::Document json;
+	ConfigHandles configHandles;	// Values in json a save writes to
+	ConfigSaver configSaver;		// Declared after json so pending saves finish before it goes
+	QString configFile;				// Where S saves and L loads, the headset picked from the store
+	ConfigStore configStore;
+	QString headsetName;			// Serial of the headset picked from the store, empty for HMD_Config.json
+	QFileSystemWatcher *configWatcher;	// configFile and its folder
+	QTimer *configReloadTimer;		// Waits for the writes to a changed config to stop
+	LensModel configModel;			// What configFile holds as of the last load, save or reload
+	double configCenters[2][2];
+	LensModel autosaveModel;		// What the last autosave wrote, configModel until there is one
+	UndoHistory<CalibrationState, UNDO_STEPS> history;	// Since the config was loaded
+	ChangeJournal journal;			// Every change since the config was last saved, for crash recovery
+	int journalReplay = 0;			// Changes found in the journal when the config was loaded, until replayed or discarded
+	CalibrationState journalState;	// The newest of them
+	ControlServer controlServer;	// Automation setting values and asking for frames
 	StatusValues status;
 	double coeffecientOffset;
 
-	bool IntrensicsMode = false;
+	bool imageMode = false;		// Showing the pre-distorted test image instead of the grid
+	QImage testImage;
+	QImage warpedImage;			// testImage through lensRemap, rows bottom up
+	bool warpedDirty = true;
+	LensRemap lensRemap;
+
+	HeatmapMode heatmapMode = HEATMAP_OFF;	// Shown under the grid
+	LensHeatmap heatmap;
 
-};
\ No newline at end of file
+	DistortionCache distortionCache;	// Computed tables from earlier runs/configs
+
+	QString photoSummary;		// Result of the last analysePhoto() for the status overlay
+	QString foldWarning;		// Why the last coefficient change was refused, for the status overlay
+
+	bool dragging = false;		// A grid intersection is held with the mouse
+	int dragEye;
+	QPointF dragPoint;			// The grid intersection (undistorted)
+	double dragStart[3][LENS_MAX_TERMS];	// Coefficients of the eye when it was grabbed
+	CalibrationState dragBefore;
+	QString dragStatus;			// How close the drag gets, for the status overlay
+
+	ResidualMetric residualMetric;
+
+};
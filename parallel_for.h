@@ -0,0 +1,71 @@
+/** @file
+@brief Small helper for splitting batch math across worker threads
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Number of threads used for the batch math (solver, fitting, dense maps)
+inline int workerThreadCount()
+{
+	unsigned int count = std::thread::hardware_concurrency();
+	return count == 0 ? 4 : (int)count;
+}
+
+// Run fn(begin, end, worker) over [0, count) split into one contiguous
+// chunk per worker thread and wait for all of them to finish. The worker
+// index is in [0, workerThreadCount()) so callers can keep per thread
+// accumulators without locking. Small jobs run on the calling thread.
+template <typename Fn>
+void parallelFor(int count, Fn fn, int minChunk = 1)
+{
+	if (count <= 0)
+		return;
+
+	int workers = std::min(workerThreadCount(), (count + minChunk - 1) / std::max(minChunk, 1));
+	if (workers <= 1) {
+		fn(0, count, 0);
+		return;
+	}
+
+	int chunk = (count + workers - 1) / workers;
+	std::vector<std::thread> threads;
+	threads.reserve(workers - 1);
+	for (int worker = 1; worker < workers; worker++) {
+		int begin = worker * chunk;
+		int end = std::min(count, begin + chunk);
+		if (begin >= end)
+			break;
+		threads.emplace_back([=, &fn] { fn(begin, end, worker); });
+	}
+
+	// The calling thread takes the first chunk itself
+	fn(0, std::min(count, chunk), 0);
+
+	for (auto &thread : threads)
+		thread.join();
+}
@@ -0,0 +1,166 @@
+/** @file
+@brief Fit the radial coefficients to measured radius tables
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "radius_table.h"
+#include "csv_reader.h"
+#include "lens_model.h"
+#include "lens_solver.h"
+#include "parallel_for.h"
+
+#include <fstream>
+
+bool loadRadiusTable(const std::string &filename, std::vector<RadiusSample> &samples, std::string &error)
+{
+	std::ifstream file(filename.c_str());
+	if (!file) {
+		error = "Unable to open " + filename;
+		return false;
+	}
+
+	samples.clear();
+	std::string line;
+	std::vector<std::string> fields;
+	int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		if (!csvSplit(line, fields))
+			continue;
+
+		RadiusSample sample;
+		if (fields.size() != 2 || !csvNumber(fields[0], sample.ideal) || !csvNumber(fields[1], sample.observed)) {
+			// Allow a header line before any data
+			if (samples.empty() && lineNumber == 1)
+				continue;
+			std::stringstream msg;
+			msg << filename << ":" << lineNumber << ": expected ideal_radius,observed_radius";
+			error = msg.str();
+			return false;
+		}
+		samples.push_back(sample);
+	}
+	return true;
+}
+
+bool fitRadialCoefficients(const std::vector<RadiusSample> &samples, double maxRadius, RadialFit &fit, int terms)
+{
+	fit.valid = false;
+	fit.samples = 0;
+	fit.terms = terms = std::max(1, std::min(terms, LENS_MAX_TERMS));
+	fit.rmsResidual = fit.maxResidual = 0;
+
+	// Normal equations of the weighted linear problem. Weighting each row by
+	// observed^2 / ideal turns the error in (ideal / observed - 1) back into
+	// (roughly) pixels so the inner radii don't dominate the fit.
+	double A[LENS_MAX_TERMS * LENS_MAX_TERMS] = { 0 }, b[LENS_MAX_TERMS] = { 0 };
+	for (const RadiusSample &sample : samples) {
+		if (sample.ideal <= 0 || sample.observed <= 0)
+			continue;
+
+		double q = sample.ideal * sample.ideal / (maxRadius * maxRadius);
+		double row[LENS_MAX_TERMS];
+		row[0] = q;
+		for (int i = 1; i < terms; i++)
+			row[i] = row[i - 1] * q;
+		double y = sample.ideal / sample.observed - 1;
+		double w = sample.observed * sample.observed / sample.ideal;
+		w *= w;
+
+		for (int i = 0; i < terms; i++) {
+			b[i] += w * row[i] * y;
+			for (int j = 0; j < terms; j++)
+				A[i * terms + j] += w * row[i] * row[j];
+		}
+		fit.samples++;
+	}
+
+	if (fit.samples < terms) {
+		std::stringstream msg;
+		msg << "need at least " << terms << " samples with a positive radius";
+		fit.error = msg.str();
+		return false;
+	}
+
+	if (!choleskySolve(terms, A, b)) {
+		fit.error = "the radii don't constrain all the coefficients";
+		return false;
+	}
+
+	double sum = 0;
+	for (const RadiusSample &sample : samples) {
+		if (sample.ideal <= 0 || sample.observed <= 0)
+			continue;
+		double predicted = sample.ideal * lensRadialScale(b, terms, maxRadius, sample.ideal * sample.ideal);
+		double residual = fabs(predicted - sample.observed);
+		sum += residual * residual;
+		if (residual > fit.maxResidual)
+			fit.maxResidual = residual;
+	}
+	fit.rmsResidual = sqrt(sum / fit.samples);
+
+	for (int i = 0; i < LENS_MAX_TERMS; i++)
+		fit.coeffs[i] = b[i];
+
+	// Same rule adjustCoeffecients() uses
+	for (int i = 0; i < terms; i++) {
+		if (fabs(b[i]) > 1) {
+			fit.error = "coefficients fall outside the -1 < X < 1 range SteamVR accepts";
+			return false;
+		}
+	}
+
+	fit.valid = true;
+	return true;
+}
+
+void fitRadiusTables(const std::string &directory, const LensModel &model, RadialFit fits[2][3])
+{
+	double maxRadius = lensMaxRadius(model.width, model.height);
+
+	// Six small independent fits, one per worker
+	parallelFor(6, [&](int begin, int end, int) {
+		for (int i = begin; i < end; i++) {
+			int eye = i / 3, color = i % 3;
+			RadialFit &fit = fits[eye][color];
+			fit.loaded = fit.valid = false;
+			fit.samples = 0;
+			fit.terms = distortionType(model.types[eye][color]).radialTerms;
+			for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+				fit.coeffs[cof] = 0;
+			fit.rmsResidual = fit.maxResidual = 0;
+			fit.error.clear();
+
+			std::string filename = directory + "/" + lensEyeName(eye) + "_" + lensColorName(color) + ".csv";
+			std::vector<RadiusSample> samples;
+			if (!std::ifstream(filename.c_str()))
+				continue;
+
+			fit.loaded = true;
+			if (loadRadiusTable(filename, samples, fit.error))
+				fitRadialCoefficients(samples, maxRadius, fit, fit.terms);
+		}
+	});
+}
@@ -0,0 +1,63 @@
+/** @file
+@brief Fit the radial coefficients to measured radius tables
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include "lens_model.h"
+#include <string>
+#include <vector>
+
+// One row of a lens vendor radius table. Both radii are in pixels from the
+// center of projection: where a point should be and where it has to be drawn.
+struct RadiusSample {
+	double ideal;
+	double observed;
+};
+
+struct RadialFit {
+	bool loaded;			// A table was found for this eye/color
+	bool valid;				// The fit worked and fits in the -1 <= X <= 1 range
+	int samples;
+	int terms;				// Radial coefficients fitted
+	double coeffs[LENS_MAX_TERMS];
+	double rmsResidual;		// Pixels
+	double maxResidual;		// Pixels
+	std::string error;
+};
+
+// Read a table with one "ideal_radius, observed_radius" pair per line.
+bool loadRadiusTable(const std::string &filename, std::vector<RadiusSample> &samples, std::string &error);
+
+// Least squares fit of k1..kN (N = terms) to a table. Because transformPoint()
+// divides by a polynomial in r^2 this is linear in the coefficients:
+//    ideal / observed - 1 = k1*q + k2*q^2 + ... + kN*q^N,  q = (ideal / maxRadius)^2
+bool fitRadialCoefficients(const std::vector<RadiusSample> &samples, double maxRadius, RadialFit &fit, int terms = 3);
+
+// Load <directory>/<eye>_<color>.csv (e.g. left_green.csv) for every eye and
+// color and fit them all in parallel, each with as many terms as the radial
+// part of its distortion type in the model. fits[eye][color] uses the same
+// layout as NLT_Coeffecients.
+void fitRadiusTables(const std::string &directory, const LensModel &model, RadialFit fits[2][3]);
@@ -0,0 +1,277 @@
+/** @file
+@brief Numeric figure of merit for line straightness and color fringing
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "residual_metric.h"
+
+#include <algorithm>
+#include <map>
+#include <math.h>
+
+ResidualMetric::ResidualMetric()
+	: targetLoaded(false)
+{
+	clearTarget();
+}
+
+void ResidualMetric::clearTarget()
+{
+	targetLoaded = false;
+	for (int eye = 0; eye < 2; eye++) {
+		eyes[eye] = Eye();
+		separation[eye][0] = separation[eye][1] = 0;
+		for (int color = 0; color < 3; color++) {
+			errorX[eye][color].clear();
+			errorY[eye][color].clear();
+			bendSumSq[eye][color] = 0;
+			bendCount[eye][color] = 0;
+			dirty[eye][color] = true;
+		}
+	}
+}
+
+void ResidualMetric::setTarget(const LensModel &target, int spacing, int step)
+{
+	clearTarget();
+
+	for (int eye = 0; eye < 2; eye++) {
+		Eye &e = eyes[eye];
+		int left = eye * target.width / 2, right = left + target.width / 2;
+		int centerX = left + target.width / 4, centerY = target.height / 2;
+		double copX, copY;
+		lensCenterOfProjection(target, eye, copX, copY);
+		LensEyeTransform transform(target, eye, copX, copY);
+
+		auto addLine = [&](bool vertical, double fixed) {
+			Line line;
+			line.vertical = vertical;
+			int length = vertical ? target.height : target.width / 2;
+			for (int along = 0; along < length; along += step) {
+				double x = vertical ? fixed : left + along;
+				double y = vertical ? along : fixed;
+				line.samples.push_back((int)e.idealX.size());
+				e.idealX.push_back(x);
+				e.idealY.push_back(y);
+				for (int color = 0; color < 3; color++) {
+					double tx, ty;
+					lensDistortWith(target, transform, eye, color, x, y, tx, ty);
+					e.targetX[color].push_back(tx);
+					e.targetY[color].push_back(ty);
+				}
+			}
+			e.lines.push_back(line);
+		};
+
+		// Same layout drawGrid() uses, lines every spacing pixels out from the center
+		for (int x = centerX + spacing; x < right; x += spacing)
+			addLine(true, x);
+		for (int x = centerX - spacing; x > left; x -= spacing)
+			addLine(true, x);
+		for (int y = centerY + spacing; y < target.height; y += spacing)
+			addLine(false, y);
+		for (int y = centerY - spacing; y > 0; y -= spacing)
+			addLine(false, y);
+	}
+
+	targetLoaded = true;
+}
+
+void ResidualMetric::setTarget(const std::vector<PointCorrespondence> &points)
+{
+	clearTarget();
+
+	for (int eye = 0; eye < 2; eye++) {
+		Eye &e = eyes[eye];
+
+		// Points measured for several colors at the same ideal spot share a sample
+		std::map<std::pair<long, long>, int> index;
+		for (const PointCorrespondence &p : points) {
+			if (p.eye != eye)
+				continue;
+			std::pair<long, long> key(lround(p.idealX * 2), lround(p.idealY * 2));
+			auto found = index.find(key);
+			int sample;
+			if (found == index.end()) {
+				sample = (int)e.idealX.size();
+				index[key] = sample;
+				e.idealX.push_back(p.idealX);
+				e.idealY.push_back(p.idealY);
+				for (int color = 0; color < 3; color++) {
+					e.targetX[color].push_back(NAN);
+					e.targetY[color].push_back(NAN);
+				}
+			}
+			else {
+				sample = found->second;
+			}
+			e.targetX[p.color][sample] = p.observedX;
+			e.targetY[p.color][sample] = p.observedY;
+		}
+
+		// Samples with the same ideal X make a vertical line, same Y a horizontal one
+		std::map<long, std::vector<int> > columns, rows;
+		for (int i = 0; i < (int)e.idealX.size(); i++) {
+			columns[lround(e.idealX[i] * 2)].push_back(i);
+			rows[lround(e.idealY[i] * 2)].push_back(i);
+		}
+		for (int vertical = 0; vertical < 2; vertical++) {
+			for (auto &group : vertical ? columns : rows) {
+				if (group.second.size() < 3)
+					continue;
+				Line line;
+				line.vertical = vertical != 0;
+				line.samples = group.second;
+				const std::vector<double> &along = vertical ? e.idealY : e.idealX;
+				std::sort(line.samples.begin(), line.samples.end(), [&](int a, int b) { return along[a] < along[b]; });
+				e.lines.push_back(line);
+			}
+		}
+	}
+
+	targetLoaded = true;
+}
+
+void ResidualMetric::invalidate(int eye, int color)
+{
+	dirty[eye][color] = true;
+}
+
+void ResidualMetric::invalidateAll()
+{
+	for (int eye = 0; eye < 2; eye++)
+		for (int color = 0; color < 3; color++)
+			dirty[eye][color] = true;
+}
+
+void ResidualMetric::update(const LensModel &model, const double cop[2][2])
+{
+	if (!targetLoaded)
+		return;
+
+	for (int eye = 0; eye < 2; eye++) {
+		bool changed = false;
+		for (int color = 0; color < 3; color++) {
+			if (dirty[eye][color]) {
+				evaluate(model, cop, eye, color);
+				dirty[eye][color] = false;
+				changed = true;
+			}
+		}
+		if (changed)
+			evaluateSeparation(eye);
+	}
+}
+
+void ResidualMetric::evaluate(const LensModel &model, const double cop[2][2], int eye, int color)
+{
+	const Eye &e = eyes[eye];
+	size_t count = e.idealX.size();
+	std::vector<double> &ex = errorX[eye][color], &ey = errorY[eye][color];
+	ex.resize(count);
+	ey.resize(count);
+
+	LensEyeTransform transform(model, eye, cop[eye][0], cop[eye][1]);
+	for (size_t i = 0; i < count; i++) {
+		double x, y;
+		lensDistortWith(model, transform, eye, color, e.idealX[i], e.idealY[i], x, y);
+		ex[i] = x - e.targetX[color][i];
+		ey[i] = y - e.targetY[color][i];
+	}
+
+	// Fit a straight line to each perceived grid line and sum up what's left
+	double sumSq = 0;
+	int n = 0;
+	for (const Line &line : e.lines) {
+		double sa = 0, sc = 0, saa = 0, sac = 0;
+		int m = 0;
+		for (int i : line.samples) {
+			if (std::isnan(ex[i]))
+				continue;
+			double along = line.vertical ? e.idealY[i] : e.idealX[i];
+			double across = line.vertical ? e.idealX[i] + ex[i] : e.idealY[i] + ey[i];
+			sa += along;
+			sc += across;
+			saa += along * along;
+			sac += along * across;
+			m++;
+		}
+		if (m < 3)
+			continue;
+
+		double det = m * saa - sa * sa;
+		double slope = det != 0 ? (m * sac - sa * sc) / det : 0;
+		double intercept = (sc - slope * sa) / m;
+		double perpendicular = 1 / (1 + slope * slope);
+		for (int i : line.samples) {
+			if (std::isnan(ex[i]))
+				continue;
+			double along = line.vertical ? e.idealY[i] : e.idealX[i];
+			double across = line.vertical ? e.idealX[i] + ex[i] : e.idealY[i] + ey[i];
+			double distance = across - (intercept + slope * along);
+			sumSq += distance * distance * perpendicular;
+			n++;
+		}
+	}
+
+	bendSumSq[eye][color] = sumSq;
+	bendCount[eye][color] = n;
+}
+
+void ResidualMetric::evaluateSeparation(int eye)
+{
+	const std::vector<double> &gx = errorX[eye][LENS_GREEN], &gy = errorY[eye][LENS_GREEN];
+	int others[2] = { LENS_RED, LENS_BLUE };
+
+	for (int s = 0; s < 2; s++) {
+		const std::vector<double> &cx = errorX[eye][others[s]], &cy = errorY[eye][others[s]];
+		double sumSq = 0;
+		int n = 0;
+		for (size_t i = 0; i < gx.size() && i < cx.size(); i++) {
+			double dx = cx[i] - gx[i], dy = cy[i] - gy[i];
+			if (std::isnan(dx) || std::isnan(dy))
+				continue;
+			sumSq += dx * dx + dy * dy;
+			n++;
+		}
+		separation[eye][s] = n ? sqrt(sumSq / n) : 0;
+	}
+}
+
+double ResidualMetric::bend(int eye) const
+{
+	double sumSq = 0;
+	int n = 0;
+	for (int color = 0; color < 3; color++) {
+		sumSq += bendSumSq[eye][color];
+		n += bendCount[eye][color];
+	}
+	return n ? sqrt(sumSq / n) : 0;
+}
+
+double ResidualMetric::bend(int eye, int color) const
+{
+	return bendCount[eye][color] ? sqrt(bendSumSq[eye][color] / bendCount[eye][color]) : 0;
+}
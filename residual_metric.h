@@ -0,0 +1,95 @@
+/** @file
+@brief Numeric figure of merit for line straightness and color fringing
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include "lens_model.h"
+#include "lens_solver.h"
+#include <vector>
+
+// Rather than judging "straight and white" by eye this compares what the
+// current model draws against a target: either a reference lens profile (a
+// config known to be right for the lens) or measured point correspondences.
+//
+// For every sample point the error e = drawn - target is how far off the
+// current model puts it. Seen through the lens the point lands (to first
+// order) at ideal + e, so:
+//    bend       = RMS distance of ideal + e from the best fit straight line
+//                 through each grid line
+//    separation = RMS of |e_red - e_green| and |e_blue - e_green|
+//
+// The errors are cached per eye/color and only the pairs invalidated since
+// the last update() are evaluated again, so it can run every frame.
+class ResidualMetric {
+public:
+	ResidualMetric();
+
+	// Sample grid lines every spacing pixels (sampled every step pixels along
+	// the line) over each eye and draw them with the target profile
+	void setTarget(const LensModel &target, int spacing = 40, int step = 8);
+
+	// Use measured points. Points sharing an ideal X (or Y) form a grid line.
+	void setTarget(const std::vector<PointCorrespondence> &points);
+
+	bool hasTarget() const { return targetLoaded; }
+	void clearTarget();
+
+	// Mark an eye/LensColor as changed
+	void invalidate(int eye, int color);
+	void invalidateAll();
+
+	// Evaluate whatever was invalidated using the centers of projection that
+	// are actually being drawn (cop[eye][x/y])
+	void update(const LensModel &model, const double cop[2][2]);
+
+	double bend(int eye) const;				// RMS over all colors, pixels
+	double bend(int eye, int color) const;	// Pixels
+	double redToGreen(int eye) const { return separation[eye][0]; }
+	double blueToGreen(int eye) const { return separation[eye][1]; }
+
+private:
+	struct Line {
+		bool vertical;
+		std::vector<int> samples;	// Sorted along the line
+	};
+
+	struct Eye {
+		std::vector<double> idealX, idealY;
+		std::vector<double> targetX[3], targetY[3];	// NaN where there's no target for a color
+		std::vector<Line> lines;
+	};
+
+	void evaluate(const LensModel &model, const double cop[2][2], int eye, int color);
+	void evaluateSeparation(int eye);
+
+	bool targetLoaded;
+	Eye eyes[2];
+	std::vector<double> errorX[2][3], errorY[2][3];
+	double bendSumSq[2][3];
+	int bendCount[2][3];
+	double separation[2][2];
+	bool dirty[2][3];
+};
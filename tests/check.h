@@ -0,0 +1,98 @@
+/** @file
+@brief Minimal checks for the offline tests
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "lens_model.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Each TEST registers itself and test_main.cpp runs them all. A failed CHECK
+// prints where it was and the test carries on so one run shows every failure.
+struct TestCase {
+	const char *name;
+	void (*run)();
+};
+
+std::vector<TestCase> &testCases();
+void testFailed(const char *file, int line, const char *what);
+
+struct TestRegistrar {
+	TestRegistrar(const char *name, void (*run)())
+	{
+		TestCase test = { name, run };
+		testCases().push_back(test);
+	}
+};
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) \
+			testFailed(__FILE__, __LINE__, #condition); \
+	} while (0)
+
+#define CHECK_NEAR(value, expected, tolerance) \
+	do { \
+		double checkValue = (value), checkExpected = (expected); \
+		if (!(fabs(checkValue - checkExpected) <= (tolerance))) { \
+			char checkMsg[512]; \
+			snprintf(checkMsg, sizeof(checkMsg), "%s = %.12g, expected %.12g within %g", #value, checkValue, checkExpected, (double)(tolerance)); \
+			testFailed(__FILE__, __LINE__, checkMsg); \
+		} \
+	} while (0)
+
+// A Vive sized panel with the aspect ratio and center most configs have, no
+// rotation and DPOLY3 coefficients a bit stronger for blue and red
+inline LensModel testLensModel()
+{
+	LensModel model;
+	memset(&model, 0, sizeof(model));
+	model.width = 2160;
+	model.height = 1200;
+	model.applyAspect = true;
+	model.applyExtrinsics = true;
+	for (int eye = 0; eye < 2; eye++) {
+		model.intrinsics[eye][0][0] = 1.2;
+		model.intrinsics[eye][1][1] = 1.08;
+		model.intrinsics[eye][0][2] = eye == 0 ? 0.03 : -0.03;
+		model.intrinsics[eye][1][2] = 0.01;
+		model.intrinsics[eye][2][2] = -1;
+		lensIdentityExtrinsics(model.extrinsics[eye]);
+		for (int color = 0; color < 3; color++) {
+			model.types[eye][color] = DISTORT_DPOLY3;
+			model.coeffs[eye][color][0] = 0.2 + 0.01 * color;
+			model.coeffs[eye][color][1] = 0.1;
+			model.coeffs[eye][color][2] = 0.02;
+		}
+	}
+	return model;
+}
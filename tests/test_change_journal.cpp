@@ -0,0 +1,143 @@
+/** @file
+@brief Checks of writing and replaying the change journal
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "check.h"
+#include "change_journal.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+	const char *journalFile = "change_journal_test.bin";
+
+	struct Record {
+		uint64_t index;
+		double value;
+	};
+
+	Record record(int index)
+	{
+		Record r = { (uint64_t)index, index * 0.5 };
+		return r;
+	}
+
+	std::string readBytes(const char *filename)
+	{
+		std::ifstream file(filename, std::ios::binary);
+		std::stringstream contents;
+		contents << file.rdbuf();
+		return contents.str();
+	}
+
+	void writeBytes(const char *filename, const std::string &bytes)
+	{
+		std::ofstream(filename, std::ios::binary | std::ios::trunc) << bytes;
+	}
+
+	// Newest intact record and how many there are
+	int replay(Record &last, size_t recordSize = sizeof(Record))
+	{
+		std::vector<char> bytes;
+		int count = ChangeJournal::read(journalFile, recordSize, bytes);
+		if (count > 0 && bytes.size() == sizeof(Record))
+			memcpy(&last, &bytes[0], sizeof(Record));
+		return count;
+	}
+
+	void writeJournal(int records)
+	{
+		ChangeJournal journal(1000);
+		QString error;
+		CHECK(journal.start(journalFile, sizeof(Record), error));
+		for (int i = 0; i < records; i++) {
+			Record r = record(i);
+			journal.append(&r);
+		}
+		// Not flushed, closing has to write everything out
+	}
+}
+
+TEST(journalReplaysEveryRecord)
+{
+	{
+		ChangeJournal journal(1000);
+		QString error;
+		CHECK(journal.start(journalFile, sizeof(Record), error));
+		CHECK(journal.active());
+		for (int i = 0; i < 3; i++) {
+			Record r = record(i);
+			journal.append(&r);
+		}
+		journal.flush();
+
+		Record last = record(-1);
+		CHECK(replay(last) == 3);
+		CHECK(last.index == 2 && last.value == 1.0);
+	}
+
+	writeJournal(5);
+	Record last = record(-1);
+	CHECK(replay(last) == 5);
+	CHECK(last.index == 4);
+
+	// Starting again replaces what was there
+	writeJournal(1);
+	CHECK(replay(last) == 1);
+	CHECK(last.index == 0);
+	remove(journalFile);
+}
+
+TEST(journalStopsAtTornOrCorruptRecord)
+{
+	writeJournal(5);
+	std::string bytes = readBytes(journalFile);
+
+	// A crash part way through writing the last record
+	writeBytes(journalFile, bytes.substr(0, bytes.size() - 3));
+	Record last = record(-1);
+	CHECK(replay(last) == 4);
+	CHECK(last.index == 3);
+
+	// One flipped bit in the middle of the third record fails its checksum
+	std::string corrupt = bytes;
+	size_t third = bytes.size() - 3 * (sizeof(Record) + 8) + 8 + 3;
+	corrupt[third] ^= 0x10;
+	writeBytes(journalFile, corrupt);
+	CHECK(replay(last) == 2);
+	CHECK(last.index == 1);
+	remove(journalFile);
+}
+
+TEST(journalIgnoresOtherRecordSizes)
+{
+	writeJournal(2);
+	Record last = record(-1);
+	CHECK(replay(last, sizeof(Record) + 8) == 0);
+	remove(journalFile);
+	CHECK(replay(last) == 0);
+}
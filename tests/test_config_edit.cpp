@@ -0,0 +1,224 @@
+/** @file
+@brief Checks of editing config files in place
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "check.h"
+#include "config_edit.h"
+#include "lens_config.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+	// Laid out by hand the way people leave them, so anything the patch
+	// touches besides the edited numbers shows up
+	std::string eyeText(const char *centerX, const char *intrinsicsX)
+	{
+		std::string text;
+		text += "\t{\r\n";
+		text += "\t\t\"distortion\" : { \"center_x\" : " + std::string(centerX) + ", \"center_y\" : 0.01,\r\n";
+		text += "\t\t\t\"coeffs\" : [ 0.2, 0.1,0.02, 0 ], \"type\" : \"DISTORT_DPOLY3\" },\r\n";
+		text += "\t\t\"distortion_blue\" : { \"coeffs\" : [ 2.1e-1, 0.1, 0.020 ] },\r\n";
+		text += "\t\t\"distortion_red\" : { \"coeffs\" : [ 0.22, 0.10, 0.02 ] },\r\n";
+		text += "\t\t\"extra\" : \"left alone\",\r\n";
+		text += "\t\t\"intrinsics\" : [ [ 1.2, 0.0, " + std::string(intrinsicsX) + " ], [ 0.0, 1.08, 0.01 ], [ 0.0, 0.0, -1.0 ] ]\r\n";
+		text += "\t}";
+		return text;
+	}
+
+	std::string configText()
+	{
+		return "{\r\n  \"device_serial_number\" : \"LHR-0000\",\r\n  \"tracking_to_eye_transform\" : [\r\n"
+			+ eyeText("0.03", "0.03") + ",\r\n" + eyeText("-0.03", "-0.030") + "\r\n  ]\r\n}\r\n";
+	}
+
+	bool readModel(const std::string &text, LensModel &model)
+	{
+		std::vector<char> buffer(text.begin(), text.end());
+		buffer.push_back(0);
+		rapidjson::Document json;
+		std::string error;
+		memset(&model, 0, sizeof(model));
+		bool ok = parseConfigBuffer(buffer, json, error) && readLensModel(json, model, error);
+		if (!ok)
+			printf("    %s\n", error.c_str());
+		model.width = 2160;
+		model.height = 1200;
+		model.applyAspect = model.applyExtrinsics = true;
+		return ok;
+	}
+
+	bool edit(const char *line, LensModel &model)
+	{
+		std::vector<ConfigEdit> edits(1);
+		std::string error;
+		return parseEdit(line, edits[0], error) && applyConfigEdits(edits, model, error);
+	}
+
+	// The bytes of a and b that differ, after the prefix and suffix they share
+	void difference(const std::string &a, const std::string &b, std::string &fromA, std::string &fromB)
+	{
+		size_t prefix = 0;
+		while (prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix])
+			prefix++;
+		size_t suffix = 0;
+		while (suffix < a.size() - prefix && suffix < b.size() - prefix && a[a.size() - 1 - suffix] == b[b.size() - 1 - suffix])
+			suffix++;
+		fromA = a.substr(prefix, a.size() - prefix - suffix);
+		fromB = b.substr(prefix, b.size() - prefix - suffix);
+	}
+}
+
+TEST(patchLeavesUnchangedConfigAlone)
+{
+	std::string text = configText();
+	LensModel model;
+	CHECK(readModel(text, model));
+
+	std::string patched, error;
+	int changed = -1;
+	CHECK(patchConfigText(text, model, model, patched, changed, error));
+	CHECK(changed == 0);
+	CHECK(patched == text);
+}
+
+TEST(patchRewritesOnlyEditedNumbers)
+{
+	std::string text = configText();
+	LensModel before, after;
+	CHECK(readModel(text, before));
+	after = before;
+	CHECK(edit("set right blue 1 0.25", after));
+
+	std::string patched, error, from, to;
+	int changed = 0;
+	CHECK(patchConfigText(text, before, after, patched, changed, error));
+	CHECK(changed == 1);
+	difference(text, patched, from, to);
+	CHECK(from == "2.1e-1");
+	CHECK(to == "0.25");
+
+	LensModel reread;
+	CHECK(readModel(patched, reread));
+	CHECK(reread.coeffs[1][LENS_BLUE][0] == 0.25);
+	CHECK(memcmp(reread.coeffs[0], before.coeffs[0], sizeof(before.coeffs[0])) == 0);
+}
+
+TEST(centerEditMovesRightEyeByPixels)
+{
+	std::string text = configText();
+	LensModel before, after;
+	CHECK(readModel(text, before));
+	after = before;
+	CHECK(edit("center right 10 -4", after));
+
+	double beforeX, beforeY, afterX, afterY;
+	lensCenterOfProjection(before, 1, beforeX, beforeY);
+	lensCenterOfProjection(after, 1, afterX, afterY);
+	CHECK_NEAR(afterX - beforeX, 10, 1e-9);
+	CHECK_NEAR(afterY - beforeY, -4, 1e-9);
+	double leftBeforeX, leftBeforeY, leftAfterX, leftAfterY;
+	lensCenterOfProjection(before, 0, leftBeforeX, leftBeforeY);
+	lensCenterOfProjection(after, 0, leftAfterX, leftAfterY);
+	CHECK(leftAfterX == leftBeforeX && leftAfterY == leftBeforeY);
+
+	// The intrinsics and the center_x/center_y of the right eye are all
+	// that change, and reading the file back gives the same center
+	std::string patched, error;
+	int changed = 0;
+	CHECK(patchConfigText(text, before, after, patched, changed, error));
+	CHECK(changed == 4);
+	LensModel reread;
+	CHECK(readModel(patched, reread));
+	lensCenterOfProjection(reread, 1, afterX, afterY);
+	CHECK_NEAR(afterX - beforeX, 10, 1e-9);
+	CHECK_NEAR(afterY - beforeY, -4, 1e-9);
+	size_t rightEye = text.find("-0.03");
+	CHECK(patched.compare(0, rightEye, text, 0, rightEye) == 0);
+}
+
+TEST(editConfigsWritesOnlyWhatChanged)
+{
+	const char *filename = "edit_config_test.json";
+	std::string text = configText();
+	std::ofstream(filename, std::ios::binary) << text;
+
+	std::vector<ConfigEdit> edits(1);
+	std::string error;
+	CHECK(parseEdit("scale left all 1 1", edits[0], error));
+	std::vector<ConfigEditResult> results = editConfigs(std::vector<std::string>(1, filename), edits, 2160, 1200, false);
+	CHECK(results.size() == 1 && results[0].ok && results[0].changed == 0);
+
+	// Out of range for SteamVR, the file is left as it was
+	CHECK(parseEdit("offset left red 1 2", edits[0], error));
+	results = editConfigs(std::vector<std::string>(1, filename), edits, 2160, 1200, false);
+	CHECK(results.size() == 1 && !results[0].ok);
+
+	std::ifstream file(filename, std::ios::binary);
+	std::stringstream contents;
+	contents << file.rdbuf();
+	CHECK(contents.str() == text);
+	file.close();
+	remove(filename);
+}
+
+TEST(saveAddsOnlyMembersTheModelNeeds)
+{
+	std::string text = configText();
+	std::vector<char> buffer(text.begin(), text.end());
+	buffer.push_back(0);
+	rapidjson::Document json;
+	std::string error;
+	LensModel model;
+	CHECK(parseConfigBuffer(buffer, json, error) && readLensModel(json, model, error));
+
+	ConfigHandles handles;
+	CHECK(handles.resolve(json, error));
+	handles.write(model);
+	const rapidjson::Value &left = json["tracking_to_eye_transform"][0];
+	CHECK(!left.HasMember("extrinsics"));
+	CHECK(!left["distortion_blue"].HasMember("type"));
+	CHECK(!left["distortion_blue"].HasMember("center_x"));
+	CHECK(left["distortion"]["coeffs"].Size() == 3);
+	CHECK(readConfigCenter(json, 0, 0) == 0.03 && readConfigCenter(json, 0, 1) == 0.01);
+
+	// A type other than the default and a rotated eye have to be written out
+	model.types[0][LENS_BLUE] = findDistortionType("DISTORT_DPOLY4");
+	model.coeffs[0][LENS_BLUE][3] = 0.005;
+	model.extrinsics[0][0][1] = 0.1;
+	handles.write(model);
+	CHECK(left.HasMember("extrinsics") && left["extrinsics"][0][1].GetDouble() == 0.1);
+	CHECK(std::string(left["distortion_blue"]["type"].GetString()) == "DISTORT_DPOLY4");
+	CHECK(left["distortion_blue"]["coeffs"].Size() == 4);
+	CHECK(!left["distortion_blue"].HasMember("center_x"));
+
+	LensModel reread;
+	CHECK(readLensModel(json, reread, error));
+	CHECK(memcmp(reread.coeffs, model.coeffs, sizeof(model.coeffs)) == 0);
+	CHECK(memcmp(reread.extrinsics, model.extrinsics, sizeof(model.extrinsics)) == 0);
+	CHECK(reread.types[0][LENS_BLUE] == model.types[0][LENS_BLUE] && reread.types[1][LENS_BLUE] == DISTORT_DPOLY3);
+}
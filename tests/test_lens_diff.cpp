@@ -0,0 +1,99 @@
+/** @file
+@brief Checks of comparing two lens models
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "check.h"
+#include "lens_diff.h"
+
+namespace {
+
+	int countInvalid(const DistortionDiff &diff, int color)
+	{
+		int invalid = 0;
+		for (float value : diff.displacement[color])
+			if (std::isnan(value))
+				invalid++;
+		return invalid;
+	}
+}
+
+TEST(diffOfTheSameModelIsZero)
+{
+	LensModel model = testLensModel();
+	DistortionDiff diff;
+	diffLensModels(model, model, diff, 4);
+	CHECK(diff.step == 4);
+	for (int color = 0; color < 3; color++) {
+		CHECK(diff.displacement[color].size() == (size_t)diff.columns * diff.rows);
+		CHECK(diff.stats[0][color].samples + diff.stats[1][color].samples == diff.columns * diff.rows);
+		for (int eye = 0; eye < 2; eye++) {
+			CHECK(diff.stats[eye][color].invalid == 0);
+			CHECK(diff.stats[eye][color].maxError == 0);
+			CHECK(diff.stats[eye][color].rmsError == 0);
+		}
+	}
+}
+
+TEST(diffOfCenterShiftMatchesAspect)
+{
+	// Without coefficients a point is drawn at cop + aspect * (x - cop), so
+	// moving the center moves every point by (1 - aspect) times as much
+	LensModel before = testLensModel();
+	for (int color = 0; color < 3; color++)
+		for (int i = 0; i < 3; i++)
+			before.coeffs[0][color][i] = 0;
+	LensModel after = before;
+	after.intrinsics[0][0][2] += 0.02;
+	double shift = 0.02 * (before.width / 4) * (1 - before.intrinsics[0][0][0]);
+
+	DistortionDiff diff;
+	diffLensModels(before, after, diff, 3);
+	for (int color = 0; color < 3; color++) {
+		const DisplacementStats &stats = diff.stats[0][color];
+		CHECK_NEAR(stats.maxError, fabs(shift), 1e-9);
+		CHECK_NEAR(stats.p99, fabs(shift), 1e-3);
+		CHECK_NEAR(stats.rmsError, fabs(shift), 1e-9);
+		CHECK(diff.stats[1][color].maxError == 0);
+	}
+}
+
+TEST(diffLeavesFoldedSamplesOut)
+{
+	LensModel before = testLensModel();
+	LensModel after = before;
+	after.coeffs[1][LENS_BLUE][0] = 0.5;
+	after.coeffs[1][LENS_BLUE][1] = 0.5;
+	after.coeffs[1][LENS_BLUE][2] = 0;
+
+	DistortionDiff diff;
+	diffLensModels(before, after, diff, 4);
+	const DisplacementStats &stats = diff.stats[1][LENS_BLUE];
+	CHECK(stats.invalid > 0 && stats.invalid < stats.samples);
+	CHECK(countInvalid(diff, LENS_BLUE) == stats.invalid);
+	CHECK(std::isfinite(stats.maxError) && stats.maxError > 0);
+	CHECK(stats.p99 <= stats.maxError);
+	CHECK(diff.stats[0][LENS_BLUE].invalid == 0 && diff.stats[0][LENS_BLUE].maxError == 0);
+	CHECK(countInvalid(diff, LENS_GREEN) == 0);
+}
@@ -0,0 +1,96 @@
+/** @file
+@brief Checks of where the radial model folds over
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "check.h"
+
+namespace {
+
+	LensModel withCoefficients(double k1, double k2, double k3)
+	{
+		LensModel model = testLensModel();
+		model.coeffs[1][LENS_BLUE][0] = k1;
+		model.coeffs[1][LENS_BLUE][1] = k2;
+		model.coeffs[1][LENS_BLUE][2] = k3;
+		return model;
+	}
+
+	// Positive root of a*q^2 + b*q + c, a != 0
+	double quadraticRoot(double a, double b, double c)
+	{
+		return (-b + sqrt(b * b - 4 * a * c)) / (2 * a);
+	}
+
+	double drawnRadius(const LensModel &model, double r)
+	{
+		return r * lensRadialScale(model.coeffs[1][LENS_BLUE], lensMaxRadius(model.width, model.height), r * r);
+	}
+}
+
+TEST(foldRadiusNegativeWithoutFold)
+{
+	LensModel model = testLensModel();
+	for (int eye = 0; eye < 2; eye++)
+		for (int color = 0; color < 3; color++)
+			CHECK(lensFoldRadius(model, eye, color) < 0);
+
+	// Pulls in hard but 1 + k1*q stays positive out to the corner
+	CHECK(lensFoldRadius(withCoefficients(-0.99, 0, 0), 1, LENS_BLUE) < 0);
+}
+
+TEST(foldRadiusFindsPole)
+{
+	// 1 - 0.9q - 0.5q^2 reaches 0 inside the panel, the drawn radius
+	// keeps growing up to there
+	LensModel model = withCoefficients(-0.9, -0.5, 0);
+	double maxRadius = lensMaxRadius(model.width, model.height);
+	double expected = sqrt(quadraticRoot(0.5, 0.9, -1)) * maxRadius;
+	CHECK_NEAR(lensFoldRadius(model, 1, LENS_BLUE), expected, 1e-6);
+	CHECK_NEAR(expected, 711.2, 0.1);
+
+	// Other eyes/colors aren't affected
+	CHECK(lensFoldRadius(model, 0, LENS_BLUE) < 0);
+	CHECK(lensFoldRadius(model, 1, LENS_GREEN) < 0);
+}
+
+TEST(foldRadiusFindsWhereDrawnRadiusStopsGrowing)
+{
+	// 1 + 0.5q + 0.5q^2 stays positive but r / P(q) peaks where
+	// 1 - 0.5q - 1.5q^2 = 0, at q = 2/3
+	LensModel model = withCoefficients(0.5, 0.5, 0);
+	double maxRadius = lensMaxRadius(model.width, model.height);
+	double fold = lensFoldRadius(model, 1, LENS_BLUE);
+	CHECK_NEAR(fold, sqrt(2.0 / 3) * maxRadius, 1e-6);
+	CHECK(drawnRadius(model, fold - 1) < drawnRadius(model, fold));
+	CHECK(drawnRadius(model, fold + 1) < drawnRadius(model, fold));
+}
+
+TEST(foldRadiusUsesEveryTerm)
+{
+	// 1 + 1.2q^3 never reaches 0, r / P(q) peaks where 1 - 6q^3 = 0
+	LensModel model = withCoefficients(0, 0, 1.2);
+	double maxRadius = lensMaxRadius(model.width, model.height);
+	CHECK_NEAR(lensFoldRadius(model, 1, LENS_BLUE), sqrt(cbrt(1 / 6.0)) * maxRadius, 1e-6);
+}
@@ -0,0 +1,111 @@
+/** @file
+@brief Checks of undistorting panel points through the lens model
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "check.h"
+#include "lens_inverse.h"
+
+namespace {
+
+	LensInverse inverseFor(const LensModel &model, int eye, int color, LensEyeTransform &transform)
+	{
+		double copX, copY;
+		lensCenterOfProjection(model, eye, copX, copY);
+		transform = LensEyeTransform(model, eye, copX, copY);
+		return LensInverse(model, transform, eye, color);
+	}
+
+	// Distort a grid of ideal points over the eye and invert each one,
+	// returning the largest distance from the ideal point it started as
+	double roundTrip(const LensModel &model, int eye, int color, double maxError)
+	{
+		LensEyeTransform transform;
+		LensInverse inverse = inverseFor(model, eye, color, transform);
+		CHECK(inverse.valid());
+
+		double worst = 0;
+		int x0 = eye * model.width / 2;
+		for (int j = 0; j <= 10; j++) {
+			for (int i = 0; i <= 10; i++) {
+				double x = x0 + 100 + i * (model.width / 2 - 200) / 10.0;
+				double y = 100 + j * (model.height - 200) / 10.0;
+				double drawnX, drawnY;
+				lensDistortWith(model, transform, eye, color, x, y, drawnX, drawnY);
+
+				double idealX, idealY, error;
+				CHECK(inverse.invert(drawnX, drawnY, idealX, idealY, &error) == LENS_INVERSE_OK);
+				CHECK(error <= maxError);
+				worst = std::max(worst, sqrt((idealX - x) * (idealX - x) + (idealY - y) * (idealY - y)));
+			}
+		}
+		return worst;
+	}
+}
+
+TEST(inverseIsExactForRadialTypes)
+{
+	LensModel model = testLensModel();
+	for (int eye = 0; eye < 2; eye++)
+		for (int color = 0; color < 3; color++)
+			CHECK(roundTrip(model, eye, color, 1e-6) < 1e-5);
+}
+
+TEST(inverseConvergesForBrownConrady)
+{
+	LensModel model = testLensModel();
+	int type = findDistortionType("DISTORT_BROWN_CONRADY");
+	CHECK(type >= 0);
+	model.types[0][LENS_GREEN] = type;
+	model.coeffs[0][LENS_GREEN][3] = 0.01;
+	model.coeffs[0][LENS_GREEN][4] = -0.005;
+	CHECK(roundTrip(model, 0, LENS_GREEN, LENS_INVERSE_TOLERANCE) < 0.1);
+}
+
+TEST(inverseReportsPointsPastTheFold)
+{
+	// The drawn radius peaks at q = 2/3 (test_lens_fold.cpp) so nothing
+	// is drawn much past 420 pixels from the center
+	LensModel model = testLensModel();
+	model.coeffs[1][LENS_RED][0] = 0.5;
+	model.coeffs[1][LENS_RED][1] = 0.5;
+	model.coeffs[1][LENS_RED][2] = 0;
+	LensEyeTransform transform;
+	LensInverse inverse = inverseFor(model, 1, LENS_RED, transform);
+	double copX, copY;
+	lensCenterOfProjection(model, 1, copX, copY);
+
+	double drawn[6] = { copX + 10, copY + 10, copX + 500, copY, copX, copY - 580 };
+	double ideal[6];
+	uint8_t status[3];
+	LensInverseReport report = inverse.invertParallel(drawn, ideal, 3, status);
+	CHECK(report.points == 3);
+	CHECK(report.converged == 1 && status[0] == LENS_INVERSE_OK);
+	CHECK(report.outside + report.notConverged == 2);
+	CHECK(status[1] != LENS_INVERSE_OK && status[2] != LENS_INVERSE_OK);
+	CHECK(std::isnan(ideal[2]) && std::isnan(ideal[5]));
+
+	double idealX, idealY;
+	CHECK(inverse.invert(copX + 500, copY, idealX, idealY) == LENS_INVERSE_OUTSIDE);
+}
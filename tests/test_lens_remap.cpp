@@ -0,0 +1,118 @@
+/** @file
+@brief Checks of the remap tables against the forward lens model
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "check.h"
+#include "lens_remap.h"
+
+namespace {
+
+	void centersOfProjection(const LensModel &model, double cop[2][2])
+	{
+		for (int eye = 0; eye < 2; eye++)
+			lensCenterOfProjection(model, eye, cop[eye][0], cop[eye][1]);
+	}
+
+	// Largest distance between a panel pixel and where the model draws what
+	// the tables show there, every step pixels, worked out here rather than
+	// by LensRemap so the bound it reports is checked too
+	double sampledError(const LensRemap &remap, const LensModel &model, const double cop[2][2], int step)
+	{
+		double worst = 0;
+		for (int eye = 0; eye < 2; eye++) {
+			int x0 = eye * model.width / 2;
+			for (int color = 0; color < 3; color++) {
+				for (int y = 0; y < model.height; y += step) {
+					for (int x = x0; x < x0 + model.width / 2; x += step) {
+						float idealX, idealY;
+						if (!remap.lookup(eye, color, x, y, idealX, idealY))
+							continue;
+						if (idealX < x0 || idealX > x0 + model.width / 2 - 1 || idealY < 0 || idealY > model.height - 1)
+							continue;
+						double drawnX, drawnY;
+						lensDistortAround(model, eye, color, cop[eye][0], cop[eye][1], idealX, idealY, drawnX, drawnY);
+						worst = std::max(worst, sqrt((drawnX - x) * (drawnX - x) + (drawnY - y) * (drawnY - y)));
+					}
+				}
+			}
+		}
+		return worst;
+	}
+
+	void checkStorage(RemapStorage storage, int subsample, double bound)
+	{
+		LensModel model = testLensModel();
+		double cop[2][2];
+		centersOfProjection(model, cop);
+
+		LensRemap remap(storage, subsample);
+		CHECK(remap.update(model, cop));
+		CHECK(remap.width() == model.width && remap.height() == model.height);
+		CHECK(remap.maxError() > 0);
+		CHECK_NEAR(remap.maxError(), 0, bound);
+		CHECK(sampledError(remap, model, cop, 7) <= remap.maxError() + 1e-6);
+
+		// Nothing changed so nothing is rebuilt
+		CHECK(!remap.update(model, cop));
+	}
+}
+
+TEST(remapFixedPointStaysWithinBound)
+{
+	checkStorage(REMAP_FIXED16, 1, 0.02);
+}
+
+TEST(remapFixedPointSubsampledStaysWithinBound)
+{
+	// The bilinear reconstruction between nodes is what costs most here
+	checkStorage(REMAP_FIXED16, 2, 0.5);
+}
+
+TEST(remapHalfFloatStaysWithinBound)
+{
+	checkStorage(REMAP_HALF, 1, 0.1);
+}
+
+TEST(remapRebuildsOnlyInvalidatedTables)
+{
+	LensModel model = testLensModel();
+	double cop[2][2];
+	centersOfProjection(model, cop);
+
+	LensRemap remap(REMAP_FIXED16, 2);
+	remap.update(model, cop);
+	float beforeX, beforeY;
+	CHECK(remap.lookup(1, LENS_RED, 1700, 300, beforeX, beforeY));
+
+	model.coeffs[1][LENS_RED][0] = 0.3;
+	CHECK(!remap.update(model, cop));
+	remap.invalidate(1, LENS_RED);
+	CHECK(remap.update(model, cop));
+
+	float afterX, afterY;
+	CHECK(remap.lookup(1, LENS_RED, 1700, 300, afterX, afterY));
+	CHECK(fabs(afterX - beforeX) > 1 || fabs(afterY - beforeY) > 1);
+	CHECK(sampledError(remap, model, cop, 11) <= remap.maxError() + 1e-6);
+}
@@ -0,0 +1,132 @@
+/** @file
+@brief Checks of the Levenberg-Marquardt fit
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "check.h"
+#include "lens_solver.h"
+
+namespace {
+
+	// Where every color of every eye draws a grid of ideal points
+	std::vector<PointCorrespondence> gridCorrespondences(const LensModel &model)
+	{
+		std::vector<PointCorrespondence> points;
+		for (int eye = 0; eye < 2; eye++) {
+			for (int color = 0; color < 3; color++) {
+				for (int j = 1; j < 12; j++) {
+					for (int i = 1; i < 12; i++) {
+						PointCorrespondence p;
+						p.eye = eye;
+						p.color = color;
+						p.idealX = eye * model.width / 2 + i * model.width / 24.0;
+						p.idealY = j * model.height / 12.0;
+						lensDistort(model, eye, color, p.idealX, p.idealY, p.observedX, p.observedY);
+						points.push_back(p);
+					}
+				}
+			}
+		}
+		return points;
+	}
+}
+
+TEST(choleskySolvesSymmetricSystem)
+{
+	// x = (1, -2, 3)
+	double A[9] = { 4, 2, 0.4, 2, 5, 1, 0.4, 1, 3 };
+	double b[3] = { 4 * 1 + 2 * -2 + 0.4 * 3, 2 * 1 + 5 * -2 + 1 * 3, 0.4 * 1 + 1 * -2 + 3 * 3 };
+	CHECK(choleskySolve(3, A, b));
+	CHECK_NEAR(b[0], 1, 1e-12);
+	CHECK_NEAR(b[1], -2, 1e-12);
+	CHECK_NEAR(b[2], 3, 1e-12);
+}
+
+TEST(choleskyRejectsIndefiniteSystem)
+{
+	double A[4] = { 1, 2, 2, 1 };
+	double b[2] = { 1, 1 };
+	CHECK(!choleskySolve(2, A, b));
+}
+
+TEST(solverRecoversCoefficientsCenterAndAspect)
+{
+	LensModel truth = testLensModel();
+	std::vector<PointCorrespondence> points = gridCorrespondences(truth);
+
+	LensModel model = truth;
+	for (int eye = 0; eye < 2; eye++) {
+		for (int color = 0; color < 3; color++)
+			for (int cof = 0; cof < 3; cof++)
+				model.coeffs[eye][color][cof] = 0;
+		model.intrinsics[eye][0][2] += 0.01;
+		model.intrinsics[eye][1][1] *= 1.02;
+	}
+
+	LensSolverReport report = solveLensModel(model, points);
+	for (int eye = 0; eye < 2; eye++) {
+		CHECK(report.points[eye] == (int)points.size() / 2);
+		CHECK(report.converged[eye]);
+		CHECK(report.rmsBefore[eye] > 1);
+		CHECK(report.rmsAfter[eye] < 1e-4);
+		for (int color = 0; color < 3; color++)
+			for (int cof = 0; cof < 3; cof++)
+				CHECK_NEAR(model.coeffs[eye][color][cof], truth.coeffs[eye][color][cof], 1e-4);
+		CHECK_NEAR(model.intrinsics[eye][0][2], truth.intrinsics[eye][0][2], 1e-6);
+		CHECK_NEAR(model.intrinsics[eye][1][1], truth.intrinsics[eye][1][1], 1e-6);
+	}
+}
+
+TEST(solverKeepsCoefficientsInSteamVRRange)
+{
+	// The best fit is past 1 so it has to stop at the limit
+	LensModel truth = testLensModel();
+	truth.coeffs[0][LENS_GREEN][0] = 1.4;
+	std::vector<PointCorrespondence> points = gridCorrespondences(truth);
+
+	LensModel model = testLensModel();
+	LensSolverOptions options;
+	options.fitCenter = false;
+	options.fitAspect = false;
+	solveLensModel(model, points, options);
+	for (int color = 0; color < 3; color++)
+		for (int cof = 0; cof < LENS_MAX_TERMS; cof++)
+			CHECK(fabs(model.coeffs[0][color][cof]) <= 1);
+	CHECK_NEAR(model.coeffs[0][LENS_GREEN][0], 1, 1e-9);
+}
+
+TEST(solverLeavesEyesWithoutPointsAlone)
+{
+	LensModel truth = testLensModel();
+	std::vector<PointCorrespondence> points;
+	for (const PointCorrespondence &p : gridCorrespondences(truth))
+		if (p.eye == 0)
+			points.push_back(p);
+
+	LensModel model = truth;
+	model.coeffs[1][LENS_RED][0] = 0.5;
+	LensSolverReport report = solveLensModel(model, points);
+	CHECK(report.points[1] == 0);
+	CHECK(model.coeffs[1][LENS_RED][0] == 0.5);
+}
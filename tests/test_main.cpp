@@ -0,0 +1,62 @@
+/** @file
+@brief Runs the offline tests
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "check.h"
+
+namespace {
+	int failures = 0;
+}
+
+std::vector<TestCase> &testCases()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+void testFailed(const char *file, int line, const char *what)
+{
+	printf("    FAILED %s:%d: %s\n", file, line, what);
+	failures++;
+}
+
+// With a name only that test runs
+int main(int argc, char **argv)
+{
+	int ran = 0, failed = 0;
+	for (const TestCase &test : testCases()) {
+		if (argc > 1 && strcmp(argv[1], test.name) != 0)
+			continue;
+		int before = failures;
+		printf("%s\n", test.name);
+		test.run();
+		ran++;
+		if (failures != before)
+			failed++;
+	}
+
+	printf("%d of %d tests passed\n", ran - failed, ran);
+	return failed == 0 && ran > 0 ? 0 : 1;
+}
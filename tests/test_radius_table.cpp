@@ -0,0 +1,106 @@
+/** @file
+@brief Checks of fitting coefficients to lens radius tables
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "check.h"
+#include "radius_table.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+	// Where the radial part of k draws each ideal radius, every 20 pixels
+	std::vector<RadiusSample> radiusTable(const double k[3], double maxRadius)
+	{
+		std::vector<RadiusSample> samples;
+		for (double r = 20; r <= maxRadius; r += 20) {
+			RadiusSample sample = { r, r * lensRadialScale(k, maxRadius, r * r) };
+			samples.push_back(sample);
+		}
+		return samples;
+	}
+
+	void writeTable(const std::string &filename, const std::vector<RadiusSample> &samples)
+	{
+		std::ofstream file(filename.c_str());
+		file.precision(17);
+		file << "ideal_radius,observed_radius\n";
+		for (const RadiusSample &sample : samples)
+			file << sample.ideal << "," << sample.observed << "\n";
+	}
+}
+
+TEST(radialFitIsExactOnModelRadii)
+{
+	LensModel model = testLensModel();
+	double maxRadius = lensMaxRadius(model.width, model.height);
+	const double k[3] = { 0.21, 0.09, 0.015 };
+
+	RadialFit fit;
+	CHECK(fitRadialCoefficients(radiusTable(k, maxRadius), maxRadius, fit, 3));
+	CHECK(fit.valid);
+	CHECK(fit.terms == 3);
+	for (int i = 0; i < 3; i++)
+		CHECK_NEAR(fit.coeffs[i], k[i], 1e-6);
+	CHECK(fit.maxResidual < 1e-6);
+}
+
+TEST(radialFitRefusesTooFewSamplesAndRange)
+{
+	LensModel model = testLensModel();
+	double maxRadius = lensMaxRadius(model.width, model.height);
+
+	RadialFit fit;
+	std::vector<RadiusSample> two(radiusTable(testLensModel().coeffs[0][0], maxRadius));
+	two.resize(2);
+	CHECK(!fitRadialCoefficients(two, maxRadius, fit, 3));
+	CHECK(!fit.valid);
+
+	// Drawn much further in than any coefficient SteamVR takes can manage
+	const double strong[3] = { 3, 0, 0 };
+	CHECK(!fitRadialCoefficients(radiusTable(strong, maxRadius), maxRadius, fit, 3));
+	CHECK(!fit.valid);
+}
+
+TEST(radiusTablesLoadPerEyeAndColor)
+{
+	LensModel model = testLensModel();
+	double maxRadius = lensMaxRadius(model.width, model.height);
+	const double k[3] = { 0.18, 0.12, 0.01 };
+	writeTable("left_green.csv", radiusTable(k, maxRadius));
+	std::ofstream("right_red.csv") << "ideal_radius,observed_radius\n10,9\nnot,a number\n";
+
+	RadialFit fits[2][3];
+	fitRadiusTables(".", model, fits);
+	CHECK(fits[0][LENS_GREEN].loaded && fits[0][LENS_GREEN].valid);
+	CHECK_NEAR(fits[0][LENS_GREEN].coeffs[1], k[1], 1e-6);
+	CHECK(fits[1][LENS_RED].loaded && !fits[1][LENS_RED].valid);
+	CHECK(fits[1][LENS_RED].error.find("right_red.csv:3") != std::string::npos);
+	CHECK(!fits[0][LENS_BLUE].loaded);
+
+	remove("left_green.csv");
+	remove("right_red.csv");
+}
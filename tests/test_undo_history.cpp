@@ -0,0 +1,136 @@
+/** @file
+@brief Checks of the undo/redo history
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "check.h"
+#include "undo_history.h"
+
+namespace {
+
+	struct Value {
+		int v;
+	};
+
+	Value value(int v)
+	{
+		Value state = { v };
+		return state;
+	}
+
+	// Undo everything there is and give back the values passed on the way
+	template <int Steps>
+	std::vector<int> undoAll(UndoHistory<Value, Steps> &history)
+	{
+		std::vector<int> seen;
+		Value state;
+		while (history.undo(state))
+			seen.push_back(state.v);
+		return seen;
+	}
+}
+
+TEST(undoMergesRunsWithTheSameTag)
+{
+	UndoHistory<Value, 8> history;
+	history.reset(value(0));
+	CHECK(history.record(value(1), 'W'));
+	CHECK(history.record(value(2), 'W'));
+	CHECK(history.record(value(3), 'W'));
+	CHECK(history.undoSteps() == 1);
+
+	// A different key (or none) starts a step of its own
+	CHECK(history.record(value(4), 'S'));
+	CHECK(history.record(value(5), 0));
+	CHECK(history.record(value(6), 0));
+	CHECK(history.undoSteps() == 4);
+
+	// Nothing changed
+	CHECK(!history.record(value(6), 'S'));
+	CHECK(history.undoSteps() == 4);
+}
+
+TEST(undoDropsRunsBackToTheirStart)
+{
+	UndoHistory<Value, 8> history;
+	history.reset(value(0));
+	history.record(value(1), 'A');
+	history.record(value(2), 'W');
+	CHECK(history.undoSteps() == 2);
+
+	// Tapping back to where the run started removes its step and the
+	// next change with the same key is new
+	CHECK(history.record(value(1), 'W'));
+	CHECK(history.undoSteps() == 1);
+	CHECK(!history.record(value(1), 'W'));
+	history.record(value(3), 'W');
+	CHECK(history.undoSteps() == 2);
+
+	std::vector<int> seen = undoAll(history);
+	CHECK(seen.size() == 2 && seen[0] == 1 && seen[1] == 0);
+}
+
+TEST(undoRedoAndNewChangesClearRedo)
+{
+	UndoHistory<Value, 8> history;
+	history.reset(value(0));
+	history.record(value(1), 0);
+	history.record(value(2), 0);
+
+	Value state;
+	CHECK(history.undo(state) && state.v == 1);
+	CHECK(history.redoSteps() == 1);
+	CHECK(history.redo(state) && state.v == 2);
+	CHECK(!history.redo(state));
+
+	CHECK(history.undo(state) && state.v == 1);
+	history.record(value(5), 0);
+	CHECK(history.redoSteps() == 0);
+	CHECK(!history.redo(state));
+
+	// Undo and redo end a run so the same key afterwards is a new step
+	history.record(value(6), 'W');
+	CHECK(history.undo(state) && state.v == 5);
+	CHECK(history.redo(state) && state.v == 6);
+	history.record(value(7), 'W');
+	CHECK(history.undoSteps() == 4);
+}
+
+TEST(undoRingDropsTheOldestStep)
+{
+	UndoHistory<Value, 4> history;
+	history.reset(value(0));
+	for (int i = 1; i <= 6; i++)
+		history.record(value(i), 0);
+	CHECK(history.undoSteps() == 3);
+
+	std::vector<int> seen = undoAll(history);
+	CHECK(seen.size() == 3 && seen[0] == 5 && seen[2] == 3);
+
+	// Changes made behind its back become their own step
+	history.sync(value(9));
+	CHECK(history.undoSteps() == 1);
+	history.sync(value(9));
+	CHECK(history.undoSteps() == 1);
+}
@@ -0,0 +1,138 @@
+/** @file
+@brief Fixed size undo/redo ring of state snapshots
+
+@date 2026/10/18
+
+@author
+Eric Wescott
+<wescotte@gmail.com>
+
+This is a modification of the OSVR-Distortionizer application found at:
+https://github.com/OSVR/distortionizer
+*/
+
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include <string.h>
+
+// Undo/redo over snapshots of some plain data state, kept in a ring of Steps
+// entries allocated up front. Recording, undoing and redoing are a single copy
+// of the state each, and once the ring is full the oldest step drops off.
+// States are compared with memcmp so they should be zeroed before being
+// filled in (no stray padding bytes).
+template <typename State, int Steps>
+class UndoHistory {
+public:
+	UndoHistory() : first(0), count(0), current(-1), lastTag(0) {}
+
+	// Start over with state as the only entry, after loading a config
+	void reset(const State &state)
+	{
+		first = 0;
+		count = 1;
+		current = 0;
+		lastTag = 0;
+		states[0] = state;
+	}
+
+	// Make sure the current entry is state. Anything that changed without
+	// going through record() (resizing, reloading) becomes a step of its own.
+	void sync(const State &state)
+	{
+		if (count == 0)
+			reset(state);
+		else if (!same(at(current), state))
+			push(state, 0);
+	}
+
+	// Record state after a change. A change with the same non-zero tag (the
+	// key) as the one just before it updates that entry instead, so holding
+	// a key down or tapping it a few times is one step. Returns false if the
+	// state didn't change.
+	bool record(const State &state, int tag)
+	{
+		if (count == 0) {
+			reset(state);
+			return false;
+		}
+		if (same(at(current), state)) {
+			// Another key ends the run even if it changed nothing
+			if (tag != lastTag)
+				lastTag = 0;
+			return false;
+		}
+
+		if (tag != 0 && tag == lastTag && current > 0) {
+			count = current + 1;
+			at(current) = state;
+			// The run ended up back where it started
+			if (same(at(current - 1), state)) {
+				count--;
+				current--;
+				lastTag = 0;
+			}
+			return true;
+		}
+
+		push(state, tag);
+		return true;
+	}
+
+	bool undo(State &state)
+	{
+		if (current <= 0)
+			return false;
+		state = at(--current);
+		lastTag = 0;
+		return true;
+	}
+
+	bool redo(State &state)
+	{
+		if (current + 1 >= count)
+			return false;
+		state = at(++current);
+		lastTag = 0;
+		return true;
+	}
+
+	int undoSteps() const { return current > 0 ? current : 0; }
+	int redoSteps() const { return count - 1 - current; }
+
+private:
+	State &at(int index) { return states[(first + index) % Steps]; }
+	static bool same(const State &a, const State &b) { return memcmp(&a, &b, sizeof(State)) == 0; }
+
+	void push(const State &state, int tag)
+	{
+		// Whatever was undone can't be redone after a new change
+		count = current + 1;
+		if (count == Steps) {
+			first = (first + 1) % Steps;
+			count--;
+			current--;
+		}
+		at(++current) = state;
+		count++;
+		lastTag = tag;
+	}
+
+	State states[Steps];
+	int first;			// Ring index of the oldest entry
+	int count;			// Entries in use
+	int current;		// Entry the widget shows, relative to first
+	int lastTag;		// Tag of the change that made the current entry, 0 if it can't be merged
+};